@@ -0,0 +1,406 @@
+#include "ZenSnapshotSyncTestServer.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include <Containers/Ticker.h>
+#include <HAL/PlatformProcess.h>
+#include <HAL/PlatformTime.h>
+#include <HttpPath.h>
+#include <HttpServerModule.h>
+#include <HttpServerResponse.h>
+#include <IHttpRouter.h>
+#include <Misc/ScopeLock.h>
+#include <Serialization/CompactBinaryValidation.h>
+#include <Serialization/CompactBinaryWriter.h>
+
+namespace ZenSnapshotSyncTestServer
+{
+	static constexpr uint32 FirstPort = 58460;
+	static constexpr uint32 NumPorts = 16;
+
+	static const TCHAR* CompactBinaryContentType = TEXT("application/x-ue-cb");
+
+	static TArray<uint8> SaveObject(FCbWriter& Writer)
+	{
+		TArray<uint8> Bytes;
+		Bytes.SetNumUninitialized(static_cast<int32>(Writer.GetSaveSize()));
+		Writer.Save(MakeMemoryView(Bytes));
+		return Bytes;
+	}
+
+	static FCbObjectView LoadObject(const TArray<uint8>& Bytes)
+	{
+		if (Bytes.IsEmpty() || ValidateCompactBinary(MakeMemoryView(Bytes), ECbValidateMode::Default) != ECbValidateError::None)
+		{
+			return FCbObjectView();
+		}
+
+		return FCbObjectView(Bytes.GetData());
+	}
+}
+
+FZenSnapshotSyncTestServer::FZenSnapshotSyncTestServer()
+{
+	using namespace ZenSnapshotSyncTestServer;
+
+	FHttpServerModule& HttpServerModule = FHttpServerModule::Get();
+
+	// Another editor on the same machine may run the tests as well
+	for (uint32 Port = FirstPort; Port < FirstPort + NumPorts && !Router.IsValid(); ++Port)
+	{
+		Router = HttpServerModule.GetHttpRouter(Port, true);
+		if (Router.IsValid())
+		{
+			Url = FString::Printf(TEXT("http://localhost:%u"), Port);
+		}
+	}
+
+	if (!Router.IsValid())
+	{
+		return;
+	}
+
+	const EHttpServerRequestVerbs Verbs = EHttpServerRequestVerbs::VERB_GET | EHttpServerRequestVerbs::VERB_POST | EHttpServerRequestVerbs::VERB_DELETE;
+	for (const TCHAR* Route : { TEXT("/health"), TEXT("/prj"), TEXT("/admin/jobs") })
+	{
+		RouteHandles.Add(Router->BindRoute(FHttpPath(Route), Verbs, FHttpRequestHandler::CreateRaw(this, &FZenSnapshotSyncTestServer::HandleRequest, FString(Route))));
+	}
+
+	HttpServerModule.StartAllListeners();
+}
+
+FZenSnapshotSyncTestServer::~FZenSnapshotSyncTestServer()
+{
+	// Listeners are shared with other users of the HTTP server module, only the routes are removed
+	for (const FHttpRouteHandle& RouteHandle : RouteHandles)
+	{
+		Router->UnbindRoute(RouteHandle);
+	}
+}
+
+bool FZenSnapshotSyncTestServer::IsRunning() const
+{
+	return Router.IsValid();
+}
+
+const FString& FZenSnapshotSyncTestServer::GetUrl() const
+{
+	return Url;
+}
+
+void FZenSnapshotSyncTestServer::FailRequests(EHttpServerRequestVerbs Verbs, FStringView PathPrefix, int32 ResponseCode, int32 NumRequests)
+{
+	FScopeLock ScopeLock(&Lock);
+	Failures.Add({ Verbs, FString(PathPrefix), ResponseCode, NumRequests });
+}
+
+void FZenSnapshotSyncTestServer::ClearFailures()
+{
+	FScopeLock ScopeLock(&Lock);
+	Failures.Reset();
+}
+
+void FZenSnapshotSyncTestServer::SetLatency(double Seconds)
+{
+	FScopeLock ScopeLock(&Lock);
+	Latency = Seconds;
+}
+
+void FZenSnapshotSyncTestServer::SetJobDuration(double Seconds)
+{
+	FScopeLock ScopeLock(&Lock);
+	JobDuration = Seconds;
+}
+
+int32 FZenSnapshotSyncTestServer::GetNumRequests(EHttpServerRequestVerbs Verbs, FStringView PathPrefix) const
+{
+	FScopeLock ScopeLock(&Lock);
+
+	int32 NumRequests = 0;
+	for (const TPair<EHttpServerRequestVerbs, FString>& Request : Requests)
+	{
+		if (EnumHasAnyFlags(Verbs, Request.Key) && Request.Value.StartsWith(PathPrefix))
+		{
+			++NumRequests;
+		}
+	}
+
+	return NumRequests;
+}
+
+void FZenSnapshotSyncTestServer::SetJob(const FString& JobId, const FJob& Job)
+{
+	FScopeLock ScopeLock(&Lock);
+	Jobs.Add(JobId, Job);
+}
+
+bool FZenSnapshotSyncTestServer::GetJob(const FString& JobId, FJob& OutJob) const
+{
+	FScopeLock ScopeLock(&Lock);
+
+	const FJob* Job = Jobs.Find(JobId);
+	if (!Job)
+	{
+		return false;
+	}
+
+	OutJob = *Job;
+	return true;
+}
+
+void FZenSnapshotSyncTestServer::RemoveJob(const FString& JobId)
+{
+	FScopeLock ScopeLock(&Lock);
+	Jobs.Remove(JobId);
+}
+
+FString FZenSnapshotSyncTestServer::GetLastJobId() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return FString::Printf(TEXT("job-%d"), NextJobIndex - 1);
+}
+
+bool FZenSnapshotSyncTestServer::HasOplog(FStringView OplogId) const
+{
+	FScopeLock ScopeLock(&Lock);
+	return Oplogs.Contains(FString(OplogId));
+}
+
+FCbObject FZenSnapshotSyncTestServer::GetLastImportParams() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return LastImportParams;
+}
+
+bool FZenSnapshotSyncTestServer::WaitUntil(TFunctionRef<bool()> Predicate, double Timeout)
+{
+	check(!IsInGameThread());
+
+	const double EndTime = FPlatformTime::Seconds() + Timeout;
+	while (!Predicate())
+	{
+		if (FPlatformTime::Seconds() >= EndTime)
+		{
+			return false;
+		}
+
+		FPlatformProcess::Sleep(0.01f);
+	}
+
+	return true;
+}
+
+bool FZenSnapshotSyncTestServer::HandleRequest(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete, FString Route)
+{
+	TArray<FString> Segments;
+	Request.RelativePath.GetPath().ParseIntoArray(Segments, TEXT("/"));
+
+	const FString Path = Segments.IsEmpty() ? Route : Route + TEXT('/') + FString::Join(Segments, TEXT("/"));
+
+	int32 ResponseCode = 404;
+	TArray<uint8> Body;
+	FString ContentType = TEXT("text/plain");
+	double Delay = 0.0;
+	{
+		FScopeLock ScopeLock(&Lock);
+
+		Delay = Latency;
+
+		Requests.Emplace(Request.Verb, Path);
+
+		FFailure* Failure = Failures.FindByPredicate([&Request, &Path](const FFailure& Candidate)
+		{
+			return EnumHasAnyFlags(Candidate.Verbs, Request.Verb) && Path.StartsWith(Candidate.PathPrefix);
+		});
+
+		if (Failure)
+		{
+			ResponseCode = Failure->ResponseCode;
+			if (--Failure->NumRequests == 0)
+			{
+				Failures.RemoveAll([](const FFailure& Candidate) { return Candidate.NumRequests == 0; });
+			}
+		}
+		else if (Route == TEXT("/health"))
+		{
+			ResponseCode = 200;
+		}
+		else if (Route == TEXT("/prj"))
+		{
+			ResponseCode = ServeProject(Request, Segments, Body, ContentType);
+		}
+		else
+		{
+			ResponseCode = ServeJob(Request, Segments, Body, ContentType);
+		}
+	}
+
+	TUniquePtr<FHttpServerResponse> Response = MakeUnique<FHttpServerResponse>();
+	Response->Code = static_cast<EHttpServerResponseCodes>(ResponseCode);
+	Response->Headers.Add(TEXT("content-type"), { ContentType });
+	Response->Body = MoveTemp(Body);
+
+	if (Delay <= 0.0)
+	{
+		OnComplete(MoveTemp(Response));
+		return true;
+	}
+
+	TSharedRef<TUniquePtr<FHttpServerResponse>> DelayedResponse = MakeShared<TUniquePtr<FHttpServerResponse>>(MoveTemp(Response));
+	FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([OnComplete, DelayedResponse](float DeltaTime)
+	{
+		OnComplete(MoveTemp(*DelayedResponse));
+		return false;
+	}), static_cast<float>(Delay));
+
+	return true;
+}
+
+int32 FZenSnapshotSyncTestServer::ServeProject(const FHttpServerRequest& Request, TConstArrayView<FString> Segments, TArray<uint8>& OutBody, FString& OutContentType)
+{
+	using namespace ZenSnapshotSyncTestServer;
+
+	if (Segments.Num() == 1)
+	{
+		if (Request.Verb == EHttpServerRequestVerbs::VERB_POST)
+		{
+			Projects.Add(Segments[0]);
+			return 201;
+		}
+
+		if (!Projects.Contains(Segments[0]))
+		{
+			return 404;
+		}
+
+		FCbWriter Writer;
+		Writer.BeginObject();
+		Writer.AddString("id", Segments[0]);
+		Writer.EndObject();
+
+		OutBody = SaveObject(Writer);
+		OutContentType = CompactBinaryContentType;
+		return 200;
+	}
+
+	if (Segments.Num() < 3 || Segments[1] != TEXT("oplog") || !Projects.Contains(Segments[0]))
+	{
+		return 404;
+	}
+
+	const FString& OplogId = Segments[2];
+
+	if (Segments.Num() == 3)
+	{
+		if (Request.Verb == EHttpServerRequestVerbs::VERB_POST)
+		{
+			Oplogs.Add(OplogId);
+			return 201;
+		}
+
+		if (Request.Verb == EHttpServerRequestVerbs::VERB_DELETE)
+		{
+			return Oplogs.Remove(OplogId) > 0 ? 200 : 404;
+		}
+
+		if (!Oplogs.Contains(OplogId))
+		{
+			return 404;
+		}
+
+		FCbWriter Writer;
+		Writer.BeginObject();
+		Writer.AddString("id", OplogId);
+		Writer.EndObject();
+
+		OutBody = SaveObject(Writer);
+		OutContentType = CompactBinaryContentType;
+		return 200;
+	}
+
+	if (!Oplogs.Contains(OplogId))
+	{
+		return 404;
+	}
+
+	// Validation finds nothing missing, chunks and op listings are not served so verification reports the import as unverified
+	if (Segments[3] == TEXT("validate"))
+	{
+		FCbWriter Writer;
+		Writer.BeginObject();
+		Writer.EndObject();
+
+		OutBody = SaveObject(Writer);
+		OutContentType = CompactBinaryContentType;
+		return 200;
+	}
+
+	if (Segments[3] != TEXT("rpc"))
+	{
+		return 404;
+	}
+
+	const FCbObjectView Payload = LoadObject(Request.Body);
+	if (Payload["method"].AsString() != "import")
+	{
+		return 400;
+	}
+
+	LastImportParams = FCbObject::Clone(Payload["params"].AsObjectView());
+
+	const FString JobId = FString::Printf(TEXT("job-%d"), NextJobIndex++);
+	Jobs.Add(JobId, FJob()).StartTime = FPlatformTime::Seconds();
+
+	const FTCHARToUTF8 JobIdUtf8(*JobId);
+	OutBody.Append(reinterpret_cast<const uint8*>(JobIdUtf8.Get()), JobIdUtf8.Length());
+	return 202;
+}
+
+int32 FZenSnapshotSyncTestServer::ServeJob(const FHttpServerRequest& Request, TConstArrayView<FString> Segments, TArray<uint8>& OutBody, FString& OutContentType)
+{
+	using namespace ZenSnapshotSyncTestServer;
+
+	FJob* Job = Segments.Num() == 1 ? Jobs.Find(Segments[0]) : nullptr;
+	if (!Job)
+	{
+		return 404;
+	}
+
+	// Cancelled jobs stop right away and report as complete
+	if (Request.Verb == EHttpServerRequestVerbs::VERB_DELETE)
+	{
+		Job->Status = TEXT("Complete");
+		Job->bCancelled = true;
+		return 200;
+	}
+
+	if (JobDuration > 0.0 && Job->StartTime > 0.0 && Job->Status == TEXT("Running"))
+	{
+		const double Fraction = (FPlatformTime::Seconds() - Job->StartTime) / JobDuration;
+		if (Fraction >= 1.0)
+		{
+			Job->Status = TEXT("Complete");
+		}
+		else
+		{
+			Job->CurrentOp = TEXT("Fetching");
+			Job->PercentComplete = static_cast<uint32>(Fraction * 100.0);
+		}
+	}
+
+	FCbWriter Writer;
+	Writer.BeginObject();
+	Writer.AddString("Status", Job->Status);
+	Writer.AddString("CurrentOp", Job->CurrentOp);
+	Writer.AddInteger("CurrentOpPercentComplete", Job->PercentComplete);
+	Writer.AddString("AbortReason", Job->AbortReason);
+	Writer.BeginArray("Messages");
+	Writer.EndArray();
+	Writer.EndObject();
+
+	OutBody = SaveObject(Writer);
+	OutContentType = CompactBinaryContentType;
+	return 200;
+}
+
+#endif
@@ -0,0 +1,98 @@
+#pragma once
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include <Containers/Map.h>
+#include <Containers/Set.h>
+#include <HAL/CriticalSection.h>
+#include <HttpResultCallback.h>
+#include <HttpRouteHandle.h>
+#include <HttpServerRequest.h>
+#include <Serialization/CompactBinary.h>
+#include <Templates/Function.h>
+
+class IHttpRouter;
+
+// Stand-in for Zen server serving the requests of an import on game thread ticks, with scripted job statuses and failures
+class FZenSnapshotSyncTestServer
+{
+public:
+	struct FJob
+	{
+		FString Status = TEXT("Running");
+		FString CurrentOp;
+		uint32 PercentComplete = 0;
+		FString AbortReason;
+		bool bCancelled = false;
+
+		// Set for jobs created by import requests, those run on their own when a job duration is set
+		double StartTime = 0.0;
+	};
+
+	FZenSnapshotSyncTestServer();
+	~FZenSnapshotSyncTestServer();
+
+	FZenSnapshotSyncTestServer(const FZenSnapshotSyncTestServer&) = delete;
+	FZenSnapshotSyncTestServer& operator=(const FZenSnapshotSyncTestServer&) = delete;
+
+	// False if no port could be bound
+	bool IsRunning() const;
+	const FString& GetUrl() const;
+
+	// Answers the next NumRequests matching requests with ResponseCode instead of serving them
+	void FailRequests(EHttpServerRequestVerbs Verbs, FStringView PathPrefix, int32 ResponseCode, int32 NumRequests);
+	void ClearFailures();
+
+	// Delays every response, served from a later game thread tick so other requests are not held up
+	void SetLatency(double Seconds);
+
+	// Jobs created from now on report progress and complete by themselves after this long, 0 leaves them to the test
+	void SetJobDuration(double Seconds);
+
+	// Matching requests received so far, including failed ones
+	int32 GetNumRequests(EHttpServerRequestVerbs Verbs, FStringView PathPrefix) const;
+
+	// Jobs are created by import requests and run until a test changes them, removed jobs are answered with 404
+	void SetJob(const FString& JobId, const FJob& Job);
+	bool GetJob(const FString& JobId, FJob& OutJob) const;
+	void RemoveJob(const FString& JobId);
+	FString GetLastJobId() const;
+
+	bool HasOplog(FStringView OplogId) const;
+
+	// Params of the last import request
+	FCbObject GetLastImportParams() const;
+
+	// Blocks the calling thread until Predicate holds, must not be the game thread
+	static bool WaitUntil(TFunctionRef<bool()> Predicate, double Timeout = 10.0);
+
+private:
+	struct FFailure
+	{
+		EHttpServerRequestVerbs Verbs;
+		FString PathPrefix;
+		int32 ResponseCode;
+		int32 NumRequests;
+	};
+
+	bool HandleRequest(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete, FString Route);
+	int32 ServeProject(const FHttpServerRequest& Request, TConstArrayView<FString> Segments, TArray<uint8>& OutBody, FString& OutContentType);
+	int32 ServeJob(const FHttpServerRequest& Request, TConstArrayView<FString> Segments, TArray<uint8>& OutBody, FString& OutContentType);
+
+	TSharedPtr<IHttpRouter> Router;
+	TArray<FHttpRouteHandle> RouteHandles;
+	FString Url;
+
+	mutable FCriticalSection Lock;
+	TArray<FFailure> Failures;
+	TArray<TPair<EHttpServerRequestVerbs, FString>> Requests;
+	TSet<FString> Projects;
+	TSet<FString> Oplogs;
+	TMap<FString, FJob> Jobs;
+	FCbObject LastImportParams;
+	int32 NextJobIndex = 1;
+	double Latency = 0.0;
+	double JobDuration = 0.0;
+};
+
+#endif
@@ -0,0 +1,503 @@
+#include "ZenSnapshotSyncTestServer.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include <ZenServerHttp.h>
+#include <Async/Async.h>
+#include <HAL/FileManager.h>
+#include <HAL/PlatformProcess.h>
+#include <HAL/PlatformTime.h>
+#include <Misc/AutomationTest.h>
+#include <Misc/Paths.h>
+
+#include "ZenSnapshotSyncMetrics.h"
+#include "ZenSnapshotSyncModule.h"
+#include "ZenSnapshotSyncRequest.h"
+#include "ZenSnapshotSyncRetry.h"
+#include "ZenSnapshotSyncSettings.h"
+#include "ZenSnapshotSyncThrottler.h"
+
+namespace ZenSnapshotSyncTests
+{
+	static const TCHAR* TargetPlatform = TEXT("ZenSnapshotSyncTest");
+
+	// Runs imports unthrottled and unverified whatever the editor has configured, restored afterwards
+	class FScopedTestSettings
+	{
+	public:
+		FScopedTestSettings()
+			: ProjectSettings(*GetDefault<UZenSnapshotSyncProjectSettings>())
+			, UserSettings(*GetDefault<UZenSnapshotSyncSettings>())
+		{
+			UZenSnapshotSyncProjectSettings* MutableProjectSettings = GetMutableDefault<UZenSnapshotSyncProjectSettings>();
+			MutableProjectSettings->MaxConcurrentImportsPerHost = 0;
+			MutableProjectSettings->bCheckFreeSpace = false;
+			MutableProjectSettings->bVerifyImports = false;
+
+			UZenSnapshotSyncSettings* MutableUserSettings = GetMutableDefault<UZenSnapshotSyncSettings>();
+			MutableUserSettings->MaxResidentSnapshots = 1;
+			MutableUserSettings->bShareSnapshotsAcrossProjects = false;
+		}
+
+		~FScopedTestSettings()
+		{
+			UZenSnapshotSyncProjectSettings* MutableProjectSettings = GetMutableDefault<UZenSnapshotSyncProjectSettings>();
+			MutableProjectSettings->MaxConcurrentImportsPerHost = ProjectSettings.MaxConcurrentImportsPerHost;
+			MutableProjectSettings->bCheckFreeSpace = ProjectSettings.bCheckFreeSpace;
+			MutableProjectSettings->bVerifyImports = ProjectSettings.bVerifyImports;
+
+			UZenSnapshotSyncSettings* MutableUserSettings = GetMutableDefault<UZenSnapshotSyncSettings>();
+			MutableUserSettings->MaxResidentSnapshots = UserSettings.MaxResidentSnapshots;
+			MutableUserSettings->bShareSnapshotsAcrossProjects = UserSettings.bShareSnapshotsAcrossProjects;
+		}
+
+	private:
+		struct FProjectSettings
+		{
+			explicit FProjectSettings(const UZenSnapshotSyncProjectSettings& Settings)
+				: MaxConcurrentImportsPerHost(Settings.MaxConcurrentImportsPerHost)
+				, bCheckFreeSpace(Settings.bCheckFreeSpace)
+				, bVerifyImports(Settings.bVerifyImports)
+			{
+			}
+
+			int32 MaxConcurrentImportsPerHost;
+			bool bCheckFreeSpace;
+			bool bVerifyImports;
+		};
+
+		struct FUserSettings
+		{
+			explicit FUserSettings(const UZenSnapshotSyncSettings& Settings)
+				: MaxResidentSnapshots(Settings.MaxResidentSnapshots)
+				, bShareSnapshotsAcrossProjects(Settings.bShareSnapshotsAcrossProjects)
+			{
+			}
+
+			int32 MaxResidentSnapshots;
+			bool bShareSnapshotsAcrossProjects;
+		};
+
+		const FProjectSettings ProjectSettings;
+		const FUserSettings UserSettings;
+	};
+
+	// Scenarios block on requests the stub serves while the game thread ticks, so they run on the thread pool behind a latent command
+	static bool RunScenario(FAutomationTestBase& Test, TUniqueFunction<void(FZenSnapshotSyncTestServer&)>&& Scenario)
+	{
+		TSharedRef<FZenSnapshotSyncTestServer> Server = MakeShared<FZenSnapshotSyncTestServer>();
+		if (!Server->IsRunning())
+		{
+			Test.AddError(TEXT("Failed to bind a port for the Zen server stub"));
+			return false;
+		}
+
+		TSharedRef<FScopedTestSettings> Settings = MakeShared<FScopedTestSettings>();
+		TSharedFuture<void> Done = Async(EAsyncExecution::ThreadPool, [Server, Scenario = MoveTemp(Scenario)]() { Scenario(*Server); }).Share();
+
+		ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([Server, Settings, Done]() { return Done.IsReady(); }));
+		return true;
+	}
+
+	// Runs the scenario against a module instance of its own that keeps its state in a transient directory
+	static bool RunModuleScenario(FAutomationTestBase& Test, TUniqueFunction<void(FZenSnapshotSyncTestServer&, FZenSnapshotSyncModule&)>&& Scenario)
+	{
+		return RunScenario(Test, [Scenario = MoveTemp(Scenario)](FZenSnapshotSyncTestServer& Server)
+		{
+			const FString StateDirectory = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("ZenSnapshotSync"));
+			IFileManager::Get().DeleteDirectory(*StateDirectory, false, true);
+
+			FZenSnapshotSyncModule Module(Server.GetUrl(), StateDirectory);
+			Scenario(Server, Module);
+			Module.ShutdownModule();
+		});
+	}
+
+	static FZenSnapshotSyncHandle RequestImport(FZenSnapshotSyncModule& Module, const FString& OplogId, FStringView Platform = TargetPlatform)
+	{
+		FZenSnapshotSyncOptions Options;
+		Options.OplogId = OplogId;
+		Options.bActivate = false;
+
+		return Module.RequestSnapshotSyncFromFileAsync(Platform, FPaths::AutomationTransientDir(), TEXT("Snapshot.oplog"), Options).Get();
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FZenSnapshotSyncThrottlingTest, "ZenSnapshotSync.Throttling", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FZenSnapshotSyncThrottlingTest::RunTest(const FString& Parameters)
+{
+	const FString Host = TEXT("throttled.host");
+
+	FZenSnapshotSyncThrottler Throttler;
+	TMap<FString, bool> Outcomes;
+
+	auto Enqueue = [&Throttler, &Outcomes, &Host](const TCHAR* Name, EZenSnapshotSyncPriority Priority, bool bWaitForSlot)
+	{
+		Throttler.Enqueue(Host, 1, Priority, bWaitForSlot, [&Outcomes, Name = FString(Name)](bool bStarted) { Outcomes.Add(Name, bStarted); });
+	};
+
+	Enqueue(TEXT("First"), EZenSnapshotSyncPriority::Normal, true);
+	TestTrue(TEXT("Import under the limit starts right away"), Outcomes.FindRef(TEXT("First")));
+	Throttler.Assign(Host, TEXT("first"));
+
+	Enqueue(TEXT("Low"), EZenSnapshotSyncPriority::Low, true);
+	Enqueue(TEXT("High"), EZenSnapshotSyncPriority::High, true);
+	TestFalse(TEXT("Imports over the limit are queued"), Outcomes.Contains(TEXT("Low")) || Outcomes.Contains(TEXT("High")));
+
+	Enqueue(TEXT("Impatient"), EZenSnapshotSyncPriority::High, false);
+	TestTrue(TEXT("Import that may not wait is answered right away"), Outcomes.Contains(TEXT("Impatient")));
+	TestFalse(TEXT("Import that may not wait is rejected while the host is busy"), Outcomes.FindRef(TEXT("Impatient")));
+
+	TestTrue(TEXT("First caller finishes the job"), Throttler.Finish(TEXT("first"), true));
+	TestFalse(TEXT("Later callers do not finish it again"), Throttler.Finish(TEXT("first"), true));
+	TestTrue(TEXT("Higher priority import takes the freed slot"), Outcomes.FindRef(TEXT("High")));
+	TestFalse(TEXT("Lower priority import keeps waiting"), Outcomes.Contains(TEXT("Low")));
+	Throttler.Assign(Host, TEXT("high"));
+
+	Throttler.CancelQueued();
+	TestTrue(TEXT("Queued import is answered on cancel"), Outcomes.Contains(TEXT("Low")));
+	TestFalse(TEXT("Queued import is rejected on cancel"), Outcomes.FindRef(TEXT("Low")));
+
+	Throttler.Finish(TEXT("high"), true);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FZenSnapshotSyncRetryBudgetTest, "ZenSnapshotSync.RetryBudget", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FZenSnapshotSyncRetryBudgetTest::RunTest(const FString& Parameters)
+{
+	return ZenSnapshotSyncTests::RunScenario(*this, [this](FZenSnapshotSyncTestServer& Server)
+	{
+		using namespace UE::Zen;
+
+		FZenHttpRequestPool RequestPool(Server.GetUrl(), 1);
+
+		auto Perform = [&Server, &RequestPool](FZenSnapshotSyncRetry::EMode Mode)
+		{
+			const int32 NumRequests = Server.GetNumRequests(EHttpServerRequestVerbs::VERB_GET, TEXTVIEW("/health"));
+
+			FZenScopedRequestPtr Request(&RequestPool);
+			FZenSnapshotSyncRetry::Perform(*Request.Get(), Mode, [&Request]() { return Request->PerformBlockingDownload(TEXTVIEW("/health/"), nullptr, EContentType::Text); });
+
+			return Server.GetNumRequests(EHttpServerRequestVerbs::VERB_GET, TEXTVIEW("/health")) - NumRequests;
+		};
+
+		// Requests that must not run twice are not retried after a server error
+		Server.FailRequests(EHttpServerRequestVerbs::VERB_GET, TEXTVIEW("/health"), 500, 1);
+		TestEqual(TEXT("Attempts of a rejected mode request after a server error"), Perform(FZenSnapshotSyncRetry::EMode::Rejected), 1);
+
+		// Every failing request spends retries from the shared budget until only single attempts are left
+		Server.FailRequests(EHttpServerRequestVerbs::VERB_GET, TEXTVIEW("/health"), 503, MAX_int32);
+
+		int32 NumAttempts = 0;
+		for (int32 Index = 0; Index < 32; ++Index)
+		{
+			NumAttempts = Perform(FZenSnapshotSyncRetry::EMode::Idempotent);
+			if (NumAttempts == 1)
+			{
+				break;
+			}
+		}
+
+		TestEqual(TEXT("Attempts once the budget is spent"), NumAttempts, 1);
+		TestEqual(TEXT("Attempts of the next request"), Perform(FZenSnapshotSyncRetry::EMode::Idempotent), 1);
+
+		// Successful requests refill the budget by a fraction of a retry each
+		Server.ClearFailures();
+		for (int32 Index = 0; Index < 10; ++Index)
+		{
+			Perform(FZenSnapshotSyncRetry::EMode::Idempotent);
+		}
+
+		Server.FailRequests(EHttpServerRequestVerbs::VERB_GET, TEXTVIEW("/health"), 503, 1);
+		TestEqual(TEXT("Attempts after successful requests refilled the budget"), Perform(FZenSnapshotSyncRetry::EMode::Idempotent), 2);
+
+		// Leaves the budget full for whatever runs next in this editor
+		for (int32 Index = 0; Index < 100; ++Index)
+		{
+			Perform(FZenSnapshotSyncRetry::EMode::Idempotent);
+		}
+	});
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FZenSnapshotSyncPollTest, "ZenSnapshotSync.PollStatus", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FZenSnapshotSyncPollTest::RunTest(const FString& Parameters)
+{
+	return ZenSnapshotSyncTests::RunModuleScenario(*this, [this](FZenSnapshotSyncTestServer& Server, FZenSnapshotSyncModule& Module)
+	{
+		using namespace ZenSnapshotSyncTests;
+
+		FZenSnapshotSyncHandle Handle = RequestImport(Module, TEXT("zensnapshotsynctest.poll"));
+		if (!TestTrue(TEXT("Import was requested"), Handle.IsValid()))
+		{
+			return;
+		}
+
+		FZenSnapshotSyncTestServer::FJob Job;
+		Job.CurrentOp = TEXT("Fetching");
+		Job.PercentComplete = 40;
+		Server.SetJob(Server.GetLastJobId(), Job);
+
+		TestTrue(TEXT("Running job stays in progress"), Module.QuerySnapshotSyncStatus(Handle));
+		TestEqual(TEXT("State of a running job"), Handle.GetState(), FString(TEXT("Fetching")));
+		TestEqual(TEXT("Progress of a running job"), Handle.GetStateProgress(), 0.4f, KINDA_SMALL_NUMBER);
+
+		// A dropped poll says nothing about the job
+		Server.FailRequests(EHttpServerRequestVerbs::VERB_GET, TEXTVIEW("/admin/jobs/"), 503, 1);
+		TestTrue(TEXT("Job stays in progress after a dropped poll"), Module.QuerySnapshotSyncStatus(Handle));
+		TestFalse(TEXT("Dropped poll is not an error"), Handle.IsError());
+
+		Job.Status = TEXT("Complete");
+		Server.SetJob(Server.GetLastJobId(), Job);
+		TestFalse(TEXT("Completed job is no longer in progress"), Module.QuerySnapshotSyncStatus(Handle));
+		TestTrue(TEXT("Completed job completes the handle"), Handle.IsComplete());
+
+		FZenSnapshotSyncHandle AbortedHandle = RequestImport(Module, TEXT("zensnapshotsynctest.aborted"));
+		Job.Status = TEXT("Aborted");
+		Job.AbortReason = TEXT("Source went away");
+		Server.SetJob(Server.GetLastJobId(), Job);
+		TestFalse(TEXT("Aborted job is no longer in progress"), Module.QuerySnapshotSyncStatus(AbortedHandle));
+		TestEqual(TEXT("Aborted job reports its reason"), AbortedHandle.GetErrorMessage(), Job.AbortReason);
+
+		// Zen server forgets its jobs when restarted
+		FZenSnapshotSyncHandle ForgottenHandle = RequestImport(Module, TEXT("zensnapshotsynctest.forgotten"));
+		Server.RemoveJob(Server.GetLastJobId());
+		TestFalse(TEXT("Forgotten job is no longer in progress"), Module.QuerySnapshotSyncStatus(ForgottenHandle));
+		TestTrue(TEXT("Forgotten job fails the handle"), ForgottenHandle.IsError());
+	});
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FZenSnapshotSyncBatchedPollTest, "ZenSnapshotSync.PollStatuses", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FZenSnapshotSyncBatchedPollTest::RunTest(const FString& Parameters)
+{
+	return ZenSnapshotSyncTests::RunModuleScenario(*this, [this](FZenSnapshotSyncTestServer& Server, FZenSnapshotSyncModule& Module)
+	{
+		using namespace ZenSnapshotSyncTests;
+
+		static constexpr int32 NumRunning = 6;
+
+		TArray<FZenSnapshotSyncHandle> Handles;
+		TArray<FString> JobIds;
+		for (int32 Index = 0; Index < NumRunning + 3; ++Index)
+		{
+			FZenSnapshotSyncHandle& Handle = Handles.Add_GetRef(RequestImport(Module, FString::Printf(TEXT("zensnapshotsynctest.batch%d"), Index)));
+			if (!TestTrue(TEXT("Import was requested"), Handle.IsValid()))
+			{
+				return;
+			}
+
+			FZenSnapshotSyncTestServer::FJob Job;
+			Job.CurrentOp = TEXT("Fetching");
+			Job.PercentComplete = Index * 10;
+			Server.SetJob(JobIds.Add_GetRef(Server.GetLastJobId()), Job);
+		}
+
+		// The last three jobs complete, abort and are forgotten, every other one keeps running
+		FZenSnapshotSyncTestServer::FJob CompletedJob;
+		CompletedJob.Status = TEXT("Complete");
+		Server.SetJob(JobIds[NumRunning], CompletedJob);
+
+		FZenSnapshotSyncTestServer::FJob AbortedJob;
+		AbortedJob.Status = TEXT("Aborted");
+		AbortedJob.AbortReason = TEXT("Source went away");
+		Server.SetJob(JobIds[NumRunning + 1], AbortedJob);
+
+		Server.RemoveJob(JobIds[NumRunning + 2]);
+
+		const int32 NumPolls = Server.GetNumRequests(EHttpServerRequestVerbs::VERB_GET, TEXTVIEW("/admin/jobs/"));
+		TestEqual(TEXT("Handles still in progress"), Module.QuerySnapshotSyncStatuses(Handles), NumRunning);
+		TestEqual(TEXT("Polls of the first query"), Server.GetNumRequests(EHttpServerRequestVerbs::VERB_GET, TEXTVIEW("/admin/jobs/")) - NumPolls, Handles.Num());
+
+		for (int32 Index = 0; Index < NumRunning; ++Index)
+		{
+			TestEqual(TEXT("State of a running job"), Handles[Index].GetState(), FString(TEXT("Fetching")));
+			TestEqual(TEXT("Progress of a running job"), Handles[Index].GetStateProgress(), Index * 0.1f, KINDA_SMALL_NUMBER);
+		}
+
+		TestTrue(TEXT("Completed job completes its handle"), Handles[NumRunning].IsComplete());
+		TestEqual(TEXT("Aborted job reports its reason"), Handles[NumRunning + 1].GetErrorMessage(), AbortedJob.AbortReason);
+		TestTrue(TEXT("Forgotten job fails its handle"), Handles[NumRunning + 2].IsError());
+
+		// Handles that finished are not polled again
+		const int32 NumPollsBefore = Server.GetNumRequests(EHttpServerRequestVerbs::VERB_GET, TEXTVIEW("/admin/jobs/"));
+		TestEqual(TEXT("Handles still in progress on the next query"), Module.QuerySnapshotSyncStatuses(Handles), NumRunning);
+		TestEqual(TEXT("Polls of the next query"), Server.GetNumRequests(EHttpServerRequestVerbs::VERB_GET, TEXTVIEW("/admin/jobs/")) - NumPollsBefore, NumRunning);
+	});
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FZenSnapshotSyncCancelTest, "ZenSnapshotSync.CancelAndRollBack", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FZenSnapshotSyncCancelTest::RunTest(const FString& Parameters)
+{
+	return ZenSnapshotSyncTests::RunModuleScenario(*this, [this](FZenSnapshotSyncTestServer& Server, FZenSnapshotSyncModule& Module)
+	{
+		using namespace ZenSnapshotSyncTests;
+
+		const FString OplogId = TEXT("zensnapshotsynctest.cancel");
+
+		FZenSnapshotSyncHandle Handle = RequestImport(Module, OplogId);
+		if (!TestTrue(TEXT("Import was requested"), Handle.IsValid()) || !TestTrue(TEXT("Import created its oplog"), Server.HasOplog(OplogId)))
+		{
+			return;
+		}
+
+		const FString JobId = Server.GetLastJobId();
+
+		// The first attempt is dropped, the module asks again in the background
+		Server.FailRequests(EHttpServerRequestVerbs::VERB_DELETE, TEXTVIEW("/admin/jobs/"), 503, 1);
+		TestTrue(TEXT("Cancellation is accepted despite a dropped request"), Module.CancelSnapshotSync(Handle));
+		TestTrue(TEXT("Handle is cancelling"), Handle.IsCancelling());
+
+		TestTrue(TEXT("Job is asked to stop again"), FZenSnapshotSyncTestServer::WaitUntil([&Server, &JobId]()
+		{
+			FZenSnapshotSyncTestServer::FJob Job;
+			return Server.GetJob(JobId, Job) && Job.bCancelled;
+		}));
+
+		TestTrue(TEXT("Oplog the import created is removed once the job stopped"), FZenSnapshotSyncTestServer::WaitUntil([&Server, &OplogId]() { return !Server.HasOplog(OplogId); }));
+		TestEqual(TEXT("Cancellation attempts"), Server.GetNumRequests(EHttpServerRequestVerbs::VERB_DELETE, TEXTVIEW("/admin/jobs/")), 2);
+
+		TestFalse(TEXT("Cancelled job is no longer in progress"), Module.QuerySnapshotSyncStatus(Handle));
+		TestEqual(TEXT("Cancelled job fails the handle"), Handle.GetErrorMessage(), FString(TEXT("Cancelled")));
+
+		// Zen server refusing to stop the job is not retried and the job carries on
+		FZenSnapshotSyncHandle RefusedHandle = RequestImport(Module, TEXT("zensnapshotsynctest.refused"));
+		Server.FailRequests(EHttpServerRequestVerbs::VERB_DELETE, TEXTVIEW("/admin/jobs/"), 404, 1);
+		TestFalse(TEXT("Refused cancellation is reported"), Module.CancelSnapshotSync(RefusedHandle));
+		TestTrue(TEXT("Job whose cancellation was refused stays in progress"), Module.QuerySnapshotSyncStatus(RefusedHandle));
+
+		FZenSnapshotSyncTestServer::FJob Job;
+		Job.Status = TEXT("Complete");
+		Server.SetJob(Server.GetLastJobId(), Job);
+		TestFalse(TEXT("Job whose cancellation was refused completes"), Module.QuerySnapshotSyncStatus(RefusedHandle));
+	});
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FZenSnapshotSyncFullImportSlotTest, "ZenSnapshotSync.FullImportSkipsResidentSlot", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FZenSnapshotSyncFullImportSlotTest::RunTest(const FString& Parameters)
+{
+	GetMutableDefault<UZenSnapshotSyncSettings>()->MaxResidentSnapshots = 2;
+
+	return ZenSnapshotSyncTests::RunModuleScenario(*this, [this](FZenSnapshotSyncTestServer& Server, FZenSnapshotSyncModule& Module)
+	{
+		using namespace ZenSnapshotSyncTests;
+
+		const FString SnapshotDescriptorJson = FString::Printf(TEXT("{\"snapshots\":[{\"name\":\"Resident\",\"targetplatform\":\"%s\",\"type\":\"file\",\"directory\":\"%s\",\"filename\":\"Snapshot.oplog\"}]}"),
+			TargetPlatform, *FPaths::AutomationTransientDir());
+
+		TArray<FZenSnapshotDescriptor> SnapshotDescriptors;
+		if (!TestTrue(TEXT("Descriptor was read"), FZenSnapshotSyncModule::ReadSnapshotDescriptorJson(SnapshotDescriptorJson, SnapshotDescriptors)) || !TestEqual(TEXT("Descriptors read"), SnapshotDescriptors.Num(), 1))
+		{
+			return;
+		}
+
+		const FZenSnapshotDescriptor& SnapshotDescriptor = SnapshotDescriptors[0];
+
+		FZenSnapshotSyncHandle Handle = Module.RequestSnapshotSyncAsync(SnapshotDescriptor).Get();
+		if (!TestTrue(TEXT("Import was requested"), Handle.IsValid()))
+		{
+			return;
+		}
+
+		const FString JobId = Server.GetLastJobId();
+
+		FZenSnapshotSyncTestServer::FJob Job;
+		Job.Status = TEXT("Complete");
+		Server.SetJob(JobId, Job);
+		TestFalse(TEXT("Completed job is no longer in progress"), Module.QuerySnapshotSyncStatus(Handle));
+		TestTrue(TEXT("Completed job completes the handle"), Handle.IsComplete());
+		TestTrue(TEXT("Completed import is resident"), Module.IsSnapshotResident(SnapshotDescriptor));
+
+		// The completed import is resident, asking for it again only switches to its slot
+		FZenSnapshotSyncHandle ResidentHandle = Module.RequestSnapshotSyncAsync(SnapshotDescriptor).Get();
+		TestTrue(TEXT("Resident snapshot completes right away"), ResidentHandle.IsComplete());
+		TestEqual(TEXT("Resident snapshot is not imported again"), Server.GetLastJobId(), JobId);
+
+		FZenSnapshotSyncOptions Options;
+		Options.Mode = EZenSnapshotSyncMode::Full;
+
+		FZenSnapshotSyncHandle FullHandle = Module.RequestSnapshotSyncAsync(SnapshotDescriptor, Options).Get();
+		TestTrue(TEXT("Full import was requested"), FullHandle.IsValid() && !FullHandle.IsComplete());
+		TestNotEqual(TEXT("Full import of a resident snapshot imports it again"), Server.GetLastJobId(), JobId);
+
+		Server.SetJob(Server.GetLastJobId(), Job);
+		Module.QuerySnapshotSyncStatus(FullHandle);
+
+		IFileManager::Get().DeleteDirectory(*FPaths::GetPath(FZenSnapshotSyncRequest::GetProjectStoreFilePath(TargetPlatform)), false, true);
+	});
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FZenSnapshotSyncBenchmarkTest, "ZenSnapshotSync.Benchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FZenSnapshotSyncBenchmarkTest::RunTest(const FString& Parameters)
+{
+	return ZenSnapshotSyncTests::RunModuleScenario(*this, [this](FZenSnapshotSyncTestServer& Server, FZenSnapshotSyncModule& Module)
+	{
+		using namespace ZenSnapshotSyncTests;
+
+		static constexpr int32 NumPlatforms = 4;
+		static constexpr int32 NumHandlesPerPlatform = 16;
+		static constexpr double Latency = 0.005;
+		static constexpr double JobDuration = 2.0;
+		static constexpr double Timeout = 30.0;
+
+		// Replaces whatever the editor session recorded so far
+		FZenSnapshotSyncMetrics& Metrics = FZenSnapshotSyncMetrics::Get();
+		Metrics.Reset();
+
+		Server.SetLatency(Latency);
+		Server.SetJobDuration(JobDuration);
+
+		TArray<FZenSnapshotSyncHandle> Handles;
+		for (int32 PlatformIndex = 0; PlatformIndex < NumPlatforms; ++PlatformIndex)
+		{
+			const FString Platform = FString::Printf(TEXT("%s%d"), TargetPlatform, PlatformIndex);
+
+			for (int32 Index = 0; Index < NumHandlesPerPlatform; ++Index)
+			{
+				FZenSnapshotSyncHandle& Handle = Handles.Add_GetRef(RequestImport(Module, FString::Printf(TEXT("zensnapshotsynctest.bench%d.%d"), PlatformIndex, Index), Platform));
+				if (!TestTrue(TEXT("Import was requested"), Handle.IsValid()))
+				{
+					return;
+				}
+			}
+		}
+
+		// Every other import is cancelled while running, the rest run to completion
+		Module.QuerySnapshotSyncStatuses(Handles);
+		for (int32 Index = 0; Index < Handles.Num(); Index += 2)
+		{
+			TestTrue(TEXT("Running import is cancelled"), Module.CancelSnapshotSync(Handles[Index]));
+		}
+
+		const double EndTime = FPlatformTime::Seconds() + Timeout;
+		while (Module.QuerySnapshotSyncStatuses(Handles) > 0)
+		{
+			if (FPlatformTime::Seconds() >= EndTime)
+			{
+				AddError(TEXT("Imports did not finish in time"));
+				return;
+			}
+
+			FPlatformProcess::Sleep(0.05f);
+		}
+
+		for (int32 Index = 0; Index < Handles.Num(); ++Index)
+		{
+			TestTrue(TEXT("Import finished as expected"), Index % 2 == 0 ? Handles[Index].IsError() : Handles[Index].IsComplete());
+		}
+
+		for (EZenSnapshotSyncOperation Operation : { EZenSnapshotSyncOperation::RequestSync, EZenSnapshotSyncOperation::QueryStatus, EZenSnapshotSyncOperation::CancelSync, EZenSnapshotSyncOperation::HttpRequest })
+		{
+			AddInfo(FString::Printf(TEXT("%s: %llu calls, p50 %.2fms, p99 %.2fms"), FZenSnapshotSyncMetrics::GetOperationName(Operation), Metrics.GetCount(Operation),
+				Metrics.GetPercentile(Operation, 0.5), Metrics.GetPercentile(Operation, 0.99)));
+		}
+	});
+}
+
+#endif
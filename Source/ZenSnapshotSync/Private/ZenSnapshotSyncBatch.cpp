@@ -0,0 +1,276 @@
+#include "ZenSnapshotSyncBatch.h"
+
+#include <Algo/Count.h>
+#include <HAL/PlatformTime.h>
+#include <Logging/StructuredLog.h>
+
+#include "ZenSnapshotSyncLog.h"
+#include "ZenSnapshotSyncModule.h"
+
+FZenSnapshotSyncBatch::FZenSnapshotSyncBatch(FZenSnapshotSyncModule& InModule, TConstArrayView<FZenSnapshotDescriptor> InSnapshotDescriptors, int32 InMaxConcurrentImports, const FZenSnapshotSyncOptions& InOptions)
+	: Module(InModule)
+	, MaxConcurrentImports(FMath::Max(InMaxConcurrentImports, 1))
+	, Options(InOptions)
+{
+	for (const FZenSnapshotDescriptor& SnapshotDescriptor : InSnapshotDescriptors)
+	{
+		const bool bPlatformQueued = Entries.ContainsByPredicate([&SnapshotDescriptor](const FEntry& Entry)
+		{
+			return Entry.SnapshotDescriptor.GetTargetPlatform() == SnapshotDescriptor.GetTargetPlatform();
+		});
+
+		if (!bPlatformQueued)
+		{
+			Entries.Emplace_GetRef().SnapshotDescriptor = SnapshotDescriptor;
+		}
+	}
+
+	StartTime = FPlatformTime::Seconds();
+	PendingProjectSetup = Module.EnsureProjectAsync();
+}
+
+FZenSnapshotSyncBatch::~FZenSnapshotSyncBatch()
+{
+	if (bDetached)
+	{
+		return;
+	}
+
+	Cancel();
+
+	// Jobs of requests still in flight are cancelled once created
+	for (FEntry& Entry : Entries)
+	{
+		if (Entry.PendingHandle.IsValid())
+		{
+			Module.CancelSnapshotSyncWhenRequested(MoveTemp(Entry.PendingHandle));
+		}
+	}
+}
+
+bool FZenSnapshotSyncBatch::Tick()
+{
+	if (PendingProjectSetup.IsValid())
+	{
+		if (!PendingProjectSetup.IsReady())
+		{
+			return true;
+		}
+
+		bProjectReady = PendingProjectSetup.Get();
+		PendingProjectSetup.Reset();
+
+		if (!bProjectReady)
+		{
+			UE_LOGFMT(LogZenSnapshotSync, Error, "Failed to set up project for snapshot sync batch");
+
+			for (FEntry& Entry : Entries)
+			{
+				Entry.State = EEntryState::Failed;
+			}
+		}
+	}
+
+	for (int32 Index = 0; Index < Entries.Num(); ++Index)
+	{
+		FEntry& Entry = Entries[Index];
+
+		if (Entry.State == EEntryState::Requesting && Entry.PendingHandle.IsReady())
+		{
+			Entry.Handle = Entry.PendingHandle.Get();
+			Entry.PendingHandle.Reset();
+
+			if (!Entry.Handle.IsValid())
+			{
+				Entry.State = EEntryState::Failed;
+			}
+			else if (Entry.Handle.IsComplete())
+			{
+				Entry.State = EEntryState::Complete;
+			}
+			else if (bCancelled)
+			{
+				Module.CancelSnapshotSync(Entry.Handle);
+				Entry.State = EEntryState::Failed;
+			}
+			else
+			{
+				Entry.State = EEntryState::Importing;
+				Entry.StatusSubscriptionHandle = Module.SubscribeSnapshotSyncStatus(Entry.Handle,
+					FZenSnapshotSyncModule::FOnSnapshotSyncStatusChanged::CreateRaw(this, &FZenSnapshotSyncBatch::OnSnapshotSyncStatusChanged, Index));
+			}
+		}
+	}
+
+	if (bProjectReady && !bCancelled)
+	{
+		int32 NumActive = GetNumActive();
+		for (FEntry& Entry : Entries)
+		{
+			if (NumActive >= MaxConcurrentImports)
+			{
+				break;
+			}
+
+			if (Entry.State == EEntryState::Queued)
+			{
+				Entry.State = EEntryState::Requesting;
+				Entry.RequestTime = FPlatformTime::Seconds();
+				Entry.PendingHandle = Module.RequestSnapshotSyncAsync(Entry.SnapshotDescriptor, Options);
+				++NumActive;
+			}
+		}
+	}
+
+	UpdateProgress();
+
+	return !IsFinished();
+}
+
+void FZenSnapshotSyncBatch::Cancel()
+{
+	bCancelled = true;
+
+	for (FEntry& Entry : Entries)
+	{
+		if (Entry.State == EEntryState::Queued)
+		{
+			Entry.State = EEntryState::Failed;
+		}
+		else if (Entry.State == EEntryState::Importing)
+		{
+			Module.UnsubscribeSnapshotSyncStatus(Entry.StatusSubscriptionHandle);
+			Entry.StatusSubscriptionHandle.Reset();
+
+			Module.CancelSnapshotSync(Entry.Handle);
+			Entry.State = EEntryState::Failed;
+		}
+	}
+}
+
+void FZenSnapshotSyncBatch::Detach()
+{
+	bDetached = true;
+
+	for (FEntry& Entry : Entries)
+	{
+		Module.UnsubscribeSnapshotSyncStatus(Entry.StatusSubscriptionHandle);
+		Entry.StatusSubscriptionHandle.Reset();
+	}
+}
+
+bool FZenSnapshotSyncBatch::IsFinished() const
+{
+	return GetNumComplete() + GetNumFailed() == Entries.Num();
+}
+
+int32 FZenSnapshotSyncBatch::GetNumSnapshots() const
+{
+	return Entries.Num();
+}
+
+int32 FZenSnapshotSyncBatch::GetNumComplete() const
+{
+	return Algo::CountIf(Entries, [](const FEntry& Entry) { return Entry.State == EEntryState::Complete; });
+}
+
+int32 FZenSnapshotSyncBatch::GetNumFailed() const
+{
+	return Algo::CountIf(Entries, [](const FEntry& Entry) { return Entry.State == EEntryState::Failed; });
+}
+
+const FZenSnapshotDescriptor& FZenSnapshotSyncBatch::GetSnapshotDescriptor(int32 Index) const
+{
+	return Entries[Index].SnapshotDescriptor;
+}
+
+const FZenSnapshotSyncHandle& FZenSnapshotSyncBatch::GetHandle(int32 Index) const
+{
+	return Entries[Index].Handle;
+}
+
+FZenSnapshotSyncBatch::EEntryState FZenSnapshotSyncBatch::GetEntryState(int32 Index) const
+{
+	return Entries[Index].State;
+}
+
+float FZenSnapshotSyncBatch::GetProgress() const
+{
+	return Entries.IsEmpty() ? 1.0f : Progress;
+}
+
+double FZenSnapshotSyncBatch::GetEstimatedTimeRemaining() const
+{
+	const float Progress = GetProgress();
+	if (Progress <= 0.0f)
+	{
+		return -1.0;
+	}
+
+	const double ElapsedTime = FPlatformTime::Seconds() - StartTime;
+	return ElapsedTime * (1.0 - Progress) / Progress;
+}
+
+void FZenSnapshotSyncBatch::OnSnapshotSyncStatusChanged(const FZenSnapshotSyncHandle& Handle, int32 Index)
+{
+	FEntry& Entry = Entries[Index];
+	if (Entry.State != EEntryState::Importing)
+	{
+		return;
+	}
+
+	Entry.Handle = Handle;
+
+	if (Handle.IsComplete())
+	{
+		Entry.State = EEntryState::Complete;
+	}
+	else if (Handle.IsError())
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Error, "Failed to sync snapshot '{Name}' ({Error})", Entry.SnapshotDescriptor.GetName(), Handle.GetErrorMessage());
+		Entry.State = EEntryState::Failed;
+	}
+}
+
+void FZenSnapshotSyncBatch::UpdateProgress()
+{
+	const double CurrentTime = FPlatformTime::Seconds();
+
+	float TotalProgress = 0.0f;
+	int32 NumSucceeding = 0;
+
+	for (FEntry& Entry : Entries)
+	{
+		// Job ops reset their progress, only the estimate covers the whole job
+		const double EstimatedSeconds = Entry.Handle.GetTelemetry().Estimate.EstimatedSeconds;
+		if (Entry.State == EEntryState::Complete)
+		{
+			Entry.Progress = 1.0f;
+		}
+		else if (Entry.State == EEntryState::Importing && EstimatedSeconds > 0.0)
+		{
+			Entry.Progress = FMath::Max(Entry.Progress, FMath::Min(static_cast<float>((CurrentTime - Entry.RequestTime) / EstimatedSeconds), MaxEstimatedProgress));
+		}
+		else if (Entry.State == EEntryState::Importing)
+		{
+			// Sources without an estimate, e.g. cloud ones, follow the current op
+			Entry.Progress = FMath::Max(Entry.Progress, FMath::Min(Entry.Handle.GetStateProgress(), MaxEstimatedProgress));
+		}
+
+		if (Entry.State != EEntryState::Failed)
+		{
+			TotalProgress += Entry.Progress;
+			++NumSucceeding;
+		}
+	}
+
+	if (NumSucceeding > 0)
+	{
+		Progress = FMath::Max(Progress, TotalProgress / NumSucceeding);
+	}
+}
+
+int32 FZenSnapshotSyncBatch::GetNumActive() const
+{
+	return Algo::CountIf(Entries, [](const FEntry& Entry) { return Entry.State == EEntryState::Requesting || Entry.State == EEntryState::Importing; });
+}
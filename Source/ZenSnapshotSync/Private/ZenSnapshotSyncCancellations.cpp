@@ -0,0 +1,132 @@
+#include "ZenSnapshotSyncCancellations.h"
+
+#include <Dom/JsonObject.h>
+#include <HAL/FileManager.h>
+#include <Logging/StructuredLog.h>
+#include <Misc/FileHelper.h>
+#include <Misc/ScopeLock.h>
+#include <Serialization/JsonReader.h>
+#include <Serialization/JsonSerializer.h>
+#include <Serialization/JsonWriter.h>
+
+#include "ZenSnapshotSyncLog.h"
+
+FZenSnapshotSyncCancellations::FZenSnapshotSyncCancellations(FString InFilePath)
+	: FilePath(MoveTemp(InFilePath))
+{
+	Load();
+}
+
+void FZenSnapshotSyncCancellations::Add(FZenSnapshotSyncCancellation&& Cancellation)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	const FString JobId = Cancellation.JobId;
+	Pending.Add(JobId, MoveTemp(Cancellation));
+}
+
+void FZenSnapshotSyncCancellations::Remove(FStringView JobId)
+{
+	FScopeLock ScopeLock(&Lock);
+	Pending.Remove(FString(JobId));
+}
+
+double FZenSnapshotSyncCancellations::GetRequestTime(FStringView JobId) const
+{
+	FScopeLock ScopeLock(&Lock);
+
+	const FZenSnapshotSyncCancellation* Cancellation = Pending.Find(FString(JobId));
+	return Cancellation ? Cancellation->RequestTime : 0.0;
+}
+
+bool FZenSnapshotSyncCancellations::Confirm(FStringView JobId, FZenSnapshotSyncCancellation& OutCancellation)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	if (!Pending.RemoveAndCopyValue(FString(JobId), OutCancellation))
+	{
+		return false;
+	}
+
+	Confirmed.Add(OutCancellation.JobId);
+	return true;
+}
+
+bool FZenSnapshotSyncCancellations::IsConfirmed(FStringView JobId) const
+{
+	FScopeLock ScopeLock(&Lock);
+	return Confirmed.Contains(FString(JobId));
+}
+
+void FZenSnapshotSyncCancellations::MarkDirty(const FString& OplogId)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	bool bAlreadyDirty = false;
+	DirtyOplogIds.Add(OplogId, &bAlreadyDirty);
+
+	if (!bAlreadyDirty)
+	{
+		Save();
+	}
+}
+
+void FZenSnapshotSyncCancellations::ClearDirty(const FString& OplogId)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	if (DirtyOplogIds.Remove(OplogId) > 0)
+	{
+		Save();
+	}
+}
+
+bool FZenSnapshotSyncCancellations::IsDirty(const FString& OplogId) const
+{
+	FScopeLock ScopeLock(&Lock);
+	return DirtyOplogIds.Contains(OplogId);
+}
+
+void FZenSnapshotSyncCancellations::Load()
+{
+	FString DirtyJson;
+	if (!FFileHelper::LoadFileToString(DirtyJson, *FilePath, FFileHelper::EHashOptions::None, FILEREAD_Silent))
+	{
+		return;
+	}
+
+	TSharedPtr<FJsonObject> Registry;
+	TArray<FString> OplogIds;
+
+	if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(DirtyJson), Registry) || !Registry.IsValid() || !Registry->TryGetStringArrayField(TEXT("dirtyoplogs"), OplogIds))
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Warning, "Ignoring unreadable dirty oplog registry '{File}'", FilePath);
+		return;
+	}
+
+	DirtyOplogIds.Append(MoveTemp(OplogIds));
+}
+
+void FZenSnapshotSyncCancellations::Save() const
+{
+	FString DirtyJson;
+
+	const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&DirtyJson);
+	Writer->WriteObjectStart();
+	Writer->WriteArrayStart(TEXT("dirtyoplogs"));
+
+	for (const FString& OplogId : DirtyOplogIds)
+	{
+		Writer->WriteValue(OplogId);
+	}
+
+	Writer->WriteArrayEnd();
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	const FString TempFilePath = FilePath + TEXT(".tmp");
+	if (!FFileHelper::SaveStringToFile(DirtyJson, *TempFilePath) || !IFileManager::Get().Move(*FilePath, *TempFilePath))
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Warning, "Failed to write dirty oplog registry '{File}'", FilePath);
+	}
+}
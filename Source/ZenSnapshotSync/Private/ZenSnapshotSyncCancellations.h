@@ -0,0 +1,50 @@
+#pragma once
+
+#include <Containers/Map.h>
+#include <Containers/Set.h>
+#include <HAL/CriticalSection.h>
+
+struct FZenSnapshotSyncCancellation
+{
+	FString JobId;
+	FString TargetPlatform;
+	FString OplogId;
+
+	// Empty if the import left the project store alone
+	FString PreviousOplogId;
+
+	bool bCreatedOplog = false;
+	double RequestTime = 0.0;
+};
+
+// Cancelled imports until their job is seen stopping, and the oplogs they left dirty until an import into them completes
+class FZenSnapshotSyncCancellations
+{
+public:
+	explicit FZenSnapshotSyncCancellations(FString InFilePath);
+
+	void Add(FZenSnapshotSyncCancellation&& Cancellation);
+	void Remove(FStringView JobId);
+
+	// 0 if the job was not cancelled or its cancellation was already confirmed
+	double GetRequestTime(FStringView JobId) const;
+
+	// True for the first caller only, which cleans up after the job
+	bool Confirm(FStringView JobId, FZenSnapshotSyncCancellation& OutCancellation);
+	bool IsConfirmed(FStringView JobId) const;
+
+	void MarkDirty(const FString& OplogId);
+	void ClearDirty(const FString& OplogId);
+	bool IsDirty(const FString& OplogId) const;
+
+private:
+	void Load();
+	void Save() const;
+
+	const FString FilePath;
+
+	mutable FCriticalSection Lock;
+	TMap<FString, FZenSnapshotSyncCancellation> Pending;
+	TSet<FString> Confirmed;
+	TSet<FString> DirtyOplogIds;
+};
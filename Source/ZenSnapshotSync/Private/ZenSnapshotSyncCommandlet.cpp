@@ -0,0 +1,208 @@
+#include "ZenSnapshotSyncCommandlet.h"
+
+#include <Containers/Ticker.h>
+#include <CoreGlobals.h>
+#include <HAL/PlatformProcess.h>
+#include <HAL/PlatformTime.h>
+#include <Logging/StructuredLog.h>
+#include <Misc/Parse.h>
+#include <Modules/ModuleManager.h>
+#include <Policies/CondensedJsonPrintPolicy.h>
+#include <Serialization/JsonWriter.h>
+
+#include "ZenSnapshotSyncBatch.h"
+#include "ZenSnapshotSyncLog.h"
+#include "ZenSnapshotSyncModule.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(ZenSnapshotSyncCommandlet)
+
+namespace ZenSnapshotSyncCommandlet
+{
+	enum EExitCode : int32
+	{
+		Success = 0,
+		InvalidArguments = 1,
+		SyncFailed = 2,
+		TimedOut = 3,
+	};
+
+	using FJsonWriter = TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>;
+	using FJsonWriterFactory = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>;
+
+	static const TCHAR* GetEntryStateName(FZenSnapshotSyncBatch::EEntryState State)
+	{
+		switch (State)
+		{
+		case FZenSnapshotSyncBatch::EEntryState::Queued: return TEXT("Queued");
+		case FZenSnapshotSyncBatch::EEntryState::Requesting: return TEXT("Requesting");
+		case FZenSnapshotSyncBatch::EEntryState::Importing: return TEXT("Importing");
+		case FZenSnapshotSyncBatch::EEntryState::Complete: return TEXT("Complete");
+		case FZenSnapshotSyncBatch::EEntryState::Failed: return TEXT("Failed");
+		default: return TEXT("Unknown");
+		}
+	}
+
+	// Only entries whose state or whole percentage changed are logged
+	static void LogProgress(const FZenSnapshotSyncBatch& Batch, TArray<FString>& LastProgress)
+	{
+		for (int32 Index = 0; Index < Batch.GetNumSnapshots(); ++Index)
+		{
+			const FZenSnapshotDescriptor& SnapshotDescriptor = Batch.GetSnapshotDescriptor(Index);
+			const FZenSnapshotSyncHandle& Handle = Batch.GetHandle(Index);
+			const FZenSnapshotSyncBatch::EEntryState State = Batch.GetEntryState(Index);
+
+			FString Progress;
+			const TSharedRef<FJsonWriter> JsonWriter = FJsonWriterFactory::Create(&Progress);
+			JsonWriter->WriteObjectStart();
+			JsonWriter->WriteValue(TEXT("platform"), SnapshotDescriptor.GetTargetPlatform());
+			JsonWriter->WriteValue(TEXT("snapshot"), SnapshotDescriptor.GetName());
+			JsonWriter->WriteValue(TEXT("state"), GetEntryStateName(State));
+
+			if (State == FZenSnapshotSyncBatch::EEntryState::Importing)
+			{
+				JsonWriter->WriteValue(TEXT("operation"), Handle.GetState());
+				JsonWriter->WriteValue(TEXT("percent"), FMath::FloorToInt32(Handle.GetStateProgress() * 100.0f));
+			}
+			else if (State == FZenSnapshotSyncBatch::EEntryState::Failed && Handle.IsError())
+			{
+				JsonWriter->WriteValue(TEXT("error"), Handle.GetErrorMessage());
+			}
+
+			JsonWriter->WriteObjectEnd();
+			JsonWriter->Close();
+
+			if (Progress != LastProgress[Index])
+			{
+				UE_LOGFMT(LogZenSnapshotSync, Display, "@progress {Progress}", Progress);
+				LastProgress[Index] = MoveTemp(Progress);
+			}
+		}
+	}
+}
+
+UZenSnapshotSyncCommandlet::UZenSnapshotSyncCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+
+	HelpDescription = TEXT("Syncs cooked snapshots into Zen server for the requested target platforms");
+	HelpUsage = TEXT("-run=ZenSnapshotSync -descriptor=<file> [-platforms=<platform>+<platform>] [-snapshot=<name>] [-concurrency=<n>] [-timeout=<seconds>] [-full]");
+}
+
+int32 UZenSnapshotSyncCommandlet::Main(const FString& Params)
+{
+	using namespace ZenSnapshotSyncCommandlet;
+
+	FString SnapshotDescriptorFilePath;
+	if (!FParse::Value(*Params, TEXT("-descriptor="), SnapshotDescriptorFilePath))
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Error, "Missing snapshot descriptor file, usage: {Usage}", HelpUsage);
+		return InvalidArguments;
+	}
+
+	FString PlatformsValue;
+	TArray<FString> Platforms;
+	if (FParse::Value(*Params, TEXT("-platforms="), PlatformsValue))
+	{
+		PlatformsValue.ParseIntoArray(Platforms, TEXT("+"));
+	}
+
+	FString SnapshotName;
+	FParse::Value(*Params, TEXT("-snapshot="), SnapshotName);
+
+	int32 MaxConcurrentImports = 0;
+	FParse::Value(*Params, TEXT("-concurrency="), MaxConcurrentImports);
+
+	double Timeout = 0.0;
+	FParse::Value(*Params, TEXT("-timeout="), Timeout);
+
+	FZenSnapshotSyncOptions Options;
+	Options.Mode = FParse::Param(*Params, TEXT("full")) ? EZenSnapshotSyncMode::Full : EZenSnapshotSyncMode::Default;
+
+	TArray<FZenSnapshotDescriptor> SnapshotDescriptors;
+	if (!FZenSnapshotSyncModule::ReadSnapshotDescriptorFile(*SnapshotDescriptorFilePath, SnapshotDescriptors))
+	{
+		return InvalidArguments;
+	}
+
+	SnapshotDescriptors.RemoveAll([&Platforms, &SnapshotName](const FZenSnapshotDescriptor& SnapshotDescriptor)
+	{
+		return (!Platforms.IsEmpty() && !Platforms.Contains(SnapshotDescriptor.GetTargetPlatform()))
+			|| (!SnapshotName.IsEmpty() && SnapshotDescriptor.GetName() != SnapshotName);
+	});
+
+	bool bMissingPlatforms = false;
+	for (const FString& Platform : Platforms)
+	{
+		if (!SnapshotDescriptors.ContainsByPredicate([&Platform](const FZenSnapshotDescriptor& SnapshotDescriptor) { return SnapshotDescriptor.GetTargetPlatform() == Platform; }))
+		{
+			UE_LOGFMT(LogZenSnapshotSync, Error, "No snapshot found for platform '{Platform}' in '{File}'", Platform, SnapshotDescriptorFilePath);
+			bMissingPlatforms = true;
+		}
+	}
+
+	if (SnapshotDescriptors.IsEmpty())
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Error, "No snapshots to sync from '{File}'", SnapshotDescriptorFilePath);
+		return InvalidArguments;
+	}
+
+	FZenSnapshotSyncModule& Module = FModuleManager::LoadModuleChecked<FZenSnapshotSyncModule>(UE_MODULE_NAME);
+
+	FZenSnapshotSyncBatch Batch(Module, SnapshotDescriptors, MaxConcurrentImports > 0 ? MaxConcurrentImports : SnapshotDescriptors.Num(), Options);
+
+	TArray<FString> LastProgress;
+	LastProgress.SetNum(Batch.GetNumSnapshots());
+
+	const double StartTime = FPlatformTime::Seconds();
+	double LastTickTime = StartTime;
+	bool bCancelled = false;
+	bool bTimedOut = false;
+
+	while (Batch.Tick())
+	{
+		const double CurrentTime = FPlatformTime::Seconds();
+
+		// Nothing else pumps the core ticker in a commandlet
+		FTSTicker::GetCoreTicker().Tick(static_cast<float>(CurrentTime - LastTickTime));
+		LastTickTime = CurrentTime;
+
+		LogProgress(Batch, LastProgress);
+
+		if (!bCancelled && Timeout > 0.0 && CurrentTime - StartTime > Timeout)
+		{
+			UE_LOGFMT(LogZenSnapshotSync, Error, "Snapshot sync did not finish within {Timeout}s, cancelling", Timeout);
+			bTimedOut = true;
+		}
+
+		if (!bCancelled && (bTimedOut || IsEngineExitRequested()))
+		{
+			Batch.Cancel();
+			bCancelled = true;
+		}
+
+		FPlatformProcess::Sleep(0.1f);
+	}
+
+	LogProgress(Batch, LastProgress);
+
+	FString Result;
+	const TSharedRef<FJsonWriter> JsonWriter = FJsonWriterFactory::Create(&Result);
+	JsonWriter->WriteObjectStart();
+	JsonWriter->WriteValue(TEXT("complete"), Batch.GetNumComplete());
+	JsonWriter->WriteValue(TEXT("failed"), Batch.GetNumFailed());
+	JsonWriter->WriteValue(TEXT("seconds"), FPlatformTime::Seconds() - StartTime);
+	JsonWriter->WriteObjectEnd();
+	JsonWriter->Close();
+
+	UE_LOGFMT(LogZenSnapshotSync, Display, "@result {Result}", Result);
+
+	if (bTimedOut)
+	{
+		return TimedOut;
+	}
+
+	return Batch.GetNumFailed() > 0 || bMissingPlatforms ? SyncFailed : Success;
+}
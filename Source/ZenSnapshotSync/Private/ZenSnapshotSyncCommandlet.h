@@ -0,0 +1,17 @@
+#pragma once
+
+#include <Commandlets/Commandlet.h>
+
+#include "ZenSnapshotSyncCommandlet.generated.h"
+
+// Usage: -run=ZenSnapshotSync -descriptor=<file> [-platforms=<platform>+<platform>] [-snapshot=<name>] [-concurrency=<n>] [-timeout=<seconds>] [-full]
+UCLASS()
+class UZenSnapshotSyncCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UZenSnapshotSyncCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,417 @@
+#include "ZenSnapshotSyncDescriptorCache.h"
+
+#include <Async/Async.h>
+#include <Containers/BitArray.h>
+#include <HAL/Event.h>
+#include <HAL/PlatformTime.h>
+#include <Logging/StructuredLog.h>
+#include <Misc/ScopeLock.h>
+
+#include "ZenSnapshotSyncLog.h"
+#include "ZenSnapshotSyncMetrics.h"
+#include "ZenSnapshotSyncStats.h"
+
+DEFINE_STAT(STAT_ZenSnapshotSync_SlowestProviderRefresh);
+DEFINE_STAT(STAT_ZenSnapshotSync_CachedSnapshots);
+
+FZenSnapshotSyncDescriptorCache::FZenSnapshotSyncDescriptorCache()
+	: SnapshotDescriptors(MakeShared<TArray<FZenSnapshotDescriptor>>())
+{
+	TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FZenSnapshotSyncDescriptorCache::Tick));
+}
+
+FZenSnapshotSyncDescriptorCache::~FZenSnapshotSyncDescriptorCache()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+
+	Wait(PendingRefresh);
+
+	for (FGameThreadQuery& Query : GameThreadQueries)
+	{
+		Query.Promise.SetValue(TArray<FZenSnapshotDescriptor>());
+	}
+}
+
+FDelegateHandle FZenSnapshotSyncDescriptorCache::AddProvider(FString Name, FZenSnapshotSyncModule::FQuerySnapshotsAsyncDelegate&& Callback, FZenSnapshotSyncModule::FQuerySnapshotsVersionDelegate&& VersionCallback)
+{
+	return AddProvider(FDelegateHandle(FDelegateHandle::GenerateNewHandle), MoveTemp(Name), MoveTemp(Callback), MoveTemp(VersionCallback));
+}
+
+FDelegateHandle FZenSnapshotSyncDescriptorCache::AddProvider(FDelegateHandle ProviderHandle, FString Name, FZenSnapshotSyncModule::FQuerySnapshotsAsyncDelegate&& Callback, FZenSnapshotSyncModule::FQuerySnapshotsVersionDelegate&& VersionCallback)
+{
+	TSharedRef<FProvider> Provider = MakeShared<FProvider>();
+	Provider->Handle = ProviderHandle;
+	Provider->Name = MoveTemp(Name);
+	Provider->Callback = MoveTemp(Callback);
+	Provider->VersionCallback = MoveTemp(VersionCallback);
+	Provider->Stats.Name = Provider->Name;
+
+	{
+		FScopeLock ScopeLock(&Lock);
+		Providers.Add(Provider);
+	}
+
+	Refresh();
+
+	return Provider->Handle;
+}
+
+FDelegateHandle FZenSnapshotSyncDescriptorCache::AddProvider(FString Name, FZenSnapshotSyncModule::FQuerySnapshotsDelegate&& Callback, FZenSnapshotSyncModule::FQuerySnapshotsVersionDelegate&& VersionCallback)
+{
+	const FDelegateHandle ProviderHandle(FDelegateHandle::GenerateNewHandle);
+
+	FZenSnapshotSyncModule::FQuerySnapshotsAsyncDelegate AsyncCallback = FZenSnapshotSyncModule::FQuerySnapshotsAsyncDelegate::CreateLambda([this, ProviderHandle, Callback = MoveTemp(Callback)]()
+	{
+		FGameThreadQuery Query;
+		Query.ProviderHandle = ProviderHandle;
+		Query.Callback = Callback;
+		TFuture<TArray<FZenSnapshotDescriptor>> Future = Query.Promise.GetFuture();
+
+		FScopeLock ScopeLock(&Lock);
+		GameThreadQueries.Add(MoveTemp(Query));
+
+		return Future;
+	});
+
+	return AddProvider(ProviderHandle, MoveTemp(Name), MoveTemp(AsyncCallback), MoveTemp(VersionCallback));
+}
+
+void FZenSnapshotSyncDescriptorCache::RemoveProvider(FDelegateHandle ProviderHandle)
+{
+	TSharedPtr<FProvider> RemovedProvider;
+	TArray<FGameThreadQuery> DroppedQueries;
+	{
+		FScopeLock ScopeLock(&Lock);
+
+		const int32 ProviderIndex = Providers.IndexOfByPredicate([ProviderHandle](const TSharedRef<FProvider>& Provider) { return Provider->Handle == ProviderHandle; });
+		if (ProviderIndex != INDEX_NONE)
+		{
+			RemovedProvider = Providers[ProviderIndex];
+			RemovedProvider->bRemoved = true;
+			Providers.RemoveAt(ProviderIndex);
+		}
+
+		for (int32 QueryIndex = GameThreadQueries.Num() - 1; QueryIndex >= 0; --QueryIndex)
+		{
+			if (GameThreadQueries[QueryIndex].ProviderHandle == ProviderHandle)
+			{
+				DroppedQueries.Add(MoveTemp(GameThreadQueries[QueryIndex]));
+				GameThreadQueries.RemoveAt(QueryIndex);
+			}
+		}
+	}
+
+	for (FGameThreadQuery& Query : DroppedQueries)
+	{
+		Query.Promise.SetValue(TArray<FZenSnapshotDescriptor>());
+	}
+
+	// The provider's owner must be able to go away once this returns, late results are dropped like those of timed out queries
+	if (RemovedProvider.IsValid())
+	{
+		FScopeLock CallbackScopeLock(&RemovedProvider->CallbackLock);
+		RemovedProvider->Callback.Unbind();
+		RemovedProvider->VersionCallback.Unbind();
+	}
+
+	Refresh();
+}
+
+bool FZenSnapshotSyncDescriptorCache::HasProviders() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return !Providers.IsEmpty();
+}
+
+void FZenSnapshotSyncDescriptorCache::Refresh()
+{
+	FScopeLock ScopeLock(&Lock);
+
+	if (bRefreshRunning)
+	{
+		bRefreshRequested = true;
+		return;
+	}
+
+	bRefreshRunning = true;
+
+	PendingRefresh = Async(EAsyncExecution::ThreadPool, [this]()
+	{
+		for (;;)
+		{
+			RefreshProviders();
+
+			FScopeLock ScopeLock(&Lock);
+			if (!bRefreshRequested)
+			{
+				bRefreshRunning = false;
+				break;
+			}
+
+			bRefreshRequested = false;
+		}
+	});
+}
+
+void FZenSnapshotSyncDescriptorCache::WaitForRefresh()
+{
+	check(IsInGameThread());
+
+	Wait(PendingRefresh);
+}
+
+TSharedRef<const TArray<FZenSnapshotDescriptor>> FZenSnapshotSyncDescriptorCache::GetSnapshotDescriptors() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return SnapshotDescriptors;
+}
+
+TArray<FZenSnapshotProviderStats> FZenSnapshotSyncDescriptorCache::GetProviderStats() const
+{
+	FScopeLock ScopeLock(&Lock);
+
+	TArray<FZenSnapshotProviderStats> ProviderStats;
+	ProviderStats.Reserve(Providers.Num());
+
+	for (const TSharedRef<FProvider>& Provider : Providers)
+	{
+		ProviderStats.Add(Provider->Stats);
+	}
+
+	return ProviderStats;
+}
+
+void FZenSnapshotSyncDescriptorCache::RefreshProviders()
+{
+	TArray<TSharedRef<FProvider>> CurrentProviders;
+	{
+		FScopeLock ScopeLock(&Lock);
+		CurrentProviders = Providers;
+	}
+
+	// Providers that time out may still complete after the refresh is done
+	struct FQueryResults
+	{
+		FCriticalSection Lock;
+		FEventRef CompletedEvent;
+		TArray<TPair<int32, TArray<FZenSnapshotDescriptor>>> Completed;
+	};
+
+	TSharedRef<FQueryResults> QueryResults = MakeShared<FQueryResults>();
+	TArray<FString> Versions;
+	Versions.SetNum(CurrentProviders.Num());
+	TBitArray<> PendingQueries(false, CurrentProviders.Num());
+	int32 NumPendingQueries = 0;
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	for (int32 ProviderIndex = 0; ProviderIndex < CurrentProviders.Num(); ++ProviderIndex)
+	{
+		FProvider& Provider = *CurrentProviders[ProviderIndex];
+
+		FScopeLock CallbackScopeLock(&Provider.CallbackLock);
+
+		FString& Version = Versions[ProviderIndex];
+		Version = Provider.VersionCallback.IsBound() ? Provider.VersionCallback.Execute() : FString();
+
+		bool bChanged = true;
+		bool bBusy = false;
+		{
+			FScopeLock ScopeLock(&Lock);
+			bChanged = Version.IsEmpty() || Version != Provider.Version;
+			bBusy = Provider.PendingQuery.IsValid() && !Provider.PendingQuery.IsReady();
+
+			if (Provider.bRemoved)
+			{
+				continue;
+			}
+
+			if (!bChanged || bBusy)
+			{
+				Provider.Stats.LastRefreshTime = 0.0;
+				Provider.Stats.bLastRefreshChanged = false;
+				Provider.Stats.bLastRefreshTimedOut = bBusy;
+			}
+		}
+
+		if (!bChanged || bBusy)
+		{
+			UE_LOGFMT(LogZenSnapshotSync, Verbose, "Skipped snapshot provider '{Name}' ({Reason})", Provider.Name, bBusy ? TEXT("previous query still running") : TEXT("unchanged"));
+			continue;
+		}
+
+		TFuture<TArray<FZenSnapshotDescriptor>> Query = Provider.Callback.IsBound() ? Provider.Callback.Execute() : TFuture<TArray<FZenSnapshotDescriptor>>();
+		if (!Query.IsValid())
+		{
+			Query = MakeFulfilledPromise<TArray<FZenSnapshotDescriptor>>().GetFuture();
+		}
+
+		TFuture<void> PendingQuery = Query.Next([QueryResults, ProviderIndex](TArray<FZenSnapshotDescriptor> ProviderSnapshotDescriptors)
+		{
+			{
+				FScopeLock ScopeLock(&QueryResults->Lock);
+				QueryResults->Completed.Emplace(ProviderIndex, MoveTemp(ProviderSnapshotDescriptors));
+			}
+
+			QueryResults->CompletedEvent->Trigger();
+		});
+
+		{
+			FScopeLock ScopeLock(&Lock);
+			Provider.PendingQuery = MoveTemp(PendingQuery);
+		}
+
+		PendingQueries[ProviderIndex] = true;
+		++NumPendingQueries;
+	}
+
+	double SlowestRefreshTime = 0.0;
+	const double Deadline = StartTime + ProviderTimeout;
+
+	// Published as they arrive so fast providers do not wait on slow ones
+	while (NumPendingQueries > 0)
+	{
+		TArray<TPair<int32, TArray<FZenSnapshotDescriptor>>> Completed;
+		{
+			FScopeLock ScopeLock(&QueryResults->Lock);
+			Completed = MoveTemp(QueryResults->Completed);
+		}
+
+		if (Completed.IsEmpty())
+		{
+			const double RemainingTime = Deadline - FPlatformTime::Seconds();
+			if (RemainingTime <= 0.0)
+			{
+				break;
+			}
+
+			QueryResults->CompletedEvent->Wait(FTimespan::FromSeconds(RemainingTime));
+			continue;
+		}
+
+		const double RefreshTime = FPlatformTime::Seconds() - StartTime;
+		SlowestRefreshTime = FMath::Max(SlowestRefreshTime, RefreshTime);
+
+		FScopeLock ScopeLock(&Lock);
+
+		for (TPair<int32, TArray<FZenSnapshotDescriptor>>& Result : Completed)
+		{
+			PendingQueries[Result.Key] = false;
+			--NumPendingQueries;
+
+			FProvider& Provider = *CurrentProviders[Result.Key];
+			if (Provider.bRemoved)
+			{
+				continue;
+			}
+
+			Provider.Version = MoveTemp(Versions[Result.Key]);
+			Provider.SnapshotDescriptors = MoveTemp(Result.Value);
+			Provider.Stats.LastRefreshTime = RefreshTime;
+			Provider.Stats.bLastRefreshChanged = true;
+			Provider.Stats.bLastRefreshTimedOut = false;
+			Provider.Stats.NumSnapshots = Provider.SnapshotDescriptors.Num();
+
+			UE_LOGFMT(LogZenSnapshotSync, Verbose, "Refreshed snapshot provider '{Name}' in {Time}ms", Provider.Name, RefreshTime * 1000.0);
+			FZenSnapshotSyncMetrics::Get().RecordProviderRefresh(Provider.Name, RefreshTime, false);
+		}
+
+		PublishSnapshotDescriptors();
+	}
+
+	FScopeLock ScopeLock(&Lock);
+
+	for (TConstSetBitIterator<> It(PendingQueries); It; ++It)
+	{
+		FProvider& Provider = *CurrentProviders[It.GetIndex()];
+		if (Provider.bRemoved)
+		{
+			continue;
+		}
+
+		Provider.Stats.LastRefreshTime = ProviderTimeout;
+		Provider.Stats.bLastRefreshChanged = false;
+		Provider.Stats.bLastRefreshTimedOut = true;
+
+		UE_LOGFMT(LogZenSnapshotSync, Warning, "Snapshot provider '{Name}' did not respond within {Timeout}s, keeping its previous snapshots", Provider.Name, ProviderTimeout);
+		FZenSnapshotSyncMetrics::Get().RecordProviderRefresh(Provider.Name, ProviderTimeout, true);
+	}
+
+	if (NumPendingQueries > 0)
+	{
+		SlowestRefreshTime = ProviderTimeout;
+	}
+
+	// Also drops providers removed since the last refresh
+	PublishSnapshotDescriptors();
+
+	SET_FLOAT_STAT(STAT_ZenSnapshotSync_SlowestProviderRefresh, SlowestRefreshTime * 1000.0);
+}
+
+void FZenSnapshotSyncDescriptorCache::PublishSnapshotDescriptors()
+{
+	TSharedRef<TArray<FZenSnapshotDescriptor>> NewSnapshotDescriptors = MakeShared<TArray<FZenSnapshotDescriptor>>();
+	TSet<TPair<FString, FString>> SeenSnapshots;
+
+	// First provider to list a snapshot for a platform wins
+	for (const TSharedRef<FProvider>& Provider : Providers)
+	{
+		for (const FZenSnapshotDescriptor& SnapshotDescriptor : Provider->SnapshotDescriptors)
+		{
+			bool bAlreadySeen = false;
+			SeenSnapshots.Add(TPair<FString, FString>(SnapshotDescriptor.GetName(), SnapshotDescriptor.GetTargetPlatform()), &bAlreadySeen);
+
+			if (!bAlreadySeen)
+			{
+				NewSnapshotDescriptors->Add(SnapshotDescriptor);
+			}
+		}
+	}
+
+	SnapshotDescriptors = NewSnapshotDescriptors;
+
+	SET_DWORD_STAT(STAT_ZenSnapshotSync_CachedSnapshots, NewSnapshotDescriptors->Num());
+}
+
+bool FZenSnapshotSyncDescriptorCache::Tick(float DeltaTime)
+{
+	RunGameThreadQueries();
+	return true;
+}
+
+void FZenSnapshotSyncDescriptorCache::RunGameThreadQueries()
+{
+	check(IsInGameThread());
+
+	TArray<FGameThreadQuery> Queries;
+	{
+		FScopeLock ScopeLock(&Lock);
+		Queries = MoveTemp(GameThreadQueries);
+	}
+
+	for (FGameThreadQuery& Query : Queries)
+	{
+		TArray<FZenSnapshotDescriptor> ProviderSnapshotDescriptors;
+		Query.Callback.ExecuteIfBound(ProviderSnapshotDescriptors);
+		Query.Promise.SetValue(MoveTemp(ProviderSnapshotDescriptors));
+	}
+}
+
+void FZenSnapshotSyncDescriptorCache::Wait(const TFuture<void>& Future)
+{
+	if (!Future.IsValid())
+	{
+		return;
+	}
+
+	if (!IsInGameThread())
+	{
+		Future.Wait();
+		return;
+	}
+
+	while (!Future.WaitFor(FTimespan::FromSeconds(GameThreadWaitInterval)))
+	{
+		RunGameThreadQueries();
+	}
+}
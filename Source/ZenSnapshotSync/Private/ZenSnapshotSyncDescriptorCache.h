@@ -0,0 +1,81 @@
+#pragma once
+
+#include <Async/Future.h>
+#include <Containers/Array.h>
+#include <Containers/Ticker.h>
+#include <HAL/CriticalSection.h>
+
+#include "ZenSnapshotSyncModule.h"
+
+// Last known snapshot descriptors of all providers, refreshed on the thread pool and published as each provider responds
+class FZenSnapshotSyncDescriptorCache
+{
+public:
+	FZenSnapshotSyncDescriptorCache();
+	~FZenSnapshotSyncDescriptorCache();
+
+	FDelegateHandle AddProvider(FString Name, FZenSnapshotSyncModule::FQuerySnapshotsAsyncDelegate&& Callback, FZenSnapshotSyncModule::FQuerySnapshotsVersionDelegate&& VersionCallback);
+
+	// Synchronous providers are queried on the game thread, by the core ticker or while the game thread waits for a refresh
+	FDelegateHandle AddProvider(FString Name, FZenSnapshotSyncModule::FQuerySnapshotsDelegate&& Callback, FZenSnapshotSyncModule::FQuerySnapshotsVersionDelegate&& VersionCallback);
+	void RemoveProvider(FDelegateHandle ProviderHandle);
+	bool HasProviders() const;
+
+	// Game thread only, requests made during a refresh are coalesced into one follow-up pass
+	void Refresh();
+	void WaitForRefresh();
+
+	TSharedRef<const TArray<FZenSnapshotDescriptor>> GetSnapshotDescriptors() const;
+	TArray<FZenSnapshotProviderStats> GetProviderStats() const;
+
+private:
+	struct FProvider
+	{
+		FDelegateHandle Handle;
+		FString Name;
+		FZenSnapshotSyncModule::FQuerySnapshotsAsyncDelegate Callback;
+		FZenSnapshotSyncModule::FQuerySnapshotsVersionDelegate VersionCallback;
+
+		// Guarded by the cache lock
+		FString Version;
+		TArray<FZenSnapshotDescriptor> SnapshotDescriptors;
+		FZenSnapshotProviderStats Stats;
+
+		// Not queried again while pending
+		TFuture<void> PendingQuery;
+
+		// Held while a callback runs, removal only waits for that and not for pending queries
+		FCriticalSection CallbackLock;
+		bool bRemoved = false;
+	};
+
+	struct FGameThreadQuery
+	{
+		FDelegateHandle ProviderHandle;
+		FZenSnapshotSyncModule::FQuerySnapshotsDelegate Callback;
+		TPromise<TArray<FZenSnapshotDescriptor>> Promise;
+	};
+
+	static constexpr double ProviderTimeout = 10.0;
+	static constexpr float GameThreadWaitInterval = 0.01f;
+
+	FDelegateHandle AddProvider(FDelegateHandle ProviderHandle, FString Name, FZenSnapshotSyncModule::FQuerySnapshotsAsyncDelegate&& Callback, FZenSnapshotSyncModule::FQuerySnapshotsVersionDelegate&& VersionCallback);
+
+	void RefreshProviders();
+	void PublishSnapshotDescriptors();
+
+	bool Tick(float DeltaTime);
+	void RunGameThreadQueries();
+
+	void Wait(const TFuture<void>& Future);
+
+	mutable FCriticalSection Lock;
+	TArray<TSharedRef<FProvider>> Providers;
+	TSharedRef<const TArray<FZenSnapshotDescriptor>> SnapshotDescriptors;
+	TFuture<void> PendingRefresh;
+	bool bRefreshRunning = false;
+	bool bRefreshRequested = false;
+
+	TArray<FGameThreadQuery> GameThreadQueries;
+	FTSTicker::FDelegateHandle TickHandle;
+};
@@ -0,0 +1,245 @@
+#include "ZenSnapshotSyncJobMonitor.h"
+
+#include <HAL/Event.h>
+#include <HAL/PlatformProcess.h>
+#include <HAL/PlatformTime.h>
+#include <HAL/RunnableThread.h>
+#include <Misc/Timespan.h>
+
+namespace
+{
+	bool HasStatusChanged(const FZenSnapshotSyncHandle& Previous, const FZenSnapshotSyncHandle& Current)
+	{
+		return Previous.IsComplete() != Current.IsComplete()
+			|| Previous.IsError() != Current.IsError()
+			|| Previous.GetState() != Current.GetState()
+			|| Previous.GetStateProgress() != Current.GetStateProgress();
+	}
+}
+
+FZenSnapshotSyncJobMonitor::FZenSnapshotSyncJobMonitor(const FZenSnapshotSyncModule& InModule)
+	: Module(InModule)
+{
+	WakeEvent = FPlatformProcess::GetSynchEventFromPool();
+	DispatchTickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FZenSnapshotSyncJobMonitor::DispatchStatusUpdates));
+	Thread = FRunnableThread::Create(this, TEXT("ZenSnapshotSyncJobMonitor"), 0, TPri_BelowNormal);
+}
+
+FZenSnapshotSyncJobMonitor::~FZenSnapshotSyncJobMonitor()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(DispatchTickHandle);
+
+	StopPolling();
+
+	FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+	WakeEvent = nullptr;
+}
+
+void FZenSnapshotSyncJobMonitor::StopPolling()
+{
+	if (Thread)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+}
+
+FDelegateHandle FZenSnapshotSyncJobMonitor::Subscribe(const FZenSnapshotSyncHandle& Handle, FZenSnapshotSyncModule::FOnSnapshotSyncStatusChanged&& Callback)
+{
+	check(IsInGameThread());
+
+	if (!Handle.IsValid() || Handle.IsComplete() || Handle.IsError())
+	{
+		return FDelegateHandle();
+	}
+
+	const FDelegateHandle SubscriptionHandle(FDelegateHandle::GenerateNewHandle);
+	Callbacks.Add(SubscriptionHandle, MoveTemp(Callback));
+
+	{
+		FScopeLock Lock(&SubscriptionsLock);
+
+		FSubscription& Subscription = Subscriptions.Emplace_GetRef();
+		Subscription.SubscriptionHandle = SubscriptionHandle;
+		Subscription.Handle = Handle;
+	}
+
+	WakeEvent->Trigger();
+
+	return SubscriptionHandle;
+}
+
+void FZenSnapshotSyncJobMonitor::Unsubscribe(FDelegateHandle SubscriptionHandle)
+{
+	check(IsInGameThread());
+
+	if (Callbacks.Remove(SubscriptionHandle) > 0)
+	{
+		FScopeLock Lock(&SubscriptionsLock);
+		Subscriptions.RemoveAll([SubscriptionHandle](const FSubscription& Subscription) { return Subscription.SubscriptionHandle == SubscriptionHandle; });
+	}
+}
+
+void FZenSnapshotSyncJobMonitor::WatchCancellation(const FZenSnapshotSyncHandle& Handle, bool bResendCancellation)
+{
+	{
+		FScopeLock Lock(&SubscriptionsLock);
+
+		FSubscription& Subscription = Subscriptions.Emplace_GetRef();
+		Subscription.SubscriptionHandle = FDelegateHandle(FDelegateHandle::GenerateNewHandle);
+		Subscription.Handle = Handle;
+		Subscription.bCancellation = true;
+		Subscription.bResendCancellation = bResendCancellation;
+	}
+
+	WakeEvent->Trigger();
+}
+
+uint32 FZenSnapshotSyncJobMonitor::Run()
+{
+	TArray<FSubscription> DueSubscriptions;
+	TArray<FZenSnapshotSyncHandle> DueHandles;
+
+	while (!bStopping)
+	{
+		const double CurrentTime = FPlatformTime::Seconds();
+
+		{
+			FScopeLock Lock(&SubscriptionsLock);
+			for (const FSubscription& Subscription : Subscriptions)
+			{
+				if (Subscription.NextPollTime <= CurrentTime)
+				{
+					DueSubscriptions.Add(Subscription);
+				}
+			}
+		}
+
+		// Resent once when the first attempt failed transiently, the job is left alone if that fails too
+		for (int32 Index = DueSubscriptions.Num() - 1; Index >= 0; --Index)
+		{
+			FSubscription& DueSubscription = DueSubscriptions[Index];
+			if (!DueSubscription.bResendCancellation)
+			{
+				continue;
+			}
+
+			DueSubscription.bResendCancellation = false;
+
+			if (!Module.ResendSnapshotSyncCancellation(DueSubscription.Handle))
+			{
+				FScopeLock Lock(&SubscriptionsLock);
+				Subscriptions.RemoveAll([&DueSubscription](const FSubscription& Subscription) { return Subscription.SubscriptionHandle == DueSubscription.SubscriptionHandle; });
+				DueSubscriptions.RemoveAtSwap(Index);
+			}
+		}
+
+		DueHandles.Reset(DueSubscriptions.Num());
+		for (const FSubscription& Subscription : DueSubscriptions)
+		{
+			DueHandles.Add(Subscription.Handle);
+		}
+
+		Module.QuerySnapshotSyncStatuses(DueHandles);
+
+		const double PollTime = FPlatformTime::Seconds();
+		for (int32 Index = 0; Index < DueSubscriptions.Num(); ++Index)
+		{
+			FSubscription& Subscription = DueSubscriptions[Index];
+			FZenSnapshotSyncHandle& Handle = DueHandles[Index];
+
+			const bool bStatusChanged = HasStatusChanged(Subscription.Handle, Handle);
+			const bool bPhaseChanged = Subscription.Handle.GetState() != Handle.GetState();
+
+			// Kept even when nothing visible changed as it carries the rate samples
+			Subscription.Handle = Handle;
+
+			if (Subscription.bCancellation)
+			{
+				Subscription.PollInterval = FMath::Min(Subscription.PollInterval * 2.0, MaxCancelPollInterval);
+			}
+			else if (bStatusChanged)
+			{
+				Subscription.PollInterval = bPhaseChanged ? MinPollInterval : Subscription.PollInterval;
+				StatusUpdates.Enqueue({ Subscription.SubscriptionHandle, MoveTemp(Handle) });
+			}
+			else
+			{
+				Subscription.PollInterval = FMath::Min(Subscription.PollInterval * PollBackoffFactor, MaxPollInterval);
+			}
+
+			Subscription.NextPollTime = PollTime + Subscription.PollInterval;
+		}
+
+		double NextPollTime = CurrentTime + MaxPollInterval;
+
+		{
+			FScopeLock Lock(&SubscriptionsLock);
+			for (const FSubscription& DueSubscription : DueSubscriptions)
+			{
+				const int32 Index = Subscriptions.IndexOfByPredicate([&DueSubscription](const FSubscription& Subscription) { return Subscription.SubscriptionHandle == DueSubscription.SubscriptionHandle; });
+				if (Index == INDEX_NONE)
+				{
+					continue;
+				}
+
+				if (DueSubscription.Handle.IsComplete() || DueSubscription.Handle.IsError())
+				{
+					Subscriptions.RemoveAtSwap(Index);
+				}
+				else
+				{
+					Subscriptions[Index] = DueSubscription;
+				}
+			}
+
+			for (const FSubscription& Subscription : Subscriptions)
+			{
+				NextPollTime = FMath::Min(NextPollTime, Subscription.NextPollTime);
+			}
+		}
+
+		DueSubscriptions.Reset();
+
+		const double WaitTime = NextPollTime - FPlatformTime::Seconds();
+		if (WaitTime > 0.0)
+		{
+			WakeEvent->Wait(FTimespan::FromSeconds(WaitTime));
+		}
+	}
+
+	return 0;
+}
+
+void FZenSnapshotSyncJobMonitor::Stop()
+{
+	bStopping = true;
+	WakeEvent->Trigger();
+}
+
+bool FZenSnapshotSyncJobMonitor::DispatchStatusUpdates(float DeltaTime)
+{
+	FStatusUpdate StatusUpdate;
+	while (StatusUpdates.Dequeue(StatusUpdate))
+	{
+		const FZenSnapshotSyncModule::FOnSnapshotSyncStatusChanged* Callback = Callbacks.Find(StatusUpdate.SubscriptionHandle);
+		if (!Callback)
+		{
+			continue;
+		}
+
+		const bool bFinished = StatusUpdate.Handle.IsComplete() || StatusUpdate.Handle.IsError();
+
+		// Copy the callback as it may unsubscribe while executing
+		const FZenSnapshotSyncModule::FOnSnapshotSyncStatusChanged CallbackCopy = *Callback;
+		if (bFinished)
+		{
+			Callbacks.Remove(StatusUpdate.SubscriptionHandle);
+		}
+
+		CallbackCopy.ExecuteIfBound(StatusUpdate.Handle);
+	}
+
+	return true;
+}
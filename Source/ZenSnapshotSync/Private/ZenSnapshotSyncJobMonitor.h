@@ -0,0 +1,70 @@
+#pragma once
+
+#include <Containers/Map.h>
+#include <Containers/Queue.h>
+#include <Containers/Ticker.h>
+#include <HAL/CriticalSection.h>
+#include <HAL/Runnable.h>
+
+#include "ZenSnapshotSyncModule.h"
+
+class FEvent;
+class FRunnableThread;
+
+// Polls subscribed handles on a worker thread, backing off while a job shows no progress, and dispatches changes on the game thread
+class FZenSnapshotSyncJobMonitor : public FRunnable
+{
+public:
+	explicit FZenSnapshotSyncJobMonitor(const FZenSnapshotSyncModule& InModule);
+	virtual ~FZenSnapshotSyncJobMonitor() override;
+
+	FDelegateHandle Subscribe(const FZenSnapshotSyncHandle& Handle, FZenSnapshotSyncModule::FOnSnapshotSyncStatusChanged&& Callback);
+	void Unsubscribe(FDelegateHandle SubscriptionHandle);
+
+	// Any thread, polls a cancelled handle without a callback until the cancellation is confirmed or times out
+	void WatchCancellation(const FZenSnapshotSyncHandle& Handle, bool bResendCancellation);
+
+	// Waits for the current poll, handles watched afterwards are never polled
+	void StopPolling();
+
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	static constexpr double MinPollInterval = 0.25;
+	static constexpr double MaxPollInterval = 5.0;
+	static constexpr double PollBackoffFactor = 1.5;
+	static constexpr double MaxCancelPollInterval = 1.0;
+
+	struct FSubscription
+	{
+		FDelegateHandle SubscriptionHandle;
+		FZenSnapshotSyncHandle Handle;
+		double PollInterval = MinPollInterval;
+		double NextPollTime = 0.0;
+		bool bCancellation = false;
+		bool bResendCancellation = false;
+	};
+
+	struct FStatusUpdate
+	{
+		FDelegateHandle SubscriptionHandle;
+		FZenSnapshotSyncHandle Handle;
+	};
+
+	bool DispatchStatusUpdates(float DeltaTime);
+
+	const FZenSnapshotSyncModule& Module;
+
+	FCriticalSection SubscriptionsLock;
+	TArray<FSubscription> Subscriptions;
+	TQueue<FStatusUpdate, EQueueMode::Mpsc> StatusUpdates;
+
+	// Only accessed on the game thread
+	TMap<FDelegateHandle, FZenSnapshotSyncModule::FOnSnapshotSyncStatusChanged> Callbacks;
+	FTSTicker::FDelegateHandle DispatchTickHandle;
+
+	FEvent* WakeEvent = nullptr;
+	FRunnableThread* Thread = nullptr;
+	std::atomic<bool> bStopping = false;
+};
@@ -0,0 +1,125 @@
+#include "ZenSnapshotSyncJournal.h"
+
+#include <Dom/JsonObject.h>
+#include <HAL/FileManager.h>
+#include <Logging/StructuredLog.h>
+#include <Misc/Base64.h>
+#include <Misc/FileHelper.h>
+#include <Misc/ScopeLock.h>
+#include <Serialization/CompactBinaryValidation.h>
+#include <Serialization/JsonReader.h>
+#include <Serialization/JsonSerializer.h>
+#include <Serialization/JsonWriter.h>
+
+#include "ZenSnapshotSyncLog.h"
+
+FZenSnapshotSyncJournal::FZenSnapshotSyncJournal(FString InFilePath)
+	: FilePath(MoveTemp(InFilePath))
+{
+	Load();
+}
+
+void FZenSnapshotSyncJournal::Add(FZenSnapshotSyncJournalEntry&& Entry)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	Entries.Add(MoveTemp(Entry));
+	Save();
+}
+
+void FZenSnapshotSyncJournal::Remove(FStringView JobId)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	if (Entries.RemoveAll([JobId](const FZenSnapshotSyncJournalEntry& Entry) { return Entry.JobId == JobId; }) > 0)
+	{
+		Save();
+	}
+}
+
+TArray<FZenSnapshotSyncJournalEntry> FZenSnapshotSyncJournal::GetEntries() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return Entries;
+}
+
+void FZenSnapshotSyncJournal::Load()
+{
+	FString JournalJson;
+	if (!FFileHelper::LoadFileToString(JournalJson, *FilePath, FFileHelper::EHashOptions::None, FILEREAD_Silent))
+	{
+		return;
+	}
+
+	TSharedPtr<FJsonObject> Journal;
+	const TArray<TSharedPtr<FJsonValue>>* Jobs = nullptr;
+
+	if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(JournalJson), Journal) || !Journal.IsValid() || !Journal->TryGetArrayField(TEXT("jobs"), Jobs))
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Warning, "Ignoring unreadable snapshot sync journal '{File}'", FilePath);
+		return;
+	}
+
+	for (const TSharedPtr<FJsonValue>& Job : *Jobs)
+	{
+		const TSharedPtr<FJsonObject>* JobObject = nullptr;
+		if (!Job->TryGetObject(JobObject))
+		{
+			continue;
+		}
+
+		FZenSnapshotSyncJournalEntry Entry;
+		FString EncodedParams;
+		TArray<uint8> Params;
+
+		(*JobObject)->TryGetStringField(TEXT("jobid"), Entry.JobId);
+		(*JobObject)->TryGetStringField(TEXT("name"), Entry.SnapshotName);
+		(*JobObject)->TryGetStringField(TEXT("targetplatform"), Entry.TargetPlatform);
+		(*JobObject)->TryGetStringField(TEXT("oplogid"), Entry.OplogId);
+		(*JobObject)->TryGetStringField(TEXT("params"), EncodedParams);
+
+		if (Entry.JobId.IsEmpty() || Entry.TargetPlatform.IsEmpty() || !FBase64::Decode(EncodedParams, Params)
+			|| ValidateCompactBinary(MakeMemoryView(Params), ECbValidateMode::Default) != ECbValidateError::None)
+		{
+			UE_LOGFMT(LogZenSnapshotSync, Warning, "Ignoring invalid job '{JobId}' in snapshot sync journal", Entry.JobId);
+			continue;
+		}
+
+		Entry.Params = FCbObject::Clone(FCbObjectView(Params.GetData()));
+		Entries.Add(MoveTemp(Entry));
+	}
+}
+
+void FZenSnapshotSyncJournal::Save() const
+{
+	FString JournalJson;
+
+	const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JournalJson);
+	Writer->WriteObjectStart();
+	Writer->WriteArrayStart(TEXT("jobs"));
+
+	for (const FZenSnapshotSyncJournalEntry& Entry : Entries)
+	{
+		TArray<uint8> Params;
+		Params.SetNumUninitialized(Entry.Params.GetSize());
+		Entry.Params.CopyTo(MakeMemoryView(Params));
+
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("jobid"), Entry.JobId);
+		Writer->WriteValue(TEXT("name"), Entry.SnapshotName);
+		Writer->WriteValue(TEXT("targetplatform"), Entry.TargetPlatform);
+		Writer->WriteValue(TEXT("oplogid"), Entry.OplogId);
+		Writer->WriteValue(TEXT("params"), FBase64::Encode(Params));
+		Writer->WriteObjectEnd();
+	}
+
+	Writer->WriteArrayEnd();
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	const FString TempFilePath = FilePath + TEXT(".tmp");
+	if (!FFileHelper::SaveStringToFile(JournalJson, *TempFilePath) || !IFileManager::Get().Move(*FilePath, *TempFilePath))
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Warning, "Failed to write snapshot sync journal '{File}'", FilePath);
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <Containers/Array.h>
+#include <HAL/CriticalSection.h>
+#include <Serialization/CompactBinary.h>
+
+struct FZenSnapshotSyncJournalEntry
+{
+	FString JobId;
+	FString SnapshotName;
+	FString TargetPlatform;
+	FString OplogId;
+	FCbObject Params;
+};
+
+// Import jobs of the project that are still running, persisted so they can be picked up again after a restart
+class FZenSnapshotSyncJournal
+{
+public:
+	explicit FZenSnapshotSyncJournal(FString InFilePath);
+
+	void Add(FZenSnapshotSyncJournalEntry&& Entry);
+	void Remove(FStringView JobId);
+	TArray<FZenSnapshotSyncJournalEntry> GetEntries() const;
+
+private:
+	void Load();
+	void Save() const;
+
+	const FString FilePath;
+
+	mutable FCriticalSection Lock;
+	TArray<FZenSnapshotSyncJournalEntry> Entries;
+};
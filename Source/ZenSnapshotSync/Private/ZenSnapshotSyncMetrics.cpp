@@ -0,0 +1,357 @@
+#include "ZenSnapshotSyncMetrics.h"
+
+#include <HAL/IConsoleManager.h>
+#include <HAL/PlatformTime.h>
+#include <Misc/OutputDevice.h>
+#include <Misc/ScopeLock.h>
+
+#include "ZenSnapshotSyncModule.h"
+
+DEFINE_STAT(STAT_ZenSnapshotSync_HttpRequests);
+DEFINE_STAT(STAT_ZenSnapshotSync_GameThreadBlocked);
+
+namespace ZenSnapshotSyncMetrics
+{
+	static const TCHAR* OperationNames[] =
+	{
+		TEXT("ReadDescriptors"),
+		TEXT("RequestSync"),
+		TEXT("QueryStatus"),
+		TEXT("CancelSync"),
+		TEXT("HttpRequest"),
+	};
+
+	static_assert(UE_ARRAY_COUNT(OperationNames) == static_cast<int32>(EZenSnapshotSyncOperation::Count));
+
+	// Only the outermost timed scope counts towards blocked time
+	static thread_local int32 ScopeDepth = 0;
+
+	static float GetPercentile(const TArray<float>& SortedSamples, double Fraction)
+	{
+		return SortedSamples[FMath::Min(FMath::FloorToInt32(Fraction * SortedSamples.Num()), SortedSamples.Num() - 1)];
+	}
+
+	static FAutoConsoleCommandWithOutputDevice DumpMetricsCommand(
+		TEXT("ZenSnapshotSync.DumpMetrics"),
+		TEXT("Prints request counts, latency percentiles and game thread blocked time of snapshot sync operations, import throughput per source host and refresh times per snapshot provider"),
+		FConsoleCommandWithOutputDeviceDelegate::CreateLambda([](FOutputDevice& Ar)
+		{
+			FZenSnapshotSyncMetrics::Get().Dump(Ar);
+		}));
+
+	static FAutoConsoleCommand ResetMetricsCommand(
+		TEXT("ZenSnapshotSync.ResetMetrics"),
+		TEXT("Clears all collected snapshot sync metrics"),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			FZenSnapshotSyncMetrics::Get().Reset();
+		}));
+
+	static FAutoConsoleCommandWithArgsAndOutputDevice BenchmarkDescriptorsCommand(
+		TEXT("ZenSnapshotSync.BenchmarkDescriptors"),
+		TEXT("Parses a generated descriptor file to measure descriptor read cost. Usage: ZenSnapshotSync.BenchmarkDescriptors [NumSnapshots=10000] [NumIterations=10]"),
+		FConsoleCommandWithArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, FOutputDevice& Ar)
+		{
+			const int32 NumSnapshots = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 10000;
+			const int32 NumIterations = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 10;
+
+			TStringBuilder<1024> SnapshotDescriptorJson;
+			SnapshotDescriptorJson << TEXT("{\"snapshots\":[");
+
+			for (int32 Index = 0; Index < NumSnapshots; ++Index)
+			{
+				SnapshotDescriptorJson << (Index > 0 ? TEXT(",") : TEXT(""));
+				SnapshotDescriptorJson << TEXT("{\"name\":\"Snapshot") << Index << TEXT("\",\"targetplatform\":\"Platform") << (Index % 8) << TEXT("\",");
+
+				switch (Index % 3)
+				{
+				case 0: SnapshotDescriptorJson << TEXT("\"type\":\"file\",\"directory\":\"D:/Snapshots\",\"filename\":\"Snapshot") << Index << TEXT(".oplog\"}"); break;
+				case 1: SnapshotDescriptorJson << TEXT("\"type\":\"cloud\",\"host\":\"https://cloud.example.com\",\"namespace\":\"ue.oplog\",\"bucket\":\"bucket\",\"key\":\"") << Index << TEXT("\"}"); break;
+				default: SnapshotDescriptorJson << TEXT("\"type\":\"zen\",\"host\":\"http://zen.example.com:8558\",\"projectid\":\"project\",\"oplogid\":\"oplog") << Index << TEXT("\"}"); break;
+				}
+			}
+
+			SnapshotDescriptorJson << TEXT("]}");
+
+			double TotalTime = 0.0;
+			double BestTime = DBL_MAX;
+			int32 NumRead = 0;
+
+			for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+			{
+				TArray<FZenSnapshotDescriptor> SnapshotDescriptors;
+				SnapshotDescriptors.Reserve(NumSnapshots);
+
+				const double StartTime = FPlatformTime::Seconds();
+				FZenSnapshotSyncModule::ReadSnapshotDescriptorJson(SnapshotDescriptorJson.ToView(), SnapshotDescriptors);
+				const double Time = FPlatformTime::Seconds() - StartTime;
+
+				TotalTime += Time;
+				BestTime = FMath::Min(BestTime, Time);
+				NumRead = SnapshotDescriptors.Num();
+			}
+
+			Ar.Logf(TEXT("Read %d/%d snapshot descriptors (%d bytes) in %.2fms average, %.2fms best, %.2fus per descriptor"),
+				NumRead, NumSnapshots, static_cast<int32>(SnapshotDescriptorJson.Len() * sizeof(TCHAR)), TotalTime * 1000.0 / NumIterations, BestTime * 1000.0, BestTime * 1000000.0 / NumSnapshots);
+		}));
+}
+
+FZenSnapshotSyncMetrics& FZenSnapshotSyncMetrics::Get()
+{
+	static FZenSnapshotSyncMetrics Metrics;
+	return Metrics;
+}
+
+const TCHAR* FZenSnapshotSyncMetrics::GetOperationName(EZenSnapshotSyncOperation Operation)
+{
+	return ZenSnapshotSyncMetrics::OperationNames[static_cast<int32>(Operation)];
+}
+
+void FZenSnapshotSyncMetrics::RecordOperation(EZenSnapshotSyncOperation Operation, double Duration)
+{
+	if (Operation == EZenSnapshotSyncOperation::HttpRequest)
+	{
+		INC_DWORD_STAT(STAT_ZenSnapshotSync_HttpRequests);
+	}
+
+	FScopeLock ScopeLock(&Lock);
+
+	FOperationMetrics& Metrics = Operations[static_cast<int32>(Operation)];
+	const float Sample = static_cast<float>(Duration * 1000.0);
+
+	if (Metrics.Samples.Num() < MaxSamples)
+	{
+		Metrics.Samples.Add(Sample);
+	}
+	else
+	{
+		Metrics.Samples[Metrics.NextSample] = Sample;
+	}
+
+	Metrics.NextSample = (Metrics.NextSample + 1) % MaxSamples;
+	Metrics.MaxTime = FMath::Max(Metrics.MaxTime, Duration);
+	++Metrics.Count;
+}
+
+void FZenSnapshotSyncMetrics::RecordGameThreadBlocked(double Duration)
+{
+	INC_FLOAT_STAT_BY(STAT_ZenSnapshotSync_GameThreadBlocked, Duration * 1000.0);
+
+	FScopeLock ScopeLock(&Lock);
+
+	GameThreadBlockedTime += Duration;
+	LongestGameThreadBlock = FMath::Max(LongestGameThreadBlock, Duration);
+	++NumGameThreadBlocks;
+}
+
+void FZenSnapshotSyncMetrics::RecordHostQueued(const FString& Host, double QueueTime)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	FHostMetrics& Metrics = Hosts.FindOrAdd(Host);
+	if (Metrics.NumStarted++ == 0)
+	{
+		Metrics.FirstStartTime = FPlatformTime::Seconds();
+	}
+
+	Metrics.QueueTime += QueueTime;
+	Metrics.MaxQueueTime = FMath::Max(Metrics.MaxQueueTime, QueueTime);
+}
+
+void FZenSnapshotSyncMetrics::RecordHostImport(const FString& Host, double ImportTime, bool bSucceeded)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	FHostMetrics& Metrics = Hosts.FindOrAdd(Host);
+	Metrics.ImportTime += ImportTime;
+	Metrics.LastFinishTime = FPlatformTime::Seconds();
+	++Metrics.NumImports;
+
+	if (!bSucceeded)
+	{
+		++Metrics.NumFailed;
+	}
+}
+
+void FZenSnapshotSyncMetrics::RecordProviderRefresh(const FString& Name, double RefreshTime, bool bTimedOut)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	FProviderMetrics& Metrics = Providers.FindOrAdd(Name);
+	Metrics.RefreshTime += RefreshTime;
+	Metrics.MaxRefreshTime = FMath::Max(Metrics.MaxRefreshTime, RefreshTime);
+	Metrics.LastRefreshTime = RefreshTime;
+	++Metrics.NumRefreshes;
+
+	if (bTimedOut)
+	{
+		++Metrics.NumTimeouts;
+	}
+}
+
+void FZenSnapshotSyncMetrics::RecordImportThroughput(int64 NumBytes, double Duration)
+{
+	if (NumBytes <= 0 || Duration <= 0.0)
+	{
+		return;
+	}
+
+	FScopeLock ScopeLock(&Lock);
+
+	const double BytesPerSecond = NumBytes / Duration;
+	ImportThroughput = ImportThroughput > 0.0 ? FMath::Lerp(ImportThroughput, BytesPerSecond, ThroughputSmoothing) : BytesPerSecond;
+}
+
+double FZenSnapshotSyncMetrics::GetImportThroughput() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return ImportThroughput;
+}
+
+void FZenSnapshotSyncMetrics::Reset()
+{
+	FScopeLock ScopeLock(&Lock);
+
+	Hosts.Reset();
+	Providers.Reset();
+
+	for (FOperationMetrics& Metrics : Operations)
+	{
+		Metrics = FOperationMetrics();
+	}
+
+	NumGameThreadBlocks = 0;
+	GameThreadBlockedTime = 0.0;
+	LongestGameThreadBlock = 0.0;
+	ImportThroughput = 0.0;
+}
+
+double FZenSnapshotSyncMetrics::GetPercentile(EZenSnapshotSyncOperation Operation, double Fraction) const
+{
+	FScopeLock ScopeLock(&Lock);
+
+	TArray<float> SortedSamples = Operations[static_cast<int32>(Operation)].Samples;
+	if (SortedSamples.IsEmpty())
+	{
+		return 0.0;
+	}
+
+	SortedSamples.Sort();
+	return ZenSnapshotSyncMetrics::GetPercentile(SortedSamples, Fraction);
+}
+
+uint64 FZenSnapshotSyncMetrics::GetCount(EZenSnapshotSyncOperation Operation) const
+{
+	FScopeLock ScopeLock(&Lock);
+	return Operations[static_cast<int32>(Operation)].Count;
+}
+
+void FZenSnapshotSyncMetrics::Dump(FOutputDevice& Ar) const
+{
+	FScopeLock ScopeLock(&Lock);
+
+	Ar.Logf(TEXT("%-16s %10s %10s %10s %10s"), TEXT("Operation"), TEXT("Count"), TEXT("p50 (ms)"), TEXT("p99 (ms)"), TEXT("Max (ms)"));
+
+	for (int32 Index = 0; Index < UE_ARRAY_COUNT(Operations); ++Index)
+	{
+		const FOperationMetrics& Metrics = Operations[Index];
+		if (Metrics.Count == 0)
+		{
+			continue;
+		}
+
+		TArray<float> SortedSamples = Metrics.Samples;
+		SortedSamples.Sort();
+
+		Ar.Logf(TEXT("%-16s %10llu %10.2f %10.2f %10.2f"), ZenSnapshotSyncMetrics::OperationNames[Index], Metrics.Count,
+			ZenSnapshotSyncMetrics::GetPercentile(SortedSamples, 0.5), ZenSnapshotSyncMetrics::GetPercentile(SortedSamples, 0.99), Metrics.MaxTime * 1000.0);
+	}
+
+	Ar.Logf(TEXT("Game thread blocked %llu times for %.2fms in total, longest %.2fms"), NumGameThreadBlocks, GameThreadBlockedTime * 1000.0, LongestGameThreadBlock * 1000.0);
+	Ar.Logf(TEXT("At most %d HTTP requests in flight at once"), PeakHttpRequests.load());
+
+	if (!Providers.IsEmpty())
+	{
+		Ar.Logf(TEXT("%-40s %10s %10s %14s %14s %14s"), TEXT("Provider"), TEXT("Refreshes"), TEXT("Timeouts"), TEXT("Avg (ms)"), TEXT("Max (ms)"), TEXT("Last (ms)"));
+
+		for (const TPair<FString, FProviderMetrics>& Pair : Providers)
+		{
+			const FProviderMetrics& Metrics = Pair.Value;
+
+			Ar.Logf(TEXT("%-40s %10llu %10llu %14.2f %14.2f %14.2f"), Pair.Key.IsEmpty() ? TEXT("<unnamed>") : *Pair.Key, Metrics.NumRefreshes, Metrics.NumTimeouts,
+				Metrics.NumRefreshes > 0 ? Metrics.RefreshTime * 1000.0 / Metrics.NumRefreshes : 0.0, Metrics.MaxRefreshTime * 1000.0, Metrics.LastRefreshTime * 1000.0);
+		}
+	}
+
+	if (Hosts.IsEmpty())
+	{
+		return;
+	}
+
+	// Measured from the first import started to the last one finished
+	Ar.Logf(TEXT("%-40s %8s %8s %8s %14s %14s %14s %10s"), TEXT("Host"), TEXT("Started"), TEXT("Finished"), TEXT("Failed"),
+		TEXT("Avg queue (s)"), TEXT("Max queue (s)"), TEXT("Avg import (s)"), TEXT("Imports/h"));
+
+	for (const TPair<FString, FHostMetrics>& Pair : Hosts)
+	{
+		const FHostMetrics& Metrics = Pair.Value;
+		const double ActiveTime = Metrics.LastFinishTime - Metrics.FirstStartTime;
+
+		Ar.Logf(TEXT("%-40s %8llu %8llu %8llu %14.1f %14.1f %14.1f %10.1f"), *Pair.Key, Metrics.NumStarted, Metrics.NumImports, Metrics.NumFailed,
+			Metrics.NumStarted > 0 ? Metrics.QueueTime / Metrics.NumStarted : 0.0, Metrics.MaxQueueTime,
+			Metrics.NumImports > 0 ? Metrics.ImportTime / Metrics.NumImports : 0.0,
+			Metrics.NumImports > 0 && ActiveTime > 0.0 ? Metrics.NumImports * 3600.0 / ActiveTime : 0.0);
+	}
+}
+
+FZenSnapshotSyncMetrics::FScopedOperation::FScopedOperation(EZenSnapshotSyncOperation InOperation)
+	: Operation(InOperation)
+	, StartTime(FPlatformTime::Seconds())
+	, bOutermost(ZenSnapshotSyncMetrics::ScopeDepth++ == 0)
+{
+	if (Operation == EZenSnapshotSyncOperation::HttpRequest)
+	{
+		FZenSnapshotSyncMetrics& Metrics = FZenSnapshotSyncMetrics::Get();
+		const int32 NumHttpRequests = ++Metrics.NumHttpRequests;
+
+		int32 PeakHttpRequests = Metrics.PeakHttpRequests;
+		while (NumHttpRequests > PeakHttpRequests && !Metrics.PeakHttpRequests.compare_exchange_weak(PeakHttpRequests, NumHttpRequests))
+		{
+		}
+	}
+}
+
+FZenSnapshotSyncMetrics::FScopedOperation::~FScopedOperation()
+{
+	--ZenSnapshotSyncMetrics::ScopeDepth;
+
+	const double Duration = FPlatformTime::Seconds() - StartTime;
+
+	FZenSnapshotSyncMetrics& Metrics = FZenSnapshotSyncMetrics::Get();
+	if (Operation == EZenSnapshotSyncOperation::HttpRequest)
+	{
+		--Metrics.NumHttpRequests;
+	}
+	Metrics.RecordOperation(Operation, Duration);
+
+	if (bOutermost && IsInGameThread())
+	{
+		Metrics.RecordGameThreadBlocked(Duration);
+	}
+}
+
+FZenSnapshotSyncMetrics::FScopedGameThreadBlock::FScopedGameThreadBlock()
+	: StartTime(FPlatformTime::Seconds())
+	, bOutermost(ZenSnapshotSyncMetrics::ScopeDepth++ == 0)
+{
+}
+
+FZenSnapshotSyncMetrics::FScopedGameThreadBlock::~FScopedGameThreadBlock()
+{
+	--ZenSnapshotSyncMetrics::ScopeDepth;
+
+	if (bOutermost && IsInGameThread())
+	{
+		FZenSnapshotSyncMetrics::Get().RecordGameThreadBlocked(FPlatformTime::Seconds() - StartTime);
+	}
+}
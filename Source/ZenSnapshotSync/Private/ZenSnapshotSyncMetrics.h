@@ -0,0 +1,118 @@
+#pragma once
+
+#include <Containers/Array.h>
+#include <Containers/Map.h>
+#include <HAL/CriticalSection.h>
+#include <Stats/Stats.h>
+
+#include <atomic>
+
+#include "ZenSnapshotSyncStats.h"
+
+enum class EZenSnapshotSyncOperation : uint8
+{
+	ReadDescriptors,
+	RequestSync,
+	QueryStatus,
+	CancelSync,
+	HttpRequest,
+	Count
+};
+
+// Latency and game thread blocked time of the public API, printed by ZenSnapshotSync.DumpMetrics
+class FZenSnapshotSyncMetrics
+{
+public:
+	static FZenSnapshotSyncMetrics& Get();
+	static const TCHAR* GetOperationName(EZenSnapshotSyncOperation Operation);
+
+	void RecordOperation(EZenSnapshotSyncOperation Operation, double Duration);
+	void RecordGameThreadBlocked(double Duration);
+
+	void RecordHostQueued(const FString& Host, double QueueTime);
+	void RecordHostImport(const FString& Host, double ImportTime, bool bSucceeded);
+
+	void RecordProviderRefresh(const FString& Name, double RefreshTime, bool bTimedOut);
+
+	// Bytes per second, 0 until an import of known size finished
+	void RecordImportThroughput(int64 NumBytes, double Duration);
+	double GetImportThroughput() const;
+
+	void Reset();
+	void Dump(FOutputDevice& Ar) const;
+
+	// Milliseconds, 0 until the operation was recorded
+	double GetPercentile(EZenSnapshotSyncOperation Operation, double Fraction) const;
+	uint64 GetCount(EZenSnapshotSyncOperation Operation) const;
+
+	// Time on the game thread also counts as blocked unless an outer scope already does
+	class FScopedOperation
+	{
+	public:
+		explicit FScopedOperation(EZenSnapshotSyncOperation InOperation);
+		~FScopedOperation();
+
+	private:
+		EZenSnapshotSyncOperation Operation;
+		double StartTime;
+		bool bOutermost;
+	};
+
+	// Game thread waiting on work that is timed elsewhere
+	class FScopedGameThreadBlock
+	{
+	public:
+		FScopedGameThreadBlock();
+		~FScopedGameThreadBlock();
+
+	private:
+		double StartTime;
+		bool bOutermost;
+	};
+
+private:
+	static constexpr int32 MaxSamples = 4096;
+	static constexpr double ThroughputSmoothing = 0.3;
+
+	struct FOperationMetrics
+	{
+		// Most recent samples in milliseconds
+		TArray<float> Samples;
+		int32 NextSample = 0;
+		uint64 Count = 0;
+		double MaxTime = 0.0;
+	};
+
+	struct FHostMetrics
+	{
+		uint64 NumStarted = 0;
+		uint64 NumImports = 0;
+		uint64 NumFailed = 0;
+		double QueueTime = 0.0;
+		double MaxQueueTime = 0.0;
+		double ImportTime = 0.0;
+		double FirstStartTime = 0.0;
+		double LastFinishTime = 0.0;
+	};
+
+	struct FProviderMetrics
+	{
+		uint64 NumRefreshes = 0;
+		uint64 NumTimeouts = 0;
+		double RefreshTime = 0.0;
+		double MaxRefreshTime = 0.0;
+		double LastRefreshTime = 0.0;
+	};
+
+	std::atomic<int32> NumHttpRequests = 0;
+	std::atomic<int32> PeakHttpRequests = 0;
+
+	mutable FCriticalSection Lock;
+	TMap<FString, FHostMetrics> Hosts;
+	TMap<FString, FProviderMetrics> Providers;
+	FOperationMetrics Operations[static_cast<int32>(EZenSnapshotSyncOperation::Count)];
+	uint64 NumGameThreadBlocks = 0;
+	double GameThreadBlockedTime = 0.0;
+	double LongestGameThreadBlock = 0.0;
+	double ImportThroughput = 0.0;
+};
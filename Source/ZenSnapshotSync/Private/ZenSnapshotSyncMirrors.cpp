@@ -0,0 +1,231 @@
+#include "ZenSnapshotSyncMirrors.h"
+
+#include <ZenServerHttp.h>
+#include <Algo/StableSort.h>
+#include <Async/Async.h>
+#include <HAL/FileManager.h>
+#include <HAL/PlatformTime.h>
+#include <Logging/StructuredLog.h>
+#include <Misc/Optional.h>
+#include <Misc/Paths.h>
+#include <Misc/ScopeLock.h>
+#include <ProfilingDebugging/CpuProfilerTrace.h>
+
+#include "ZenSnapshotSyncLog.h"
+#include "ZenSnapshotSyncMetrics.h"
+
+FString FZenSnapshotSyncMirrors::GetSourceName(const FZenSnapshotSource& Source)
+{
+	if (const FZenSnapshotFileSource* FileSource = Source.TryGet<FZenSnapshotFileSource>())
+	{
+		return FileSource->Directory;
+	}
+
+	if (const FZenSnapshotCloudSource* CloudSource = Source.TryGet<FZenSnapshotCloudSource>())
+	{
+		return CloudSource->Host;
+	}
+
+	if (const FZenSnapshotZenSource* ZenSource = Source.TryGet<FZenSnapshotZenSource>())
+	{
+		return ZenSource->Host;
+	}
+
+	return FString();
+}
+
+FString FZenSnapshotSyncMirrors::GetSourceName(const FCbObject& Params)
+{
+	if (const FCbObjectView FileParams = Params["file"].AsObjectView(); FileParams)
+	{
+		return FString(FileParams["path"].AsString());
+	}
+
+	if (const FCbObjectView CloudParams = Params["cloud"].AsObjectView(); CloudParams)
+	{
+		return FString(CloudParams["url"].AsString());
+	}
+
+	return FString(Params["zen"].AsObjectView()["url"].AsString());
+}
+
+void FZenSnapshotSyncMirrors::Rank(TArray<FZenSnapshotSource>& Sources)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(ZenSnapshotSync_RankMirrors);
+
+	const double CurrentTime = FPlatformTime::Seconds();
+
+	TArray<FString> SourceNames;
+	TArray<int32> ProbeIndices;
+	{
+		FScopeLock ScopeLock(&Lock);
+
+		for (int32 Index = 0; Index < Sources.Num(); ++Index)
+		{
+			const FString& SourceName = SourceNames.Add_GetRef(GetSourceName(Sources[Index]));
+
+			const FScore* Score = Scores.Find(SourceName);
+			if (!Score || CurrentTime - Score->LastProbeTime >= ProbeInterval)
+			{
+				ProbeIndices.Add(Index);
+			}
+		}
+	}
+
+	// Probed on the thread pool so one stalled host only costs the timeout
+	TArray<TFuture<double>> ProbeFutures;
+	ProbeFutures.Reserve(ProbeIndices.Num());
+
+	for (const int32 ProbeIndex : ProbeIndices)
+	{
+		ProbeFutures.Add(Async(EAsyncExecution::ThreadPool, [Source = Sources[ProbeIndex]]()
+		{
+			return Probe(Source);
+		}));
+	}
+
+	const double ProbeDeadline = FPlatformTime::Seconds() + ProbeTimeout;
+
+	// Late probes are left to finish on their own, their sources are treated as timed out
+	TArray<TOptional<double>> ProbeLatencies;
+	ProbeLatencies.Reserve(ProbeFutures.Num());
+
+	for (TFuture<double>& ProbeFuture : ProbeFutures)
+	{
+		const bool bAnswered = ProbeFuture.WaitFor(FTimespan::FromSeconds(FMath::Max(ProbeDeadline - FPlatformTime::Seconds(), 0.0)));
+		ProbeLatencies.Add(bAnswered ? TOptional<double>(ProbeFuture.Get()) : TOptional<double>());
+	}
+
+	TArray<bool> TimedOutSources;
+	TimedOutSources.SetNumZeroed(Sources.Num());
+	int32 NumTimedOutSources = 0;
+
+	FScopeLock ScopeLock(&Lock);
+
+	for (int32 Index = 0; Index < ProbeIndices.Num(); ++Index)
+	{
+		const FString& SourceName = SourceNames[ProbeIndices[Index]];
+		const bool bAnswered = ProbeLatencies[Index].IsSet();
+		const double ProbeLatency = ProbeLatencies[Index].Get(-1.0);
+
+		FScore& Score = Scores.FindOrAdd(SourceName);
+		Score.LastProbeTime = CurrentTime;
+		Score.bReachable = ProbeLatency >= 0.0;
+
+		if (Score.bReachable)
+		{
+			Score.Latency = Score.Latency < 0.0 ? ProbeLatency : FMath::Lerp(Score.Latency, ProbeLatency, Smoothing);
+		}
+		else if (!bAnswered)
+		{
+			UE_LOGFMT(LogZenSnapshotSync, Warning, "Snapshot source '{Source}' did not answer its probe within {Timeout}s", SourceName, ProbeTimeout);
+			TimedOutSources[ProbeIndices[Index]] = true;
+			++NumTimedOutSources;
+		}
+		else
+		{
+			UE_LOGFMT(LogZenSnapshotSync, Warning, "Snapshot source '{Source}' did not answer its probe", SourceName);
+		}
+	}
+
+	// Untried hosts are assumed to be as fast as the best known one
+	double BestEntriesPerSecond = 0.0;
+	for (const FString& SourceName : SourceNames)
+	{
+		BestEntriesPerSecond = FMath::Max(BestEntriesPerSecond, Scores.FindChecked(SourceName).EntriesPerSecond);
+	}
+
+	TArray<TPair<double, int32>> RankedIndices;
+	for (int32 Index = 0; Index < Sources.Num(); ++Index)
+	{
+		// Dropped unless none answered, the import still needs somewhere to start
+		if (TimedOutSources[Index] && NumTimedOutSources < Sources.Num())
+		{
+			continue;
+		}
+
+		const FScore& Score = Scores.FindChecked(SourceNames[Index]);
+
+		const double EntriesPerSecond = Score.EntriesPerSecond > 0.0 ? Score.EntriesPerSecond : BestEntriesPerSecond;
+		const double ExpectedTime = FMath::Max(Score.Latency, 0.0) + (EntriesPerSecond > 0.0 ? ReferenceEntries / EntriesPerSecond : 0.0);
+
+		RankedIndices.Emplace(IsHealthy(Score, CurrentTime) ? ExpectedTime : TNumericLimits<double>::Max(), Index);
+	}
+
+	// Equally scored sources keep the descriptor order
+	Algo::StableSortBy(RankedIndices, [](const TPair<double, int32>& RankedIndex) { return RankedIndex.Key; });
+
+	TArray<FZenSnapshotSource> RankedSources;
+	RankedSources.Reserve(RankedIndices.Num());
+
+	for (const TPair<double, int32>& RankedIndex : RankedIndices)
+	{
+		RankedSources.Add(MoveTemp(Sources[RankedIndex.Value]));
+	}
+
+	Sources = MoveTemp(RankedSources);
+
+	UE_LOGFMT(LogZenSnapshotSync, Verbose, "Ranked {NumSources} snapshot sources, best is '{Source}'", Sources.Num(), GetSourceName(Sources[0]));
+}
+
+void FZenSnapshotSyncMirrors::RecordImport(const FString& SourceName, double EntriesPerSecond)
+{
+	// Recovered imports do not know their source
+	if (SourceName.IsEmpty())
+	{
+		return;
+	}
+
+	FScopeLock ScopeLock(&Lock);
+
+	FScore& Score = Scores.FindOrAdd(SourceName);
+	Score.NumConsecutiveFailures = 0;
+
+	if (EntriesPerSecond > 0.0)
+	{
+		Score.EntriesPerSecond = Score.EntriesPerSecond > 0.0 ? FMath::Lerp(Score.EntriesPerSecond, EntriesPerSecond, Smoothing) : EntriesPerSecond;
+	}
+}
+
+void FZenSnapshotSyncMirrors::RecordFailure(const FString& SourceName)
+{
+	if (SourceName.IsEmpty())
+	{
+		return;
+	}
+
+	FScopeLock ScopeLock(&Lock);
+
+	FScore& Score = Scores.FindOrAdd(SourceName);
+	Score.LastFailureTime = FPlatformTime::Seconds();
+	++Score.NumConsecutiveFailures;
+}
+
+double FZenSnapshotSyncMirrors::Probe(const FZenSnapshotSource& Source)
+{
+	using namespace UE::Zen;
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	if (const FZenSnapshotFileSource* FileSource = Source.TryGet<FZenSnapshotFileSource>())
+	{
+		return IFileManager::Get().FileSize(*FPaths::Combine(FileSource->Directory, FileSource->FileName)) >= 0 ? FPlatformTime::Seconds() - StartTime : -1.0;
+	}
+
+	const FZenSnapshotCloudSource* CloudSource = Source.TryGet<FZenSnapshotCloudSource>();
+	const FString& Host = CloudSource ? CloudSource->Host : Source.Get<FZenSnapshotZenSource>().Host;
+
+	FZenHttpRequestPool ProbeRequestPool(Host, 1);
+	FZenScopedRequestPtr Request(&ProbeRequestPool);
+
+	FZenSnapshotSyncMetrics::FScopedOperation HttpMetricsScope(EZenSnapshotSyncOperation::HttpRequest);
+	const FZenHttpRequest::Result Result = Request->PerformBlockingDownload(CloudSource ? TEXTVIEW("/health/ready") : TEXTVIEW("/health/"), nullptr, EContentType::Text);
+
+	const double Latency = FPlatformTime::Seconds() - StartTime;
+	return Result == FZenHttpRequest::Result::Success && Request->GetResponseCode() == 200 && Latency < ProbeTimeout ? Latency : -1.0;
+}
+
+bool FZenSnapshotSyncMirrors::IsHealthy(const FScore& Score, double CurrentTime) const
+{
+	return Score.bReachable && (Score.NumConsecutiveFailures < MaxConsecutiveFailures || CurrentTime - Score.LastFailureTime >= FailureCooldown);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <Containers/Array.h>
+#include <Containers/Map.h>
+#include <HAL/CriticalSection.h>
+#include <Serialization/CompactBinary.h>
+
+#include "ZenSnapshotSyncTypes.h"
+
+// Shared by every copy of the handle
+struct FZenSnapshotSyncFailover
+{
+	struct FReplacement
+	{
+		// Empty while the replacement is being requested
+		FString JobId;
+		FString Source;
+		bool bFailed = false;
+	};
+
+	FString SnapshotName;
+	FString ParamsHash;
+	FString TargetPlatform;
+	FZenSnapshotSyncThrottle Throttle;
+	FZenSnapshotSyncOptions Options;
+
+	FCriticalSection Lock;
+	TArray<FZenSnapshotSource> Sources;
+
+	// Aborted jobs mapped to their replacement
+	TMap<FString, FReplacement> Replacements;
+};
+
+// Scores source hosts by probe latency and the entry rate of past imports
+class FZenSnapshotSyncMirrors
+{
+public:
+	static FString GetSourceName(const FZenSnapshotSource& Source);
+	static FString GetSourceName(const FCbObject& Params);
+
+	// Blocking for up to the probe timeout, sorts the sources best first and drops those that timed out
+	void Rank(TArray<FZenSnapshotSource>& Sources);
+
+	void RecordImport(const FString& SourceName, double EntriesPerSecond);
+	void RecordFailure(const FString& SourceName);
+
+private:
+	static constexpr double ProbeInterval = 60.0;
+	static constexpr double ProbeTimeout = 5.0;
+
+	static constexpr double Smoothing = 0.3;
+	static constexpr double ReferenceEntries = 100000.0;
+	static constexpr int32 MaxConsecutiveFailures = 2;
+	static constexpr double FailureCooldown = 300.0;
+
+	struct FScore
+	{
+		double Latency = -1.0;
+		double EntriesPerSecond = 0.0;
+		double LastProbeTime = 0.0;
+		double LastFailureTime = 0.0;
+		int32 NumConsecutiveFailures = 0;
+		bool bReachable = true;
+	};
+
+	// Negative if the probe failed
+	static double Probe(const FZenSnapshotSource& Source);
+
+	bool IsHealthy(const FScore& Score, double CurrentTime) const;
+
+	FCriticalSection Lock;
+	TMap<FString, FScore> Scores;
+};
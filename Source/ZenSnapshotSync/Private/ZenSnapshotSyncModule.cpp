@@ -1,325 +1,1769 @@
 ﻿#include "ZenSnapshotSyncModule.h"
 
+#include <Algo/Find.h>
+#include <Async/Async.h>
+#include <CoreGlobals.h>
+#include <HAL/FileManager.h>
+#include <HAL/PlatformTime.h>
 #include <Logging/StructuredLog.h>
 #include <Misc/App.h>
 #include <Misc/FileHelper.h>
+#include <Misc/Optional.h>
 #include <Misc/Paths.h>
+#include <ProfilingDebugging/CpuProfilerTrace.h>
+#include <ProfilingDebugging/MiscTrace.h>
 #include <Serialization/CompactBinaryWriter.h>
 #include <Serialization/JsonReader.h>
-#include <Serialization/JsonSerializer.h>
+#include <UObject/UnrealType.h>
+
+#include "ZenSnapshotSyncCancellations.h"
+#include "ZenSnapshotSyncDescriptorCache.h"
+#include "ZenSnapshotSyncJobMonitor.h"
+#include "ZenSnapshotSyncJournal.h"
+#include "ZenSnapshotSyncLog.h"
+#include "ZenSnapshotSyncMetrics.h"
+#include "ZenSnapshotSyncMirrors.h"
+#include "ZenSnapshotSyncPrefetcher.h"
+#include "ZenSnapshotSyncPreflight.h"
+#include "ZenSnapshotSyncProjectCache.h"
+#include "ZenSnapshotSyncRequest.h"
+#include "ZenSnapshotSyncRetry.h"
+#include "ZenSnapshotSyncSettings.h"
+#include "ZenSnapshotSyncSharedCache.h"
+#include "ZenSnapshotSyncSlots.h"
+#include "ZenSnapshotSyncTelemetry.h"
+#include "ZenSnapshotSyncThrottler.h"
+#include "ZenSnapshotSyncToolbar.h"
+#include "ZenSnapshotSyncVerifier.h"
+
+DEFINE_LOG_CATEGORY(LogZenSnapshotSync);
+
+IMPLEMENT_MODULE(FZenSnapshotSyncModule, ZenSnapshotSync);
+
+namespace ZenSnapshotSyncModule
+{
+	// Enough for the verifier's workers, the status query helpers and a few imports starting at once, further requests wait for a free entry
+	static constexpr int32 RequestPoolSize = 16;
+}
+
+FZenSnapshotSyncModule::FZenSnapshotSyncModule() = default;
+
+#if WITH_DEV_AUTOMATION_TESTS
+FZenSnapshotSyncModule::FZenSnapshotSyncModule(FStringView ZenUrl, const FString& StateDirectory)
+	: ZenService(ZenUrl)
+{
+	CreateServices(StateDirectory, StateDirectory);
+}
+#endif
+
+FZenSnapshotSyncModule::~FZenSnapshotSyncModule() = default;
+
+void FZenSnapshotSyncModule::StartupModule()
+{
+	CreateServices(FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("ZenSnapshotSync")), FPaths::Combine(FPlatformProcess::UserSettingsDir(), TEXT("ZenSnapshotSync")));
+
+	// Free space can only be checked on the volume of a Zen server this machine launched
+	const UE::Zen::FServiceSettings& ServiceSettings = ZenService.GetInstance().GetServiceSettings();
+	if (ServiceSettings.IsAutoLaunch())
+	{
+		ZenDataPath = ServiceSettings.SettingsVariant.Get<UE::Zen::FServiceAutoLaunchSettings>().DataPath;
+	}
+
+	if (!IsRunningCommandlet())
+	{
+		PendingRecovery = Async(EAsyncExecution::ThreadPool, [this]() { return RecoverSnapshotSyncs(); });
+		RecoveryTickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FZenSnapshotSyncModule::DispatchRecoveredSnapshotSyncs), 0.5f);
+
+		Prefetcher = MakeUnique<FZenSnapshotSyncPrefetcher>(*this);
+		Toolbar = MakeShared<FZenSnapshotSyncToolbar>();
+
+		SettingsChangedHandle = GetMutableDefault<UZenSnapshotSyncSettings>()->OnSettingChanged().AddRaw(this, &FZenSnapshotSyncModule::OnSettingsChanged);
+	}
+}
+
+void FZenSnapshotSyncModule::CreateServices(const FString& StateDirectory, const FString& UserStateDirectory)
+{
+	RequestPool = MakeUnique<UE::Zen::FZenHttpRequestPool>(ZenService.GetInstance().GetURL(), ZenSnapshotSyncModule::RequestPoolSize);
+	ProjectCache = MakeUnique<FZenSnapshotSyncProjectCache>();
+	Verifier = MakeUnique<FZenSnapshotSyncVerifier>(*RequestPool);
+	DescriptorCache = MakeUnique<FZenSnapshotSyncDescriptorCache>();
+	Throttler = MakeUnique<FZenSnapshotSyncThrottler>();
+	Mirrors = MakeUnique<FZenSnapshotSyncMirrors>();
+	JobMonitor = MakeUnique<FZenSnapshotSyncJobMonitor>(*this);
+	Journal = MakeUnique<FZenSnapshotSyncJournal>(FPaths::Combine(StateDirectory, TEXT("Journal.json")));
+	Slots = MakeUnique<FZenSnapshotSyncSlots>(FPaths::Combine(StateDirectory, TEXT("Slots.json")));
+	Cancellations = MakeUnique<FZenSnapshotSyncCancellations>(FPaths::Combine(StateDirectory, TEXT("DirtyOplogs.json")));
+	SharedCache = MakeUnique<FZenSnapshotSyncSharedCache>(FPaths::Combine(UserStateDirectory, TEXT("SharedSnapshots.json")), ZenService.GetInstance().GetURL());
+	TelemetryLog = MakeUnique<FZenSnapshotSyncTelemetryLog>(FPaths::Combine(StateDirectory, TEXT("Telemetry.jsonl")));
+}
+
+void FZenSnapshotSyncModule::ShutdownModule()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(RecoveryTickHandle);
+	RecoveryTickHandle.Reset();
+
+	if (SettingsChangedHandle.IsValid() && UObjectInitialized())
+	{
+		GetMutableDefault<UZenSnapshotSyncSettings>()->OnSettingChanged().Remove(SettingsChangedHandle);
+		SettingsChangedHandle.Reset();
+	}
+
+	if (PendingRecovery.IsValid())
+	{
+		PendingRecovery.Wait();
+	}
+
+	Toolbar.Reset();
+	Prefetcher.Reset();
+	DescriptorCache.Reset();
+
+	// Kept until pending requests finish as cancellations hand their jobs to it
+	JobMonitor->StopPolling();
+
+	Throttler->CancelQueued();
+	Verifier->CancelAll();
+
+	// Pending requests reference the request pool, retries stop once exit is requested so this only waits on requests in flight
+	const double ShutdownEndTime = FPlatformTime::Seconds() + ShutdownTimeout;
+	while (NumPendingRequests > 0 && FPlatformTime::Seconds() < ShutdownEndTime)
+	{
+		FPlatformProcess::Sleep(0.01f);
+	}
+
+	JobMonitor.Reset();
+
+	if (NumPendingRequests > 0)
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Warning, "Abandoning {NumRequests} Zen server requests still in flight on shutdown", NumPendingRequests.load());
+
+		// Leaked as the abandoned requests still hold pooled requests
+		RequestPool.Release();
+	}
+
+	Throttler.Reset();
+}
+
+bool FZenSnapshotSyncModule::ReadSnapshotDescriptorJson(FStringView SnapshotDescriptorJson, TArray<FZenSnapshotDescriptor>& SnapshotDescriptors)
+{
+	FZenSnapshotSyncMetrics::FScopedOperation MetricsScope(EZenSnapshotSyncOperation::ReadDescriptors);
+	TRACE_CPUPROFILER_EVENT_SCOPE(ZenSnapshotSync_ReadDescriptors);
+
+	// Decoded straight into descriptors without building a DOM
+	const TSharedRef<TJsonReader<TCHAR>> JsonReader = TJsonReaderFactory<>::CreateFromView(SnapshotDescriptorJson);
+
+	auto SkipValue = [&JsonReader](EJsonNotation Notation)
+	{
+		switch (Notation)
+		{
+		case EJsonNotation::ObjectStart: return JsonReader->SkipObject();
+		case EJsonNotation::ArrayStart: return JsonReader->SkipArray();
+		case EJsonNotation::Error: return false;
+		default: return true;
+		}
+	};
+
+	struct FSnapshotDescriptorFields
+	{
+		FString Name;
+		FString TargetPlatform;
+		FString Type;
+		FString Host;
+		FString Directory;
+		FString FileName;
+		FString Namespace;
+		FString Bucket;
+		FString Key;
+		FString ProjectId;
+		FString OplogId;
+		FString Priority;
+		int32 MaxConcurrentImports = 0;
+		TArray<FSnapshotDescriptorFields> Mirrors;
+	};
+
+	static const TPair<const TCHAR*, FString FSnapshotDescriptorFields::*> StringFields[] =
+	{
+		{ TEXT("name"), &FSnapshotDescriptorFields::Name },
+		{ TEXT("targetplatform"), &FSnapshotDescriptorFields::TargetPlatform },
+		{ TEXT("type"), &FSnapshotDescriptorFields::Type },
+		{ TEXT("host"), &FSnapshotDescriptorFields::Host },
+		{ TEXT("directory"), &FSnapshotDescriptorFields::Directory },
+		{ TEXT("filename"), &FSnapshotDescriptorFields::FileName },
+		{ TEXT("namespace"), &FSnapshotDescriptorFields::Namespace },
+		{ TEXT("bucket"), &FSnapshotDescriptorFields::Bucket },
+		{ TEXT("key"), &FSnapshotDescriptorFields::Key },
+		{ TEXT("projectid"), &FSnapshotDescriptorFields::ProjectId },
+		{ TEXT("oplogid"), &FSnapshotDescriptorFields::OplogId },
+		{ TEXT("priority"), &FSnapshotDescriptorFields::Priority },
+	};
+
+	static const TPair<const TCHAR*, EZenSnapshotSyncPriority> Priorities[] =
+	{
+		{ TEXT("low"), EZenSnapshotSyncPriority::Low },
+		{ TEXT("normal"), EZenSnapshotSyncPriority::Normal },
+		{ TEXT("high"), EZenSnapshotSyncPriority::High },
+	};
+
+	auto ReadStringField = [&JsonReader](FSnapshotDescriptorFields& Fields)
+	{
+		const FString& Identifier = JsonReader->GetIdentifier();
+		for (const TPair<const TCHAR*, FString FSnapshotDescriptorFields::*>& StringField : StringFields)
+		{
+			if (Identifier == StringField.Key)
+			{
+				Fields.*StringField.Value = JsonReader->GetValueAsString();
+				break;
+			}
+		}
+	};
+
+	auto ReadMirrors = [&JsonReader, &SkipValue, &ReadStringField](TArray<FSnapshotDescriptorFields>& Mirrors)
+	{
+		EJsonNotation Notation = EJsonNotation::Error;
+		while (JsonReader->ReadNext(Notation) && Notation != EJsonNotation::ArrayEnd)
+		{
+			if (Notation != EJsonNotation::ObjectStart)
+			{
+				if (!SkipValue(Notation))
+				{
+					return false;
+				}
+
+				continue;
+			}
+
+			FSnapshotDescriptorFields& Mirror = Mirrors.AddDefaulted_GetRef();
+			while (JsonReader->ReadNext(Notation) && Notation != EJsonNotation::ObjectEnd)
+			{
+				if (Notation == EJsonNotation::String)
+				{
+					ReadStringField(Mirror);
+				}
+				else if (!SkipValue(Notation))
+				{
+					return false;
+				}
+			}
+
+			if (Notation != EJsonNotation::ObjectEnd)
+			{
+				return false;
+			}
+		}
+
+		return Notation == EJsonNotation::ArrayEnd;
+	};
+
+	auto ReadSnapshotDescriptorFields = [&JsonReader, &SkipValue, &ReadStringField, &ReadMirrors](FSnapshotDescriptorFields& Fields)
+	{
+		EJsonNotation Notation = EJsonNotation::Error;
+		while (JsonReader->ReadNext(Notation) && Notation != EJsonNotation::ObjectEnd)
+		{
+			if (Notation == EJsonNotation::Number)
+			{
+				if (JsonReader->GetIdentifier() == TEXT("maxconcurrentimports"))
+				{
+					Fields.MaxConcurrentImports = FMath::Max(static_cast<int32>(JsonReader->GetValueAsNumber()), 0);
+				}
+
+				continue;
+			}
+
+			if (Notation == EJsonNotation::ArrayStart && JsonReader->GetIdentifier() == TEXT("mirrors"))
+			{
+				if (!ReadMirrors(Fields.Mirrors))
+				{
+					return false;
+				}
+
+				continue;
+			}
+
+			if (Notation != EJsonNotation::String)
+			{
+				if (!SkipValue(Notation))
+				{
+					return false;
+				}
+
+				continue;
+			}
+
+			ReadStringField(Fields);
+		}
+
+		return Notation == EJsonNotation::ObjectEnd;
+	};
+
+	// Malformed descriptors are reported on load rather than when syncing
+	auto MakeSource = [](FSnapshotDescriptorFields& Fields, FZenSnapshotSource& Source, const TCHAR*& Error)
+	{
+		if (Fields.Type == TEXT("file"))
+		{
+			if (Fields.Directory.IsEmpty() || Fields.FileName.IsEmpty())
+			{
+				Error = TEXT("file source requires directory and filename");
+				return false;
+			}
+
+			Source.Emplace<FZenSnapshotFileSource>(FZenSnapshotFileSource{ MoveTemp(Fields.Directory), MoveTemp(Fields.FileName) });
+		}
+		else if (Fields.Type == TEXT("cloud"))
+		{
+			if (Fields.Host.IsEmpty() || Fields.Namespace.IsEmpty() || Fields.Bucket.IsEmpty() || Fields.Key.IsEmpty())
+			{
+				Error = TEXT("cloud source requires host, namespace, bucket and key");
+				return false;
+			}
+
+			Source.Emplace<FZenSnapshotCloudSource>(FZenSnapshotCloudSource{ MoveTemp(Fields.Host), MoveTemp(Fields.Namespace), MoveTemp(Fields.Bucket), MoveTemp(Fields.Key) });
+		}
+		else if (Fields.Type == TEXT("zen"))
+		{
+			if (Fields.Host.IsEmpty() || Fields.ProjectId.IsEmpty() || Fields.OplogId.IsEmpty())
+			{
+				Error = TEXT("zen source requires host, projectid and oplogid");
+				return false;
+			}
+
+			Source.Emplace<FZenSnapshotZenSource>(FZenSnapshotZenSource{ MoveTemp(Fields.Host), MoveTemp(Fields.ProjectId), MoveTemp(Fields.OplogId) });
+		}
+		else
+		{
+			Error = TEXT("unknown source type");
+			return false;
+		}
+
+		return true;
+	};
+
+	auto MakeSnapshotDescriptor = [&MakeSource](FSnapshotDescriptorFields&& Fields, FZenSnapshotDescriptor& SnapshotDescriptor, const TCHAR*& Error)
+	{
+		if (Fields.Name.IsEmpty() || Fields.TargetPlatform.IsEmpty())
+		{
+			Error = TEXT("missing name or target platform");
+			return false;
+		}
+
+		if (!MakeSource(Fields, SnapshotDescriptor.Source, Error))
+		{
+			return false;
+		}
+
+		for (FSnapshotDescriptorFields& MirrorFields : Fields.Mirrors)
+		{
+			if (!MakeSource(MirrorFields, SnapshotDescriptor.Mirrors.AddDefaulted_GetRef(), Error))
+			{
+				return false;
+			}
+		}
+
+		if (!Fields.Priority.IsEmpty())
+		{
+			const TPair<const TCHAR*, EZenSnapshotSyncPriority>* Priority = Algo::FindByPredicate(Priorities,
+				[&Fields](const TPair<const TCHAR*, EZenSnapshotSyncPriority>& Entry) { return Fields.Priority == Entry.Key; });
+
+			if (!Priority)
+			{
+				Error = TEXT("unknown priority");
+				return false;
+			}
+
+			SnapshotDescriptor.Throttle.Priority = Priority->Value;
+		}
+
+		SnapshotDescriptor.Throttle.MaxConcurrentImports = Fields.MaxConcurrentImports;
+		SnapshotDescriptor.Name = MoveTemp(Fields.Name);
+		SnapshotDescriptor.TargetPlatform = MoveTemp(Fields.TargetPlatform);
+		SnapshotDescriptor.ImportParams = MakeImportParams(SnapshotDescriptor.Source);
+
+		return true;
+	};
+
+	auto ReadSnapshotDescriptors = [&JsonReader, &SkipValue, &ReadSnapshotDescriptorFields, &MakeSnapshotDescriptor, &SnapshotDescriptors]()
+	{
+		EJsonNotation Notation = EJsonNotation::Error;
+		while (JsonReader->ReadNext(Notation) && Notation != EJsonNotation::ArrayEnd)
+		{
+			if (Notation != EJsonNotation::ObjectStart)
+			{
+				if (!SkipValue(Notation))
+				{
+					return false;
+				}
+
+				continue;
+			}
+
+			FSnapshotDescriptorFields Fields;
+			if (!ReadSnapshotDescriptorFields(Fields))
+			{
+				return false;
+			}
+
+			const FString Name = Fields.Name;
+			const TCHAR* Error = nullptr;
+
+			FZenSnapshotDescriptor SnapshotDescriptor;
+			if (MakeSnapshotDescriptor(MoveTemp(Fields), SnapshotDescriptor, Error))
+			{
+				SnapshotDescriptors.Add(MoveTemp(SnapshotDescriptor));
+			}
+			else
+			{
+				UE_LOGFMT(LogZenSnapshotSync, Warning, "Ignoring snapshot descriptor '{Name}': {Error}", Name, Error);
+			}
+		}
+
+		return Notation == EJsonNotation::ArrayEnd;
+	};
+
+	EJsonNotation Notation = EJsonNotation::Error;
+	if (!JsonReader->ReadNext(Notation) || Notation != EJsonNotation::ObjectStart)
+	{
+		return false;
+	}
+
+	while (JsonReader->ReadNext(Notation) && Notation != EJsonNotation::ObjectEnd)
+	{
+		const bool bResult = Notation == EJsonNotation::ArrayStart && JsonReader->GetIdentifier() == TEXT("snapshots") ? ReadSnapshotDescriptors() : SkipValue(Notation);
+		if (!bResult)
+		{
+			return false;
+		}
+	}
+
+	return Notation == EJsonNotation::ObjectEnd;
+}
+
+bool FZenSnapshotSyncModule::ReadSnapshotDescriptorFile(const TCHAR* SnapshotDescriptorFilePath, TArray<FZenSnapshotDescriptor>& SnapshotDescriptors)
+{
+	FString SnapshotDescriptorJson;
+	if (!FFileHelper::LoadFileToString(SnapshotDescriptorJson, SnapshotDescriptorFilePath))
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Error, "Failed to read snapshot descriptor file '{File}'", SnapshotDescriptorFilePath);
+		return false;
+	}
+
+	return ReadSnapshotDescriptorJson(SnapshotDescriptorJson, SnapshotDescriptors);
+}
+
+FZenSnapshotSyncHandle FZenSnapshotSyncModule::RequestSnapshotSync(const FZenSnapshotDescriptor& SnapshotDescriptor, const FZenSnapshotSyncOptions& InOptions) const
+{
+	FZenSnapshotSyncMetrics::FScopedGameThreadBlock MetricsScope;
+
+	// Waiting for a slot would need the game thread this blocks
+	FZenSnapshotSyncOptions Options = InOptions;
+	Options.bWaitForSlot = false;
+
+	return RequestSnapshotSyncAsync(SnapshotDescriptor, Options).Get();
+}
+
+FZenSnapshotSyncHandle FZenSnapshotSyncModule::RequestSnapshotSyncFromFile(FStringView TargetPlatform, FStringView Directory, FStringView FileName, const FZenSnapshotSyncOptions& InOptions) const
+{
+	FZenSnapshotSyncMetrics::FScopedGameThreadBlock MetricsScope;
+
+	FZenSnapshotSyncOptions Options = InOptions;
+	Options.bWaitForSlot = false;
+
+	return RequestSnapshotSyncFromFileAsync(TargetPlatform, Directory, FileName, Options).Get();
+}
+
+FZenSnapshotSyncHandle FZenSnapshotSyncModule::RequestSnapshotSyncFromCloud(FStringView TargetPlatform, FStringView Host, FStringView Namespace, FStringView Bucket, FStringView Key, const FZenSnapshotSyncOptions& InOptions) const
+{
+	FZenSnapshotSyncMetrics::FScopedGameThreadBlock MetricsScope;
+
+	FZenSnapshotSyncOptions Options = InOptions;
+	Options.bWaitForSlot = false;
+
+	return RequestSnapshotSyncFromCloudAsync(TargetPlatform, Host, Namespace, Bucket, Key, Options).Get();
+}
+
+FZenSnapshotSyncHandle FZenSnapshotSyncModule::RequestSnapshotSyncFromZen(FStringView TargetPlatform, FStringView Host, FStringView Project, FStringView Oplog, const FZenSnapshotSyncOptions& InOptions) const
+{
+	FZenSnapshotSyncMetrics::FScopedGameThreadBlock MetricsScope;
+
+	FZenSnapshotSyncOptions Options = InOptions;
+	Options.bWaitForSlot = false;
+
+	return RequestSnapshotSyncFromZenAsync(TargetPlatform, Host, Project, Oplog, Options).Get();
+}
+
+TFuture<FZenSnapshotSyncHandle> FZenSnapshotSyncModule::RequestSnapshotSyncAsync(const FZenSnapshotDescriptor& SnapshotDescriptor, const FZenSnapshotSyncOptions& Options) const
+{
+	if (SnapshotDescriptor.Source.IsType<FEmptyVariantState>())
+	{
+		return MakeFulfilledPromise<FZenSnapshotSyncHandle>().GetFuture();
+	}
+
+	// Full imports must not be served from what a Default import left in place
+	if (Prefetcher.IsValid() && IsInGameThread() && Options.bActivate && Options.OplogId.IsEmpty() && Options.Mode != EZenSnapshotSyncMode::Full)
+	{
+		FZenSnapshotSyncHandle PrefetchedHandle;
+		FString PrefetchedOplogId;
+
+		if (Prefetcher->TakePrefetched(SnapshotDescriptor, PrefetchedHandle, PrefetchedOplogId))
+		{
+			return ActivateOplogAsync(SnapshotDescriptor.TargetPlatform, MoveTemp(PrefetchedOplogId), MoveTemp(PrefetchedHandle));
+		}
+	}
+
+	// Full imports rewrite the slot rather than switch to what it holds
+	FZenSnapshotSyncSlot ResidentSlot;
+	if (Options.bActivate && Options.OplogId.IsEmpty() && Options.Mode != EZenSnapshotSyncMode::Full && FZenSnapshotSyncSlots::IsEnabled()
+		&& Slots->TakeResident(SnapshotDescriptor.TargetPlatform, SnapshotDescriptor.Name, FZenSnapshotSyncSlots::MakeParamsHash(SnapshotDescriptor.ImportParams), ResidentSlot))
+	{
+		return ActivateSlotAsync(SnapshotDescriptor, Options, MoveTemp(ResidentSlot.OplogId), MoveTemp(ResidentSlot.JobId));
+	}
+
+	if (!SnapshotDescriptor.Mirrors.IsEmpty())
+	{
+		return RequestSnapshotSyncFromMirrorsAsync(SnapshotDescriptor, Options);
+	}
+
+	return RequestSnapshotSyncAsync(SnapshotDescriptor.TargetPlatform, SnapshotDescriptor.Name, FZenSnapshotSyncSlots::MakeParamsHash(SnapshotDescriptor.ImportParams),
+		SnapshotDescriptor.ImportParams, GetSourceHost(SnapshotDescriptor.Source), SnapshotDescriptor.Throttle, Options);
+}
+
+TFuture<FZenSnapshotSyncHandle> FZenSnapshotSyncModule::RequestSnapshotSyncFromMirrorsAsync(const FZenSnapshotDescriptor& SnapshotDescriptor, const FZenSnapshotSyncOptions& Options) const
+{
+	// Prefetcher is game thread only
+	if (Prefetcher.IsValid() && IsInGameThread() && Options.bActivate && Options.OplogId.IsEmpty())
+	{
+		Prefetcher->CancelPrefetch(SnapshotDescriptor.TargetPlatform);
+	}
+
+	TSharedRef<FZenSnapshotSyncFailover> Failover = MakeShared<FZenSnapshotSyncFailover>();
+	Failover->SnapshotName = SnapshotDescriptor.Name;
+	Failover->ParamsHash = FZenSnapshotSyncSlots::MakeParamsHash(SnapshotDescriptor.ImportParams);
+	Failover->TargetPlatform = SnapshotDescriptor.TargetPlatform;
+	Failover->Throttle = SnapshotDescriptor.Throttle;
+	Failover->Options = Options;
+	Failover->Sources.Add(SnapshotDescriptor.Source);
+	Failover->Sources.Append(SnapshotDescriptor.Mirrors);
+
+	TSharedRef<TPromise<FZenSnapshotSyncHandle>> Promise = MakeShared<TPromise<FZenSnapshotSyncHandle>>();
+	TFuture<FZenSnapshotSyncHandle> Future = Promise->GetFuture();
+
+	++NumPendingRequests;
+
+	Async(EAsyncExecution::ThreadPool, [this, Failover, Promise]()
+	{
+		FZenSnapshotSource Source;
+		{
+			FScopeLock ScopeLock(&Failover->Lock);
+
+			Mirrors->Rank(Failover->Sources);
+			Source = Failover->Sources[0];
+			Failover->Sources.RemoveAt(0);
+		}
+
+		UE_LOGFMT(LogZenSnapshotSync, Display, "Importing snapshot '{Name}' from '{Source}'", Failover->SnapshotName, FZenSnapshotSyncMirrors::GetSourceName(Source));
+
+		RequestSnapshotSyncAsync(Failover->TargetPlatform, Failover->SnapshotName, Failover->ParamsHash, MakeImportParams(Source), GetSourceHost(Source), Failover->Throttle, Failover->Options)
+			.Next([Failover, Promise](FZenSnapshotSyncHandle Handle)
+			{
+				if (Handle.IsValid())
+				{
+					Handle.Failover = Failover;
+				}
+
+				Promise->SetValue(MoveTemp(Handle));
+			});
+
+		--NumPendingRequests;
+	});
+
+	return Future;
+}
+
+bool FZenSnapshotSyncModule::FailOverSnapshotSync(FZenSnapshotSyncHandle& Handle, FStringView AbortReason) const
+{
+	if (!Handle.Failover.IsValid())
+	{
+		return false;
+	}
+
+	const TSharedRef<FZenSnapshotSyncFailover> Failover = Handle.Failover.ToSharedRef();
+
+	FZenSnapshotSyncFailover::FReplacement Replacement;
+	bool bStartFailover = false;
+	{
+		FScopeLock ScopeLock(&Failover->Lock);
+
+		if (const FZenSnapshotSyncFailover::FReplacement* ExistingReplacement = Failover->Replacements.Find(Handle.JobId))
+		{
+			Replacement = *ExistingReplacement;
+		}
+		else if (!Failover->Sources.IsEmpty())
+		{
+			Failover->Replacements.Add(Handle.JobId);
+			bStartFailover = true;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	// The copy of the handle that saw the job abort first finishes it and requests the replacement
+	if (bStartFailover)
+	{
+		Journal->Remove(Handle.JobId);
+		Throttler->Finish(Handle.JobId, false);
+		SharedCache->Finish(Handle.JobId, false);
+		Mirrors->RecordFailure(Handle.Telemetry.Source);
+
+		FailOverToNextSource(Failover, Handle.JobId, Handle.Telemetry, FString(AbortReason));
+	}
+
+	if (Replacement.bFailed)
+	{
+		return false;
+	}
+
+	if (Replacement.JobId.IsEmpty())
+	{
+		Handle.State = TEXT("FailingOver");
+		Handle.StateProgress = 0.0f;
+		return true;
+	}
+
+	Handle.JobId = MoveTemp(Replacement.JobId);
+	Handle.Telemetry.Source = MoveTemp(Replacement.Source);
+	Handle.State.Reset();
+	Handle.StateProgress = 0.0f;
+	Handle.RateEstimator.Reset();
+	Handle.FirstFailedPollTime = 0.0;
+
+	return true;
+}
+
+void FZenSnapshotSyncModule::FailOverToNextSource(TSharedRef<FZenSnapshotSyncFailover> Failover, FString AbortedJobId, FZenSnapshotSyncTelemetry AbortedTelemetry, FString AbortReason) const
+{
+	FZenSnapshotSource Source;
+	{
+		FScopeLock ScopeLock(&Failover->Lock);
+
+		if (Failover->Sources.IsEmpty())
+		{
+			Failover->Replacements.FindChecked(AbortedJobId).bFailed = true;
+			ScopeLock.Unlock();
+
+			UE_LOGFMT(LogZenSnapshotSync, Error, "Import of snapshot '{Name}' aborted ({Reason}) and no mirror could replace it", Failover->SnapshotName, AbortReason);
+			Verifier->DiscardBaseline(AbortedTelemetry.OplogId);
+			TelemetryLog->Write(AbortedJobId, AbortedTelemetry, TEXT("aborted"));
+			return;
+		}
+
+		Source = Failover->Sources[0];
+		Failover->Sources.RemoveAt(0);
+	}
+
+	UE_LOGFMT(LogZenSnapshotSync, Warning, "Import of snapshot '{Name}' from '{AbortedSource}' aborted ({Reason}), failing over to '{Source}'",
+		Failover->SnapshotName, AbortedTelemetry.Source, AbortReason, FZenSnapshotSyncMirrors::GetSourceName(Source));
+
+	FZenSnapshotSyncOptions Options = Failover->Options;
+	Options.OplogId = AbortedTelemetry.OplogId;
+	Options.bWaitForSlot = true;
+
+	RequestSnapshotSyncAsync(Failover->TargetPlatform, Failover->SnapshotName, Failover->ParamsHash, MakeImportParams(Source), GetSourceHost(Source), Failover->Throttle, Options)
+		.Next([this, Failover, AbortedJobId = MoveTemp(AbortedJobId), AbortedTelemetry = MoveTemp(AbortedTelemetry), AbortReason = MoveTemp(AbortReason)](FZenSnapshotSyncHandle Handle) mutable
+		{
+			if (!Handle.IsValid())
+			{
+				FailOverToNextSource(Failover, MoveTemp(AbortedJobId), MoveTemp(AbortedTelemetry), MoveTemp(AbortReason));
+				return;
+			}
+
+			FScopeLock ScopeLock(&Failover->Lock);
+
+			FZenSnapshotSyncFailover::FReplacement& Replacement = Failover->Replacements.FindChecked(AbortedJobId);
+			Replacement.JobId = Handle.JobId;
+			Replacement.Source = Handle.Telemetry.Source;
+		});
+}
+
+TFuture<FZenSnapshotSyncHandle> FZenSnapshotSyncModule::RequestSnapshotSyncFromFileAsync(FStringView TargetPlatform, FStringView Directory, FStringView FileName, const FZenSnapshotSyncOptions& Options) const
+{
+	const FZenSnapshotSource Source(TInPlaceType<FZenSnapshotFileSource>(), FZenSnapshotFileSource{ FString(Directory), FString(FileName) });
+	return RequestSnapshotSyncAsync(TargetPlatform, FStringView(), FStringView(), MakeImportParams(Source), GetSourceHost(Source), FZenSnapshotSyncThrottle(), Options);
+}
+
+TFuture<FZenSnapshotSyncHandle> FZenSnapshotSyncModule::RequestSnapshotSyncFromCloudAsync(FStringView TargetPlatform, FStringView Host, FStringView Namespace, FStringView Bucket, FStringView Key, const FZenSnapshotSyncOptions& Options) const
+{
+	const FZenSnapshotSource Source(TInPlaceType<FZenSnapshotCloudSource>(), FZenSnapshotCloudSource{ FString(Host), FString(Namespace), FString(Bucket), FString(Key) });
+	return RequestSnapshotSyncAsync(TargetPlatform, FStringView(), FStringView(), MakeImportParams(Source), GetSourceHost(Source), FZenSnapshotSyncThrottle(), Options);
+}
+
+TFuture<FZenSnapshotSyncHandle> FZenSnapshotSyncModule::RequestSnapshotSyncFromZenAsync(FStringView TargetPlatform, FStringView Host, FStringView Project, FStringView Oplog, const FZenSnapshotSyncOptions& Options) const
+{
+	const FZenSnapshotSource Source(TInPlaceType<FZenSnapshotZenSource>(), FZenSnapshotZenSource{ FString(Host), FString(Project), FString(Oplog) });
+	return RequestSnapshotSyncAsync(TargetPlatform, FStringView(), FStringView(), MakeImportParams(Source), GetSourceHost(Source), FZenSnapshotSyncThrottle(), Options);
+}
+
+bool FZenSnapshotSyncModule::IsSnapshotResident(const FZenSnapshotDescriptor& SnapshotDescriptor) const
+{
+	return FZenSnapshotSyncSlots::IsEnabled() && Slots->IsResident(SnapshotDescriptor.TargetPlatform, SnapshotDescriptor.Name, FZenSnapshotSyncSlots::MakeParamsHash(SnapshotDescriptor.ImportParams));
+}
+
+TFuture<FZenSnapshotSyncEstimate> FZenSnapshotSyncModule::EstimateSnapshotSyncAsync(const FZenSnapshotDescriptor& SnapshotDescriptor) const
+{
+	return Async(EAsyncExecution::ThreadPool, [Params = SnapshotDescriptor.ImportParams, DataPath = ZenDataPath]()
+	{
+		return FZenSnapshotSyncPreflight::Estimate(Params, DataPath);
+	});
+}
+
+TFuture<FZenSnapshotSyncHandle> FZenSnapshotSyncModule::RequestSnapshotSyncAsync(FStringView TargetPlatform, FStringView SnapshotName, FStringView ParamsHash, FCbObject Params, FString SourceHost, const FZenSnapshotSyncThrottle& Throttle, FZenSnapshotSyncOptions Options) const
+{
+	// Prefetches may be importing into the oplog this is about to use
+	if (Prefetcher.IsValid() && IsInGameThread() && Options.bActivate && Options.OplogId.IsEmpty())
+	{
+		Prefetcher->CancelPrefetch(FString(TargetPlatform));
+	}
+
+	if (Options.OplogId.IsEmpty() && !SnapshotName.IsEmpty() && FZenSnapshotSyncSlots::IsEnabled())
+	{
+		Options.OplogId = Slots->Acquire(TargetPlatform, SnapshotName, ParamsHash);
+	}
+
+	// Prefetches are simply started again after a restart
+	TOptional<FZenSnapshotSyncJournalEntry> JournalEntry;
+	if (Options.bActivate)
+	{
+		JournalEntry.Emplace();
+		JournalEntry->SnapshotName = FString(SnapshotName);
+		JournalEntry->TargetPlatform = FString(TargetPlatform);
+		JournalEntry->OplogId = Options.OplogId.IsEmpty() ? JournalEntry->TargetPlatform : Options.OplogId;
+		JournalEntry->Params = Params;
+	}
+
+	// Full imports rewrite every op so there is nothing to compare them with
+	const bool bRecordBaseline = Options.Mode != EZenSnapshotSyncMode::Full;
+
+	FString SharedSourceKey = GetDefault<UZenSnapshotSyncSettings>()->bShareSnapshotsAcrossProjects ? SharedCache->MakeSourceKey(Params) : FString();
+
+	TSharedRef<FZenSnapshotSyncRequest> Request = MakeShared<FZenSnapshotSyncRequest>(*RequestPool, *ProjectCache, FApp::GetZenStoreProjectId(), FString(TargetPlatform), MoveTemp(Params), Options);
+
+	// Descriptors can only lower the project wide limit for their host
+	const int32 ProjectMaxConcurrentImports = GetDefault<UZenSnapshotSyncProjectSettings>()->MaxConcurrentImportsPerHost;
+	const int32 MaxConcurrentImports = Throttle.MaxConcurrentImports > 0 && (ProjectMaxConcurrentImports == 0 || Throttle.MaxConcurrentImports < ProjectMaxConcurrentImports)
+		? Throttle.MaxConcurrentImports : ProjectMaxConcurrentImports;
+
+	EZenSnapshotSyncPriority Priority = Options.Priority != EZenSnapshotSyncPriority::Default ? Options.Priority : Throttle.Priority;
+	if (Priority == EZenSnapshotSyncPriority::Default)
+	{
+		Priority = EZenSnapshotSyncPriority::Normal;
+	}
+
+	TSharedRef<TPromise<FZenSnapshotSyncHandle>> Promise = MakeShared<TPromise<FZenSnapshotSyncHandle>>();
+	TFuture<FZenSnapshotSyncHandle> Future = Promise->GetFuture();
+
+	++NumPendingRequests;
+
+	Throttler->Enqueue(SourceHost, MaxConcurrentImports, Priority, Options.bWaitForSlot, [this, Request, TargetPlatform = FString(TargetPlatform), SharedSourceKey = MoveTemp(SharedSourceKey), SourceHost, JournalEntry = MoveTemp(JournalEntry), bRecordBaseline, bWaitForSlot = Options.bWaitForSlot, Promise](bool bStarted) mutable
+	{
+		if (!bStarted)
+		{
+			FZenSnapshotSyncHandle Handle;
+			if (!bWaitForSlot)
+			{
+				Handle.ErrorMessage = TEXT("Source host is running as many imports as allowed");
+			}
+
+			Promise->SetValue(MoveTemp(Handle));
+			--NumPendingRequests;
+			return;
+		}
+
+		Async(EAsyncExecution::ThreadPool, [this, Request, TargetPlatform = MoveTemp(TargetPlatform), SharedSourceKey = MoveTemp(SharedSourceKey), SourceHost = MoveTemp(SourceHost), JournalEntry = MoveTemp(JournalEntry), bRecordBaseline, Promise]() mutable
+		{
+			Request->UseSharedSource(*SharedCache, SharedSourceKey);
+
+			if (Cancellations->IsDirty(Request->GetOplogId()))
+			{
+				Request->ValidateBeforeImport();
+			}
+
+			// Estimated once the slot is free so the free space reflects imports that finished meanwhile
+			const double PreflightStartTime = FPlatformTime::Seconds();
+			const FZenSnapshotSyncEstimate Estimate = FZenSnapshotSyncPreflight::Estimate(Request->GetParams(), ZenDataPath);
+			const double PreflightDuration = FPlatformTime::Seconds() - PreflightStartTime;
+
+			FString PreflightError;
+			if (!FZenSnapshotSyncPreflight::Check(Estimate, TargetPlatform, PreflightError))
+			{
+				Throttler->Release(SourceHost);
+
+				FZenSnapshotSyncHandle Handle;
+				Handle.ErrorMessage = MoveTemp(PreflightError);
+				Handle.Telemetry.Estimate = Estimate;
+
+				Promise->SetValue(MoveTemp(Handle));
+				--NumPendingRequests;
+				return;
+			}
+
+			SharedCache->Invalidate(Request->GetProjectId(), Request->GetOplogId());
+
+			if (bRecordBaseline)
+			{
+				Verifier->RecordBaseline(Request->GetProjectId(), Request->GetOplogId());
+			}
+
+			FZenSnapshotSyncHandle Handle = Request->Run();
+			Handle.Telemetry.Estimate = Estimate;
+			Handle.Telemetry.Source = FZenSnapshotSyncMirrors::GetSourceName(Request->GetParams());
+			Handle.Telemetry.Phases.Insert({ TEXT("Preflight"), PreflightDuration, 0 }, 0);
+
+			if (Handle.IsValid())
+			{
+				Throttler->Assign(SourceHost, Handle.JobId);
+
+				if (!SharedSourceKey.IsEmpty())
+				{
+					SharedCache->Add(Handle.JobId, MoveTemp(SharedSourceKey), Request->GetProjectId(), Request->GetOplogId());
+				}
+
+				if (JournalEntry.IsSet())
+				{
+					JournalEntry->JobId = Handle.JobId;
+					Journal->Add(MoveTemp(*JournalEntry));
+				}
+			}
+			else
+			{
+				Throttler->Release(SourceHost);
+			}
+
+			// Continuations of the future run before shutdown stops waiting for the request
+			Promise->SetValue(MoveTemp(Handle));
+			--NumPendingRequests;
+		});
+	});
+
+	return Future;
+}
+
+TFuture<FZenSnapshotSyncHandle> FZenSnapshotSyncModule::ActivateOplogAsync(FStringView TargetPlatform, FString OplogId, FZenSnapshotSyncHandle Handle) const
+{
+	FZenSnapshotSyncOptions Options;
+	Options.OplogId = MoveTemp(OplogId);
+
+	TSharedRef<FZenSnapshotSyncRequest> Request = MakeShared<FZenSnapshotSyncRequest>(*RequestPool, *ProjectCache, FApp::GetZenStoreProjectId(), FString(TargetPlatform), FCbObject(), Options);
+
+	++NumPendingRequests;
+
+	return Async(EAsyncExecution::ThreadPool, [this, Request, Handle = MoveTemp(Handle)]()
+	{
+		const bool bActivated = Request->RunActivation();
+		--NumPendingRequests;
+
+		return bActivated ? Handle : FZenSnapshotSyncHandle();
+	});
+}
+
+TFuture<FZenSnapshotSyncHandle> FZenSnapshotSyncModule::ActivateSlotAsync(const FZenSnapshotDescriptor& SnapshotDescriptor, const FZenSnapshotSyncOptions& Options, FString OplogId, FString JobId) const
+{
+	FZenSnapshotSyncOptions ActivationOptions;
+	ActivationOptions.OplogId = MoveTemp(OplogId);
+
+	TSharedRef<FZenSnapshotSyncRequest> Request = MakeShared<FZenSnapshotSyncRequest>(*RequestPool, *ProjectCache, FApp::GetZenStoreProjectId(), SnapshotDescriptor.TargetPlatform, FCbObject(), ActivationOptions);
+
+	TSharedRef<TPromise<FZenSnapshotSyncHandle>> Promise = MakeShared<TPromise<FZenSnapshotSyncHandle>>();
+	TFuture<FZenSnapshotSyncHandle> Future = Promise->GetFuture();
+
+	++NumPendingRequests;
+
+	Async(EAsyncExecution::ThreadPool, [this, Request, SnapshotDescriptor, Options, OplogId = ActivationOptions.OplogId, JobId = MoveTemp(JobId), Promise]()
+	{
+		const double StartTime = FPlatformTime::Seconds();
+
+		if (Request->RunSlotActivation())
+		{
+			FZenSnapshotSyncHandle Handle;
+			Handle.JobId = JobId;
+			Handle.bComplete = true;
+			Handle.Telemetry.TargetPlatform = SnapshotDescriptor.TargetPlatform;
+			Handle.Telemetry.OplogId = OplogId;
+			Handle.Telemetry.RequestTime = FDateTime::UtcNow();
+			Handle.Telemetry.AddPhase(TEXTVIEW("ActivateSlot"), FPlatformTime::Seconds() - StartTime);
+
+			UE_LOGFMT(LogZenSnapshotSync, Display, "Switched to resident snapshot '{Name}' in oplog '{OplogId}'", SnapshotDescriptor.Name, OplogId);
+
+			Promise->SetValue(MoveTemp(Handle));
+			--NumPendingRequests;
+			return;
+		}
+
+		UE_LOGFMT(LogZenSnapshotSync, Warning, "Resident snapshot '{Name}' is missing oplog '{OplogId}', importing it again", SnapshotDescriptor.Name, OplogId);
+		Slots->Remove(OplogId);
+
+		RequestSnapshotSyncAsync(SnapshotDescriptor.TargetPlatform, SnapshotDescriptor.Name, FZenSnapshotSyncSlots::MakeParamsHash(SnapshotDescriptor.ImportParams),
+			SnapshotDescriptor.ImportParams, GetSourceHost(SnapshotDescriptor.Source), SnapshotDescriptor.Throttle, Options)
+			.Next([Promise](FZenSnapshotSyncHandle Handle) { Promise->SetValue(MoveTemp(Handle)); });
+
+		--NumPendingRequests;
+	});
+
+	return Future;
+}
+
+void FZenSnapshotSyncModule::EvictSnapshotSlots(const FString& TargetPlatform) const
+{
+	const TArray<FString> EvictedOplogIds = Slots->Evict(TargetPlatform, FZenSnapshotSyncSlots::GetMaxResidentSnapshots(), FZenSnapshotSyncRequest::ReadActiveOplogId(TargetPlatform));
+	if (EvictedOplogIds.IsEmpty())
+	{
+		return;
+	}
+
+	++NumPendingRequests;
+
+	Async(EAsyncExecution::ThreadPool, [this, ProjectId = FString(FApp::GetZenStoreProjectId()), EvictedOplogIds]()
+	{
+		using namespace UE::Zen;
+
+		for (const FString& OplogId : EvictedOplogIds)
+		{
+			TStringBuilder<128> RequestUri;
+			RequestUri << TEXTVIEW("/prj/") << ProjectId << TEXTVIEW("/oplog/") << OplogId;
+
+			FZenScopedRequestPtr Request(RequestPool.Get());
+
+			const FZenHttpRequest::Result Result = FZenSnapshotSyncRetry::Perform(*Request.Get(), FZenSnapshotSyncRetry::EMode::Idempotent,
+				[&Request, &RequestUri]() { return Request->PerformBlockingDelete(RequestUri); });
+
+			ProjectCache->InvalidateOplog(ProjectId, OplogId);
+
+			if (Result != FZenHttpRequest::Result::Success || (Request->GetResponseCode() != 200 && Request->GetResponseCode() != 404))
+			{
+				UE_LOGFMT(LogZenSnapshotSync, Warning, "Failed to evict snapshot oplog '{OplogId}' ({ResponseCode})", OplogId, Request->GetResponseCode());
+				continue;
+			}
+
+			Cancellations->ClearDirty(OplogId);
+
+			UE_LOGFMT(LogZenSnapshotSync, Display, "Evicted least recently used snapshot oplog '{OplogId}'", OplogId);
+		}
+
+		--NumPendingRequests;
+	});
+}
+
+TArray<FZenSnapshotSyncModule::FRecoveredSnapshotSync> FZenSnapshotSyncModule::RecoverSnapshotSyncs() const
+{
+	using namespace UE::Zen;
+
+	TArray<FRecoveredSnapshotSync> RecoveredSnapshotSyncs;
+
+	TArray<FZenSnapshotSyncJournalEntry> Entries = Journal->GetEntries();
+	if (Entries.IsEmpty())
+	{
+		return RecoveredSnapshotSyncs;
+	}
+
+	// Zen server may still be starting, nothing can be told about the jobs until it answers
+	{
+		FZenScopedRequestPtr Request(RequestPool.Get());
+
+		const FZenHttpRequest::Result Result = FZenSnapshotSyncRetry::Perform(*Request.Get(), FZenSnapshotSyncRetry::EMode::Idempotent,
+			[&Request]() { return Request->PerformBlockingDownload(TEXTVIEW("/health/"), nullptr, EContentType::Text); });
+		if (Result != FZenHttpRequest::Result::Success || Request->GetResponseCode() != 200)
+		{
+			UE_LOGFMT(LogZenSnapshotSync, Warning, "Zen server is not reachable, keeping {NumImports} interrupted imports for the next start", Entries.Num());
+			return RecoveredSnapshotSyncs;
+		}
+	}
+
+	for (FZenSnapshotSyncJournalEntry& Entry : Entries)
+	{
+		FZenSnapshotSyncHandle Handle;
+		Handle.JobId = Entry.JobId;
+		Handle.Telemetry.TargetPlatform = Entry.TargetPlatform;
+		Handle.Telemetry.OplogId = Entry.OplogId;
+
+		// Only jobs Zen server still knows are reattached, ones it forgot were lost with a restart and are resumed
+		FZenHttpRequest::Result Result;
+		int32 ResponseCode = 0;
+		bool bInProgress = false;
+		{
+			TStringBuilder<128> RequestUri;
+			RequestUri << TEXTVIEW("/admin/jobs/") << Entry.JobId;
+
+			FZenScopedRequestPtr Request(RequestPool.Get());
+
+			Result = FZenSnapshotSyncRetry::Perform(*Request.Get(), FZenSnapshotSyncRetry::EMode::Idempotent,
+				[&Request, &RequestUri]() { return Request->PerformBlockingDownload(RequestUri, nullptr, EContentType::CbObject); });
+			ResponseCode = Request->GetResponseCode();
+
+			// The status just fetched is the first poll of the reattached handle
+			if (Result == FZenHttpRequest::Result::Success && ResponseCode == 200)
+			{
+				Throttler->Adopt(GetSourceHost(Entry.Params), Entry.JobId);
+				bInProgress = ApplySnapshotSyncStatus(Handle, Request->GetResponseAsObject());
+			}
+		}
+
+		if (Result != FZenHttpRequest::Result::Success || (ResponseCode != 200 && ResponseCode != 404))
+		{
+			UE_LOGFMT(LogZenSnapshotSync, Warning, "Failed to query job '{JobId}' of snapshot '{Name}' ({ResponseCode}), keeping it for the next start",
+				Entry.JobId, Entry.SnapshotName, ResponseCode);
+			continue;
+		}
+
+		if (ResponseCode == 200)
+		{
+			if (bInProgress)
+			{
+				UE_LOGFMT(LogZenSnapshotSync, Display, "Reattached to import of snapshot '{Name}' ({JobId})", Entry.SnapshotName, Entry.JobId);
+				RecoveredSnapshotSyncs.Add({ Entry.SnapshotName, Entry.TargetPlatform, MakeFulfilledPromise<FZenSnapshotSyncHandle>(MoveTemp(Handle)).GetFuture().Share() });
+				continue;
+			}
+
+			if (Handle.IsComplete())
+			{
+				continue;
+			}
+		}
+		else
+		{
+			ProjectCache->InvalidateAll();
+		}
+
+		// Importing again without force only transfers what has not landed in the oplog yet, the request journals the new job once it started
+		FZenSnapshotSyncOptions Options;
+		Options.OplogId = Entry.OplogId;
+
+		Journal->Remove(Entry.JobId);
+
+		// Queued behind other imports from the same host like any new request, the recovery does not wait for its turn
+		TSharedFuture<FZenSnapshotSyncHandle> ResumedHandle = RequestSnapshotSyncAsync(Entry.TargetPlatform, Entry.SnapshotName, FZenSnapshotSyncSlots::MakeParamsHash(Entry.Params),
+			Entry.Params, GetSourceHost(Entry.Params), FZenSnapshotSyncThrottle(), Options)
+			.Next([this, Entry](FZenSnapshotSyncHandle NewHandle) mutable
+			{
+				if (NewHandle.IsValid())
+				{
+					UE_LOGFMT(LogZenSnapshotSync, Display, "Resumed import of snapshot '{Name}' ({JobId})", Entry.SnapshotName, NewHandle.JobId);
+				}
+				else
+				{
+					// Kept for the next start
+					UE_LOGFMT(LogZenSnapshotSync, Warning, "Failed to resume import of snapshot '{Name}'", Entry.SnapshotName);
+					Journal->Add(MoveTemp(Entry));
+				}
+
+				return NewHandle;
+			}).Share();
+
+		RecoveredSnapshotSyncs.Add({ Entry.SnapshotName, Entry.TargetPlatform, MoveTemp(ResumedHandle) });
+	}
+
+	return RecoveredSnapshotSyncs;
+}
+
+bool FZenSnapshotSyncModule::DispatchRecoveredSnapshotSyncs(float DeltaTime)
+{
+	if (PendingRecovery.IsValid())
+	{
+		if (!PendingRecovery.IsReady())
+		{
+			return true;
+		}
+
+		PendingRecoveredSnapshotSyncs = PendingRecovery.Get();
+		PendingRecovery.Reset();
+	}
+
+	for (int32 Index = 0; Index < PendingRecoveredSnapshotSyncs.Num();)
+	{
+		const FRecoveredSnapshotSync& RecoveredSnapshotSync = PendingRecoveredSnapshotSyncs[Index];
+		if (!RecoveredSnapshotSync.Handle.IsReady())
+		{
+			++Index;
+			continue;
+		}
+
+		if (RecoveredSnapshotSync.Handle.Get().IsValid())
+		{
+			SnapshotSyncRecoveredDelegate.Broadcast(RecoveredSnapshotSync.SnapshotName, RecoveredSnapshotSync.TargetPlatform, RecoveredSnapshotSync.Handle.Get());
+		}
+
+		PendingRecoveredSnapshotSyncs.RemoveAt(Index);
+	}
+
+	if (!PendingRecoveredSnapshotSyncs.IsEmpty())
+	{
+		return true;
+	}
+
+	RecoveryTickHandle.Reset();
+	return false;
+}
+
+TFuture<bool> FZenSnapshotSyncModule::EnsureProjectAsync() const
+{
+	TSharedRef<FZenSnapshotSyncRequest> Request = MakeShared<FZenSnapshotSyncRequest>(*RequestPool, *ProjectCache, FApp::GetZenStoreProjectId(), FString(), FCbObject(), FZenSnapshotSyncOptions());
+
+	++NumPendingRequests;
+
+	return Async(EAsyncExecution::ThreadPool, [this, Request]()
+	{
+		const bool bResult = Request->RunProjectSetup();
+		--NumPendingRequests;
+
+		return bResult;
+	});
+}
+
+bool FZenSnapshotSyncModule::QuerySnapshotSyncStatus(FZenSnapshotSyncHandle& Handle) const
+{
+	using namespace UE::Zen;
+
+	if (!Handle.IsValid() || Handle.IsComplete() || Handle.IsError())
+	{
+		return false;
+	}
+
+	// Jobs being verified already completed on Zen server
+	FZenSnapshotSyncVerification Verification;
+	float VerificationProgress = 0.0f;
+	const FZenSnapshotSyncVerifier::EStatus VerificationStatus = Verifier->GetStatus(Handle.JobId, Verification, VerificationProgress);
+
+	if (VerificationStatus == FZenSnapshotSyncVerifier::EStatus::Running || VerificationStatus == FZenSnapshotSyncVerifier::EStatus::Cancelling)
+	{
+		Handle.State = VerificationStatus == FZenSnapshotSyncVerifier::EStatus::Running ? TEXT("Verifying") : TEXT("Cancelling");
+		Handle.StateProgress = VerificationProgress;
+		return true;
+	}
+
+	if (VerificationStatus != FZenSnapshotSyncVerifier::EStatus::None)
+	{
+		Handle.Verification = MoveTemp(Verification);
+
+		if (VerificationStatus == FZenSnapshotSyncVerifier::EStatus::Cancelled)
+		{
+			Handle.ErrorMessage = TEXT("Cancelled");
+		}
+		else if (!Handle.Verification.CorruptChunks.IsEmpty())
+		{
+			Handle.ErrorMessage = FString::Printf(TEXT("Verification found %d corrupt chunks"), Handle.Verification.CorruptChunks.Num());
+		}
+		else if (!Handle.Verification.HasPassed())
+		{
+			Handle.ErrorMessage = TEXT("Verification could not read back every chunk");
+		}
+		else
+		{
+			Handle.bComplete = true;
+		}
+
+		return false;
+	}
+
+	if (Cancellations->IsConfirmed(Handle.JobId))
+	{
+		Handle.ErrorMessage = TEXT("Cancelled");
+		return false;
+	}
+
+	// Looked up on every poll as a cancellation is dropped if Zen server could not be asked to stop the job
+	const double CancelTime = Cancellations->GetRequestTime(Handle.JobId);
+	if (CancelTime > 0.0 && Handle.CancelTime == 0.0)
+	{
+		Handle.Telemetry.EndOperation(Handle.State, FPlatformTime::Seconds());
+		Handle.State = TEXT("Cancelling");
+		Handle.StateProgress = 0.0f;
+	}
+
+	Handle.CancelTime = CancelTime;
+
+	FZenSnapshotSyncMetrics::FScopedOperation MetricsScope(EZenSnapshotSyncOperation::QueryStatus);
+	TRACE_CPUPROFILER_EVENT_SCOPE(ZenSnapshotSync_QueryStatus);
+
+	TStringBuilder<128> RequestUri;
+	FZenScopedRequestPtr Request(RequestPool.Get());
+
+	RequestUri << TEXTVIEW("/admin/jobs/") << Handle.JobId;
+
+	// Not retried in place since the caller may be the game thread
+	FZenHttpRequest::Result Result;
+	{
+		FZenSnapshotSyncMetrics::FScopedOperation HttpMetricsScope(EZenSnapshotSyncOperation::HttpRequest);
+		Result = Request->PerformBlockingDownload(RequestUri, nullptr, EContentType::CbObject);
+	}
+
+	if (Result != FZenHttpRequest::Result::Success || Request->GetResponseCode() != 200)
+	{
+		// Zen server was restarted, anything verified before may be gone
+		if (Result != FZenHttpRequest::Result::Success || Request->GetResponseCode() == 404)
+		{
+			ProjectCache->InvalidateAll();
+		}
 
-#include "ZenSnapshotSyncToolbar.h"
+		// A dropped poll says nothing about the job
+		const double CurrentTime = FPlatformTime::Seconds();
+		if (Request->GetResponseCode() != 404 && FZenSnapshotSyncRetry::IsTransientFailure(Result, Request->GetResponseCode(), FZenSnapshotSyncRetry::EMode::Idempotent))
+		{
+			if (Handle.FirstFailedPollTime == 0.0)
+			{
+				Handle.FirstFailedPollTime = CurrentTime;
+			}
+
+			if (CurrentTime - Handle.FirstFailedPollTime < PollFailureTolerance)
+			{
+				UE_LOGFMT(LogZenSnapshotSync, Verbose, "Failed to query job '{JobId}' ({ResponseCode}), keeping it in progress", Handle.JobId, Request->GetResponseCode());
+				return true;
+			}
+		}
 
-DEFINE_LOG_CATEGORY_STATIC(LogZenSnapshotSync, Log, All);
+		// Zen server forgets about jobs once they were cancelled
+		if (Handle.CancelTime > 0.0)
+		{
+			ConfirmSnapshotSyncCancellation(Handle, Request->GetResponseCode() == 404);
+			return false;
+		}
 
-IMPLEMENT_MODULE(FZenSnapshotSyncModule, ZenSnapshotSync);
+		if (Throttler->Finish(Handle.JobId, false))
+		{
+			SharedCache->Finish(Handle.JobId, false);
+		}
 
-void FZenSnapshotSyncModule::StartupModule()
-{
-	RequestPool = MakeUnique<UE::Zen::FZenHttpRequestPool>(ZenService.GetInstance().GetURL());
-	Toolbar = MakeShared<FZenSnapshotSyncToolbar>();
+		const FUtf8StringView Response = GetResponseBufferAsString(Request->GetResponseBuffer());
+		Handle.ErrorMessage = Response.IsEmpty() ? FString::Printf(TEXT("Failed to query job status (%d)"), Request->GetResponseCode()) : FString(Response);
+		return false;
+	}
+
+	Handle.FirstFailedPollTime = 0.0;
+
+	return ApplySnapshotSyncStatus(Handle, Request->GetResponseAsObject());
 }
 
-bool FZenSnapshotSyncModule::ReadSnapshotDescriptorJson(FStringView SnapshotDescriptorJson, TArray<FZenSnapshotDescriptor>& SnapshotDescriptors)
+bool FZenSnapshotSyncModule::ApplySnapshotSyncStatus(FZenSnapshotSyncHandle& Handle, FCbObjectView Response) const
 {
-	TSharedPtr<FJsonObject> SnapshotDescriptorRootObject;
+	const FUtf8StringView Status = Response["Status"].AsString();
 
-	const TSharedRef<TJsonReader<TCHAR>> JsonReader = TJsonReaderFactory<>::CreateFromView(SnapshotDescriptorJson);
-	if (!FJsonSerializer::Deserialize(JsonReader, SnapshotDescriptorRootObject) || !SnapshotDescriptorRootObject.IsValid())
+	const bool bFinished = Status == "Complete" || Status == "Aborted";
+	const double CurrentTime = FPlatformTime::Seconds();
+
+	// Jobs only stop between ops
+	if (Handle.CancelTime > 0.0)
 	{
+		if (!bFinished && CurrentTime - Handle.CancelTime < CancelConfirmTimeout)
+		{
+			Throttler->Touch(Handle.JobId);
+			return true;
+		}
+
+		ConfirmSnapshotSyncCancellation(Handle, bFinished);
 		return false;
 	}
 
-	const TArray<TSharedPtr<FJsonValue>> SnapshotDescriptorValues = SnapshotDescriptorRootObject->GetArrayField(TEXT("snapshots"));
-	SnapshotDescriptors.Reserve(SnapshotDescriptors.Num() + SnapshotDescriptorValues.Num());
-
-	for (const TSharedPtr<FJsonValue>& SnapshotDescriptorValue : SnapshotDescriptorValues)
+	FString State(Response["CurrentOp"].AsString());
+	if (State != Handle.State || bFinished)
 	{
-		const TSharedPtr<FJsonObject>& SnapshotDescriptorObject = SnapshotDescriptorValue->AsObject();
-		if (SnapshotDescriptorObject.IsValid())
+		Handle.Telemetry.EndOperation(Handle.State, CurrentTime);
+		Handle.RateEstimator.Reset();
+
+		if (!State.IsEmpty() && !bFinished)
 		{
-			FZenSnapshotDescriptor& SnapshotDescriptor = SnapshotDescriptors.Emplace_GetRef();
-			SnapshotDescriptor.Name = SnapshotDescriptorObject->GetStringField(TEXT("name"));
-			SnapshotDescriptor.TargetPlatform = SnapshotDescriptorObject->GetStringField(TEXT("targetplatform"));
-			SnapshotDescriptor.Object = SnapshotDescriptorObject;
+			TRACE_BOOKMARK(TEXT("ZenSnapshotSync %s: %s"), *Handle.Telemetry.OplogId, *State);
 		}
 	}
 
-	return true;
-}
+	Handle.State = MoveTemp(State);
+	Handle.StateProgress = Response["CurrentOpPercentComplete"].AsUInt32() / 100.0f;
 
-bool FZenSnapshotSyncModule::ReadSnapshotDescriptorFile(const TCHAR* SnapshotDescriptorFilePath, TArray<FZenSnapshotDescriptor>& SnapshotDescriptors)
-{
-	FString SnapshotDescriptorJson;
-	if (!FFileHelper::LoadFileToString(SnapshotDescriptorJson, SnapshotDescriptorFilePath))
-	{
-		UE_LOGFMT(LogZenSnapshotSync, Error, "Failed to read snapshot descriptor file '{File}'", SnapshotDescriptorFilePath);
-		return false;
-	}
+	Handle.Telemetry.CurrentOpTotalCount = Response["CurrentOpTotalCount"].AsUInt64();
+	Handle.Telemetry.CurrentOpRemainingCount = Response["CurrentOpRemainingCount"].AsUInt64();
 
-	return ReadSnapshotDescriptorJson(SnapshotDescriptorJson, SnapshotDescriptors);
-}
+	Handle.RateEstimator.AddSample(CurrentTime, Handle.StateProgress,
+		Handle.Telemetry.CurrentOpTotalCount - FMath::Min(Handle.Telemetry.CurrentOpRemainingCount, Handle.Telemetry.CurrentOpTotalCount));
 
-FZenSnapshotSyncHandle FZenSnapshotSyncModule::RequestSnapshotSync(const FZenSnapshotDescriptor& SnapshotDescriptor) const
-{
-	if (SnapshotDescriptor.Object.IsValid())
+	if (Status == "Complete")
 	{
-		const FString SnapshotType = SnapshotDescriptor.Object->GetStringField(TEXT("type"));
+		const bool bVerify = GetDefault<UZenSnapshotSyncProjectSettings>()->bVerifyImports;
 
-		if (SnapshotType == TEXT("file"))
+		// Every copy of the handle sees the job complete, only the first one finishes it
+		if (Throttler->Finish(Handle.JobId, true))
 		{
-			const FString Directory = SnapshotDescriptor.Object->GetStringField(TEXT("directory"));
-			const FString FileName = SnapshotDescriptor.Object->GetStringField(TEXT("filename"));
-
-			return RequestSnapshotSyncFromFile(SnapshotDescriptor.GetTargetPlatform(), Directory, FileName);
+			for (FCbFieldView Message : Response["Messages"].AsArrayView())
+			{
+				UE_LOGFMT(LogZenSnapshotSync, Display, "Job '{JobId}': {Message}", Handle.JobId, FString(Message.AsString()));
+			}
+
+			Journal->Remove(Handle.JobId);
+
+			const double TotalDuration = Handle.Telemetry.GetTotalDuration();
+			Mirrors->RecordImport(Handle.Telemetry.Source, TotalDuration > 0.0 ? Handle.Telemetry.GetTotalEntries() / TotalDuration : 0.0);
+
+			// Verified imports are neither shared nor resident before the check passed
+			if (bVerify)
+			{
+				if (Verifier->Start(Handle.JobId))
+				{
+					VerifySnapshotSync(Handle);
+				}
+			}
+			else if (Verifier->HasBaseline(Handle.Telemetry.OplogId))
+			{
+				DiffSnapshotSync(Handle);
+			}
+			else
+			{
+				CompleteSnapshotSync(Handle);
+			}
 		}
 
-		if (SnapshotType == TEXT("cloud"))
+		if (bVerify)
 		{
-			const FString Host = SnapshotDescriptor.Object->GetStringField(TEXT("host"));
-			const FString Namespace = SnapshotDescriptor.Object->GetStringField(TEXT("namespace"));
-			const FString Bucket = SnapshotDescriptor.Object->GetStringField(TEXT("bucket"));
-			const FString Key = SnapshotDescriptor.Object->GetStringField(TEXT("key"));
-
-			return RequestSnapshotSyncFromCloud(SnapshotDescriptor.GetTargetPlatform(), Host, Namespace, Bucket, Key);
+			Handle.State = TEXT("Verifying");
+			Handle.StateProgress = 0.0f;
+			return true;
 		}
 
-		if (SnapshotType == TEXT("zen"))
+		Handle.bComplete = true;
+		return false;
+	}
+
+	if (Status == "Aborted")
+	{
+		const FUtf8StringView AbortReason = Response["AbortReason"].AsString();
+
+		if (FailOverSnapshotSync(Handle, FString(AbortReason)))
 		{
-			const FString Host = SnapshotDescriptor.Object->GetStringField(TEXT("host"));
-			const FString Project = SnapshotDescriptor.Object->GetStringField(TEXT("projectid"));
-			const FString Oplog = SnapshotDescriptor.Object->GetStringField(TEXT("oplogid"));
+			return true;
+		}
+
+		Handle.ErrorMessage = AbortReason.IsEmpty() ? TEXT("Aborted") : FString(AbortReason);
 
-			return RequestSnapshotSyncFromZen(SnapshotDescriptor.GetTargetPlatform(), Host, Project, Oplog);
+		if (Throttler->Finish(Handle.JobId, false))
+		{
+			Journal->Remove(Handle.JobId);
+			SharedCache->Finish(Handle.JobId, false);
+			Verifier->DiscardBaseline(Handle.Telemetry.OplogId);
+			TelemetryLog->Write(Handle.JobId, Handle.Telemetry, TEXT("aborted"));
 		}
+
+		return false;
 	}
 
-	return FZenSnapshotSyncHandle();
+	Throttler->Touch(Handle.JobId);
+
+	return true;
 }
 
-FZenSnapshotSyncHandle FZenSnapshotSyncModule::RequestSnapshotSyncFromFile(FStringView TargetPlatform, FStringView Directory, FStringView FileName) const
+int32 FZenSnapshotSyncModule::QuerySnapshotSyncStatuses(TArrayView<FZenSnapshotSyncHandle> Handles) const
 {
-	FCbWriter ParamsWriter;
-	ParamsWriter.BeginObject();
-	ParamsWriter.BeginObject("file");
-	ParamsWriter.AddString("path", Directory);
-	ParamsWriter.AddString("name", FileName);
-	ParamsWriter.EndObject();
-	ParamsWriter.EndObject();
+	// Zen server only reports progress per job, polls block on HTTP so they stay off task graph workers
+	std::atomic<int32> NextIndex = 0;
+	std::atomic<int32> NumInProgress = 0;
 
-	FCbFieldIterator Params = ParamsWriter.Save();
-	return RequestSnapshotSync(TargetPlatform, Params.AsObjectView());
-}
+	auto QueryHandles = [this, Handles, &NextIndex, &NumInProgress]()
+	{
+		for (int32 Index = NextIndex++; Index < Handles.Num(); Index = NextIndex++)
+		{
+			if (QuerySnapshotSyncStatus(Handles[Index]))
+			{
+				++NumInProgress;
+			}
+		}
+	};
 
-FZenSnapshotSyncHandle FZenSnapshotSyncModule::RequestSnapshotSyncFromCloud(FStringView TargetPlatform, FStringView Host, FStringView Namespace, FStringView Bucket, FStringView Key) const
-{
-	FCbWriter ParamsWriter;
-	ParamsWriter.BeginObject();
-	ParamsWriter.BeginObject("cloud");
-	ParamsWriter.AddString("url", Host);
-	ParamsWriter.AddString("namespace", Namespace);
-	ParamsWriter.AddString("bucket", Bucket);
-	ParamsWriter.AddString("key", Key);
-	ParamsWriter.EndObject();
-	ParamsWriter.EndObject();
+	TArray<TFuture<void>> Helpers;
+	for (int32 Index = 1; Index < FMath::Min(Handles.Num(), MaxConcurrentStatusQueries); ++Index)
+	{
+		Helpers.Add(Async(EAsyncExecution::ThreadPool, QueryHandles));
+	}
 
-	FCbFieldIterator Params = ParamsWriter.Save();
-	return RequestSnapshotSync(TargetPlatform, Params.AsObjectView());
-}
+	QueryHandles();
 
-FZenSnapshotSyncHandle FZenSnapshotSyncModule::RequestSnapshotSyncFromZen(FStringView TargetPlatform, FStringView Host, FStringView Project, FStringView Oplog) const
-{
-	FCbWriter ParamsWriter;
-	ParamsWriter.BeginObject();
-	ParamsWriter.BeginObject("zen");
-	ParamsWriter.AddString("url", Host);
-	ParamsWriter.AddString("project", Project);
-	ParamsWriter.AddString("oplog", Oplog);
-	ParamsWriter.EndObject();
-	ParamsWriter.EndObject();
+	for (TFuture<void>& Helper : Helpers)
+	{
+		Helper.Wait();
+	}
 
-	FCbFieldIterator Params = ParamsWriter.Save();
-	return RequestSnapshotSync(TargetPlatform, Params.AsObjectView());
+	return NumInProgress;
 }
 
-FZenSnapshotSyncHandle FZenSnapshotSyncModule::RequestSnapshotSync(FStringView TargetPlatform, FCbObjectView Params) const
+bool FZenSnapshotSyncModule::CancelSnapshotSync(FZenSnapshotSyncHandle& Handle) const
 {
 	using namespace UE::Zen;
 
-	const FString ProjectId = FApp::GetZenStoreProjectId();
-	const FStringView OplogId = TargetPlatform;
+	if (!Handle.IsValid() || Handle.IsComplete() || Handle.IsError())
+	{
+		return false;
+	}
+
+	if (Verifier->Cancel(Handle.JobId))
+	{
+		Handle.State = TEXT("Cancelling");
+		Handle.CancelTime = FPlatformTime::Seconds();
+		return true;
+	}
+
+	if (Cancellations->IsConfirmed(Handle.JobId))
+	{
+		Handle.ErrorMessage = TEXT("Cancelled");
+		return true;
+	}
+
+	const double PreviousCancelTime = Cancellations->GetRequestTime(Handle.JobId);
+	if (PreviousCancelTime > 0.0)
+	{
+		Handle.CancelTime = PreviousCancelTime;
+		Handle.State = TEXT("Cancelling");
+		Handle.StateProgress = 0.0f;
+		return true;
+	}
+
+	FZenSnapshotSyncMetrics::FScopedOperation MetricsScope(EZenSnapshotSyncOperation::CancelSync);
 
-	if (ProjectId.IsEmpty() || OplogId.IsEmpty())
+	// Zen server reports cancelled jobs as complete
+	const double CurrentTime = FPlatformTime::Seconds();
+	Cancellations->Add({ Handle.JobId, Handle.Telemetry.TargetPlatform, Handle.Telemetry.OplogId, Handle.PreviousOplogId, Handle.bCreatedOplog, CurrentTime });
+
+	// Transient failures are retried by the worker watching the job
+	bool bRetryable = false;
+	if (!SendSnapshotSyncCancellation(Handle, false, bRetryable) && !bRetryable)
 	{
-		return FZenSnapshotSyncHandle();
+		Cancellations->Remove(Handle.JobId);
+		return false;
 	}
 
+	Handle.Telemetry.EndOperation(Handle.State, CurrentTime);
+	Handle.State = TEXT("Cancelling");
+	Handle.StateProgress = 0.0f;
+	Handle.CancelTime = CurrentTime;
+
+	WatchSnapshotSyncCancellation(Handle, bRetryable);
+
+	return true;
+}
+
+TFuture<bool> FZenSnapshotSyncModule::CancelSnapshotSyncWhenRequested(TFuture<FZenSnapshotSyncHandle>&& PendingHandle) const
+{
+	++NumPendingRequests;
+
+	return PendingHandle.Next([this](FZenSnapshotSyncHandle Handle)
+	{
+		const bool bCancelled = CancelSnapshotSync(Handle);
+		--NumPendingRequests;
+
+		return bCancelled;
+	});
+}
+
+bool FZenSnapshotSyncModule::SendSnapshotSyncCancellation(const FZenSnapshotSyncHandle& Handle, bool bRetry, bool& bOutRetryable) const
+{
+	using namespace UE::Zen;
+
 	TStringBuilder<128> RequestUri;
 	FZenScopedRequestPtr Request(RequestPool.Get());
-	IFileManager& FileManager = IFileManager::Get();
 
-	// Ensure project exists
-	RequestUri << TEXTVIEW("/prj/") << ProjectId;
+	RequestUri << TEXTVIEW("/admin/jobs/") << Handle.JobId;
 
-	FZenHttpRequest::Result Result = Request->PerformBlockingDownload(RequestUri, nullptr, EContentType::CbObject);
-	if (Result != FZenHttpRequest::Result::Success || Request->GetResponseCode() != 200)
+	FZenHttpRequest::Result Result;
+	if (bRetry)
 	{
-		FCbWriter PayloadWriter;
-		PayloadWriter.BeginObject();
-		PayloadWriter.AddString("id", ProjectId);
-		PayloadWriter.AddString("root", FileManager.ConvertToAbsolutePathForExternalAppForRead(*FPaths::RootDir()));
-		PayloadWriter.AddString("engine", FileManager.ConvertToAbsolutePathForExternalAppForRead(*FPaths::EngineDir()));
-		PayloadWriter.AddString("project", FileManager.ConvertToAbsolutePathForExternalAppForRead(*FPaths::ProjectDir()));
-		PayloadWriter.AddString("projectfile", FileManager.ConvertToAbsolutePathForExternalAppForRead(*FPaths::GetProjectFilePath()));
-		PayloadWriter.EndObject();
+		Result = FZenSnapshotSyncRetry::Perform(*Request.Get(), FZenSnapshotSyncRetry::EMode::Idempotent,
+			[&Request, &RequestUri]() { return Request->PerformBlockingDelete(RequestUri); });
+	}
+	else
+	{
+		FZenSnapshotSyncMetrics::FScopedOperation HttpMetricsScope(EZenSnapshotSyncOperation::HttpRequest);
+		Result = Request->PerformBlockingDelete(RequestUri);
+	}
 
-		FCbFieldIterator Payload = PayloadWriter.Save();
-		Request->Reset();
+	bOutRetryable = false;
 
-		Result = Request->PerformBlockingPost(RequestUri, Payload.AsObjectView());
-		if (Result != FZenHttpRequest::Result::Success || Request->GetResponseCode() != 201)
+	if (Result != FZenHttpRequest::Result::Success || Request->GetResponseCode() != 200)
+	{
+		bOutRetryable = !bRetry && FZenSnapshotSyncRetry::IsTransientFailure(Result, Request->GetResponseCode(), FZenSnapshotSyncRetry::EMode::Idempotent);
+		if (!bOutRetryable)
 		{
-			UE_LOGFMT(LogZenSnapshotSync, Error, "Failed to create project '{ProjectId}' ({ResponseCode})", ProjectId, Request->GetResponseCode());
-			return FZenSnapshotSyncHandle();
+			UE_LOGFMT(LogZenSnapshotSync, Error, "Failed to cancel job '{JobId}' ({ResponseCode})", Handle.JobId, Request->GetResponseCode());
 		}
+
+		return false;
 	}
 
-	// Create project store file
-	const FString ProjectStoreFilePath = FPaths::Combine(FPaths::ProjectDir(), TEXT("Saved"), TEXT("Cooked"), TargetPlatform, TEXT("ue.projectstore"));
+	// Dirty until rolled back or imported into again
+	Journal->Remove(Handle.JobId);
+	if (!Handle.Telemetry.OplogId.IsEmpty())
 	{
-		TUniquePtr<FArchive> ProjectStoreFile(FileManager.CreateFileWriter(*ProjectStoreFilePath));
-		if (!ProjectStoreFile.IsValid())
-		{
-			UE_LOGFMT(LogZenSnapshotSync, Error, "Failed to create project store file '{File}' ({ErrorCode})", ProjectStoreFilePath, FPlatformMisc::GetLastError());
-			return FZenSnapshotSyncHandle();
-		}
+		Cancellations->MarkDirty(Handle.Telemetry.OplogId);
+	}
+
+	UE_LOGFMT(LogZenSnapshotSync, Display, "Cancelling job '{JobId}'", Handle.JobId);
+	return true;
+}
+
+void FZenSnapshotSyncModule::CompleteSnapshotSync(const FZenSnapshotSyncHandle& Handle) const
+{
+	SharedCache->Finish(Handle.JobId, true);
+	Cancellations->ClearDirty(Handle.Telemetry.OplogId);
+	TelemetryLog->Write(Handle.JobId, Handle.Telemetry, TEXT("completed"));
+
+	// Slots left over from a larger budget are evicted even once slots were turned off
+	if (Slots->MarkResident(Handle.Telemetry.OplogId, Handle.JobId) || !FZenSnapshotSyncSlots::IsEnabled())
+	{
+		EvictSnapshotSlots(Handle.Telemetry.TargetPlatform);
+	}
+}
+
+void FZenSnapshotSyncModule::OnSettingsChanged(UObject* Settings, FPropertyChangedEvent& PropertyChangedEvent)
+{
+	if (PropertyChangedEvent.GetMemberPropertyName() != GET_MEMBER_NAME_CHECKED(UZenSnapshotSyncSettings, MaxResidentSnapshots))
+	{
+		return;
+	}
 
-		const TSharedRef<TJsonWriter<UTF8CHAR>> Writer = TJsonWriterFactory<UTF8CHAR>::Create(ProjectStoreFile.Get());
-		Writer->WriteObjectStart();
-		Writer->WriteObjectStart(TEXT("zenserver"));
-		Writer->WriteValue(TEXT("projectid"), ProjectId);
-		Writer->WriteValue(TEXT("oplogid"), OplogId);
-		Writer->WriteObjectEnd();
-		Writer->WriteObjectEnd();
-		Writer->Close();
+	// Evicted down to the new budget right away rather than on the next import of each platform
+	for (const FString& TargetPlatform : Slots->GetTargetPlatforms())
+	{
+		EvictSnapshotSlots(TargetPlatform);
 	}
+}
 
-	// Ensure oplog exists
-	RequestUri << TEXTVIEW("/oplog/") << OplogId;
-	Request->Reset();
+void FZenSnapshotSyncModule::DiffSnapshotSync(FZenSnapshotSyncHandle Handle) const
+{
+	++NumPendingRequests;
 
-	Result = Request->PerformBlockingDownload(RequestUri, nullptr, EContentType::CbObject);
-	if (Result != FZenHttpRequest::Result::Success || Request->GetResponseCode() != 200)
+	Async(EAsyncExecution::ThreadPool, [this, ProjectId = FString(FApp::GetZenStoreProjectId()), Handle = MoveTemp(Handle)]() mutable
+	{
+		Verifier->Diff(ProjectId, Handle.Telemetry.OplogId, Handle.Telemetry.Diff);
+		CompleteSnapshotSync(Handle);
+
+		--NumPendingRequests;
+	});
+}
+
+void FZenSnapshotSyncModule::VerifySnapshotSync(FZenSnapshotSyncHandle Handle) const
+{
+	++NumPendingRequests;
+
+	Async(EAsyncExecution::ThreadPool, [this, ProjectId = FString(FApp::GetZenStoreProjectId()), Handle = MoveTemp(Handle)]() mutable
 	{
-		FCbWriter PayloadWriter;
-		PayloadWriter.BeginObject();
-		PayloadWriter.AddString("gcpath", FileManager.ConvertToAbsolutePathForExternalAppForRead(*ProjectStoreFilePath));
-		PayloadWriter.EndObject();
+		const double StartTime = FPlatformTime::Seconds();
+		const FZenSnapshotSyncVerifier::EStatus Status = Verifier->Verify(Handle.JobId, ProjectId, Handle.Telemetry.OplogId, Handle.Verification, Handle.Telemetry.Diff);
+		Handle.Telemetry.AddPhase(TEXTVIEW("Verify"), FPlatformTime::Seconds() - StartTime, Handle.Verification.NumChunks);
 
-		FCbFieldIterator Payload = PayloadWriter.Save();
-		Request->Reset();
+		if (Status == FZenSnapshotSyncVerifier::EStatus::Finished && Handle.Verification.HasPassed())
+		{
+			UE_LOGFMT(LogZenSnapshotSync, Display, "Verified {NumChunks} chunks of {NumOps} ops imported into oplog '{OplogId}'",
+				Handle.Verification.NumChunks, Handle.Verification.NumOps, Handle.Telemetry.OplogId);
 
-		Result = Request->PerformBlockingPost(RequestUri, Payload.AsObjectView());
-		if (Result != FZenHttpRequest::Result::Success || Request->GetResponseCode() != 201)
+			CompleteSnapshotSync(Handle);
+		}
+		else
 		{
-			UE_LOGFMT(LogZenSnapshotSync, Error, "Failed to create oplog '{OplogId}' ({ResponseCode})", OplogId, Request->GetResponseCode());
-			return FZenSnapshotSyncHandle();
+			const TCHAR* Outcome = TEXT("cancelled");
+			if (Status == FZenSnapshotSyncVerifier::EStatus::Finished && !Handle.Verification.CorruptChunks.IsEmpty())
+			{
+				UE_LOGFMT(LogZenSnapshotSync, Error, "Verification of oplog '{OplogId}' found {NumCorrupt} corrupt chunks, e.g. '{Chunk}'",
+					Handle.Telemetry.OplogId, Handle.Verification.CorruptChunks.Num(), Handle.Verification.CorruptChunks[0]);
+				Outcome = TEXT("corrupt");
+			}
+			else if (Status == FZenSnapshotSyncVerifier::EStatus::Finished)
+			{
+				UE_LOGFMT(LogZenSnapshotSync, Error, "Failed to verify oplog '{OplogId}', leaving it for the next import to validate", Handle.Telemetry.OplogId);
+				Outcome = TEXT("unverified");
+			}
+
+			// The next import into the oplog validates it
+			SharedCache->Finish(Handle.JobId, false);
+			Cancellations->MarkDirty(Handle.Telemetry.OplogId);
+			TelemetryLog->Write(Handle.JobId, Handle.Telemetry, Outcome);
 		}
-	}
 
-	// Request oplog import
-	RequestUri << TEXTVIEW("/rpc");
-	Request->Reset();
-
-	FCbWriter PayloadWriter;
-	PayloadWriter.BeginObject();
-	PayloadWriter.AddString("method", "import");
-	PayloadWriter.AddObject("params", Params);
-	PayloadWriter.EndObject();
+		--NumPendingRequests;
+	});
+}
 
-	FCbFieldIterator Payload = PayloadWriter.Save();
+void FZenSnapshotSyncModule::WatchSnapshotSyncCancellation(const FZenSnapshotSyncHandle& Handle, bool bSendCancellation) const
+{
+	// Most callers drop the handle right after cancelling, the job monitor keeps polling it
+	JobMonitor->WatchCancellation(Handle, bSendCancellation);
+}
 
-	Result = Request->PerformBlockingPost(RequestUri, Payload.AsObjectView());
-	if (Result != FZenHttpRequest::Result::Success || Request->GetResponseCode() != 202)
+bool FZenSnapshotSyncModule::ResendSnapshotSyncCancellation(const FZenSnapshotSyncHandle& Handle) const
+{
+	bool bRetryable = false;
+	if (SendSnapshotSyncCancellation(Handle, true, bRetryable))
 	{
-		UE_LOGFMT(LogZenSnapshotSync, Error, "Failed to import oplog '{OplogId}' ({ResponseCode})", OplogId, Request->GetResponseCode());
-		return FZenSnapshotSyncHandle();
+		return true;
 	}
 
-	FZenSnapshotSyncHandle Handle;
-	Handle.JobId = FString(GetResponseBufferAsString(Request->GetResponseBuffer()));
-
-	return MoveTemp(Handle);
+	Cancellations->Remove(Handle.JobId);
+	return false;
 }
 
-bool FZenSnapshotSyncModule::QuerySnapshotSyncStatus(FZenSnapshotSyncHandle& Handle) const
+void FZenSnapshotSyncModule::ConfirmSnapshotSyncCancellation(FZenSnapshotSyncHandle& Handle, bool bStopped) const
 {
-	using namespace UE::Zen;
+	Handle.ErrorMessage = TEXT("Cancelled");
 
-	if (!Handle.IsValid() || Handle.IsComplete() || Handle.IsError())
+	FZenSnapshotSyncCancellation Cancellation;
+	if (!Cancellations->Confirm(Handle.JobId, Cancellation))
 	{
-		return false;
+		return;
 	}
 
-	TStringBuilder<128> RequestUri;
-	FZenScopedRequestPtr Request(RequestPool.Get());
+	Handle.Telemetry.AddPhase(TEXTVIEW("Cancel"), FPlatformTime::Seconds() - Cancellation.RequestTime);
 
-	RequestUri << TEXTVIEW("/admin/jobs/") << Handle.JobId;
+	Throttler->Finish(Handle.JobId, false);
+	SharedCache->Finish(Handle.JobId, false);
+	Verifier->DiscardBaseline(Handle.Telemetry.OplogId);
+	TelemetryLog->Write(Handle.JobId, Handle.Telemetry, TEXT("cancelled"));
 
-	const FZenHttpRequest::Result Result = Request->PerformBlockingDownload(RequestUri, nullptr, EContentType::CbObject);
-	if (Result != FZenHttpRequest::Result::Success || Request->GetResponseCode() != 200)
+	if (!bStopped)
 	{
-		Handle.ErrorMessage = FString(GetResponseBufferAsString(Request->GetResponseBuffer()));
-		return false;
+		UE_LOGFMT(LogZenSnapshotSync, Warning, "Job '{JobId}' was not seen stopping after being cancelled, leaving oplog '{OplogId}' for the next import to validate",
+			Handle.JobId, Cancellation.OplogId);
+		return;
 	}
 
-	const FCbObjectView Response = Request->GetResponseAsObject();
-	const FUtf8StringView Status = Response["Status"].AsString();
+	UE_LOGFMT(LogZenSnapshotSync, Display, "Cancelled job '{JobId}'", Handle.JobId);
 
-	Handle.State = FString(Response["CurrentOp"].AsString());
-	Handle.StateProgress = Response["CurrentOpPercentComplete"].AsUInt32() / 100.0f;
+	RollBackSnapshotSync(MoveTemp(Cancellation));
+}
 
-	if (Status == "Complete")
+void FZenSnapshotSyncModule::RollBackSnapshotSync(FZenSnapshotSyncCancellation&& Cancellation) const
+{
+	++NumPendingRequests;
+
+	Async(EAsyncExecution::ThreadPool, [this, ProjectId = FString(FApp::GetZenStoreProjectId()), Cancellation = MoveTemp(Cancellation)]()
 	{
-		Handle.bComplete = true;
-		return false;
+		using namespace UE::Zen;
+
+		// Imports into another oplog left the previous one untouched
+		if (!Cancellation.PreviousOplogId.IsEmpty() && FZenSnapshotSyncRequest::ReadActiveOplogId(Cancellation.TargetPlatform) == Cancellation.OplogId)
+		{
+			FZenSnapshotSyncOptions Options;
+			Options.OplogId = Cancellation.PreviousOplogId;
+
+			FZenSnapshotSyncRequest Request(*RequestPool, *ProjectCache, ProjectId, Cancellation.TargetPlatform, FCbObject(), Options);
+			if (Request.RunSlotActivation())
+			{
+				UE_LOGFMT(LogZenSnapshotSync, Display, "Pointed project store of {TargetPlatform} back at oplog '{OplogId}'", Cancellation.TargetPlatform, Cancellation.PreviousOplogId);
+			}
+			else
+			{
+				UE_LOGFMT(LogZenSnapshotSync, Warning, "Failed to point project store of {TargetPlatform} back at oplog '{OplogId}'", Cancellation.TargetPlatform, Cancellation.PreviousOplogId);
+			}
+		}
+
+		// Attachments stay in Zen server's store until garbage collected
+		if (Cancellation.bCreatedOplog && FZenSnapshotSyncRequest::ReadActiveOplogId(Cancellation.TargetPlatform) != Cancellation.OplogId)
+		{
+			TStringBuilder<128> RequestUri;
+			RequestUri << TEXTVIEW("/prj/") << ProjectId << TEXTVIEW("/oplog/") << Cancellation.OplogId;
+
+			FZenScopedRequestPtr Request(RequestPool.Get());
+
+			const FZenHttpRequest::Result Result = FZenSnapshotSyncRetry::Perform(*Request.Get(), FZenSnapshotSyncRetry::EMode::Idempotent,
+				[&Request, &RequestUri]() { return Request->PerformBlockingDelete(RequestUri); });
+
+			ProjectCache->InvalidateOplog(ProjectId, Cancellation.OplogId);
+
+			if (Result == FZenHttpRequest::Result::Success && (Request->GetResponseCode() == 200 || Request->GetResponseCode() == 404))
+			{
+				Slots->Remove(Cancellation.OplogId);
+				Cancellations->ClearDirty(Cancellation.OplogId);
+
+				UE_LOGFMT(LogZenSnapshotSync, Display, "Removed oplog '{OplogId}' of cancelled import", Cancellation.OplogId);
+			}
+			else
+			{
+				UE_LOGFMT(LogZenSnapshotSync, Warning, "Failed to remove oplog '{OplogId}' of cancelled import ({ResponseCode})", Cancellation.OplogId, Request->GetResponseCode());
+			}
+		}
+
+		--NumPendingRequests;
+	});
+}
+
+FDelegateHandle FZenSnapshotSyncModule::SubscribeSnapshotSyncStatus(const FZenSnapshotSyncHandle& Handle, FOnSnapshotSyncStatusChanged&& Callback)
+{
+	return JobMonitor.IsValid() ? JobMonitor->Subscribe(Handle, MoveTemp(Callback)) : FDelegateHandle();
+}
+
+FZenSnapshotSyncModule::FOnSnapshotSyncRecovered& FZenSnapshotSyncModule::OnSnapshotSyncRecovered()
+{
+	return SnapshotSyncRecoveredDelegate;
+}
+
+void FZenSnapshotSyncModule::UnsubscribeSnapshotSyncStatus(FDelegateHandle SubscriptionHandle)
+{
+	if (JobMonitor.IsValid())
+	{
+		JobMonitor->Unsubscribe(SubscriptionHandle);
 	}
+}
 
-	if (Status == "Aborted")
+FCbObject FZenSnapshotSyncModule::MakeImportParams(const FZenSnapshotSource& Source)
+{
+	FCbWriter ParamsWriter;
+	ParamsWriter.BeginObject();
+
+	if (const FZenSnapshotFileSource* FileSource = Source.TryGet<FZenSnapshotFileSource>())
 	{
-		const FUtf8StringView AbortReason = Response["AbortReason"].AsString();
-		Handle.ErrorMessage = AbortReason.IsEmpty() ? TEXT("Aborted") : FString(AbortReason);
-		return false;
+		ParamsWriter.BeginObject("file");
+		ParamsWriter.AddString("path", FileSource->Directory);
+		ParamsWriter.AddString("name", FileSource->FileName);
+		ParamsWriter.EndObject();
+	}
+	else if (const FZenSnapshotCloudSource* CloudSource = Source.TryGet<FZenSnapshotCloudSource>())
+	{
+		ParamsWriter.BeginObject("cloud");
+		ParamsWriter.AddString("url", CloudSource->Host);
+		ParamsWriter.AddString("namespace", CloudSource->Namespace);
+		ParamsWriter.AddString("bucket", CloudSource->Bucket);
+		ParamsWriter.AddString("key", CloudSource->Key);
+		ParamsWriter.EndObject();
+	}
+	else if (const FZenSnapshotZenSource* ZenSource = Source.TryGet<FZenSnapshotZenSource>())
+	{
+		ParamsWriter.BeginObject("zen");
+		ParamsWriter.AddString("url", ZenSource->Host);
+		ParamsWriter.AddString("project", ZenSource->ProjectId);
+		ParamsWriter.AddString("oplog", ZenSource->OplogId);
+		ParamsWriter.EndObject();
 	}
 
-	return true;
+	ParamsWriter.EndObject();
+
+	return ParamsWriter.Save().AsObject();
 }
 
-bool FZenSnapshotSyncModule::CancelSnapshotSync(FZenSnapshotSyncHandle& Handle) const
+FString FZenSnapshotSyncModule::GetSourceHost(const FZenSnapshotSource& Source)
 {
-	using namespace UE::Zen;
-
-	if (!Handle.IsValid() || Handle.IsComplete() || Handle.IsError())
+	if (const FZenSnapshotCloudSource* CloudSource = Source.TryGet<FZenSnapshotCloudSource>())
 	{
-		return false;
+		return CloudSource->Host;
 	}
 
-	TStringBuilder<128> RequestUri;
-	FZenScopedRequestPtr Request(RequestPool.Get());
+	if (const FZenSnapshotZenSource* ZenSource = Source.TryGet<FZenSnapshotZenSource>())
+	{
+		return ZenSource->Host;
+	}
 
-	RequestUri << TEXTVIEW("/admin/jobs/") << Handle.JobId;
+	// File snapshots are all read from disk by the local Zen server
+	return TEXT("file");
+}
 
-	const FZenHttpRequest::Result Result = Request->PerformBlockingDelete(RequestUri);
-	if (Result != FZenHttpRequest::Result::Success || Request->GetResponseCode() != 200)
+FString FZenSnapshotSyncModule::GetSourceHost(const FCbObject& Params)
+{
+	if (const FCbObjectView CloudParams = Params["cloud"].AsObjectView(); CloudParams)
 	{
-		UE_LOGFMT(LogZenSnapshotSync, Error, "Failed to cancel job '{JobId}' ({ResponseCode})", Handle.JobId, Request->GetResponseCode());
-		return false;
+		return FString(CloudParams["url"].AsString());
 	}
 
-	// Cancellation is treated as completion by Zen server so assume an error state immediately
-	Handle.ErrorMessage = TEXT("Cancelled");
+	if (const FCbObjectView ZenParams = Params["zen"].AsObjectView(); ZenParams)
+	{
+		return FString(ZenParams["url"].AsString());
+	}
 
-	return true;
+	return TEXT("file");
 }
 
 FUtf8StringView FZenSnapshotSyncModule::GetResponseBufferAsString(const TArray64<uint8>& ResponseBuffer)
@@ -329,20 +1773,70 @@ FUtf8StringView FZenSnapshotSyncModule::GetResponseBufferAsString(const TArray64
 
 FDelegateHandle FZenSnapshotSyncModule::RegisterQuerySnapshotsCallback(FQuerySnapshotsDelegate&& Callback)
 {
-	return OnQuerySnapshots.Add(MoveTemp(Callback));
+	return RegisterQuerySnapshotsCallback(FStringView(), MoveTemp(Callback), FQuerySnapshotsVersionDelegate());
+}
+
+FDelegateHandle FZenSnapshotSyncModule::RegisterQuerySnapshotsCallback(FStringView ProviderName, FQuerySnapshotsDelegate&& Callback, FQuerySnapshotsVersionDelegate&& VersionCallback)
+{
+	return DescriptorCache->AddProvider(FString(ProviderName), MoveTemp(Callback), MoveTemp(VersionCallback));
+}
+
+FDelegateHandle FZenSnapshotSyncModule::RegisterQuerySnapshotsAsyncCallback(FStringView ProviderName, FQuerySnapshotsAsyncDelegate&& Callback, FQuerySnapshotsVersionDelegate&& VersionCallback)
+{
+	return DescriptorCache->AddProvider(FString(ProviderName), MoveTemp(Callback), MoveTemp(VersionCallback));
+}
+
+FDelegateHandle FZenSnapshotSyncModule::RegisterSnapshotDescriptorFile(FStringView SnapshotDescriptorFilePath)
+{
+	const FString FilePath(SnapshotDescriptorFilePath);
+
+	// Modification time and size are enough to tell whether the file needs to be read again
+	FQuerySnapshotsVersionDelegate VersionCallback = FQuerySnapshotsVersionDelegate::CreateLambda([FilePath]()
+	{
+		const FFileStatData StatData = IFileManager::Get().GetStatData(*FilePath);
+		return StatData.bIsValid ? FString::Printf(TEXT("%lld-%lld"), StatData.ModificationTime.GetTicks(), StatData.FileSize) : FString();
+	});
+
+	FQuerySnapshotsAsyncDelegate Callback = FQuerySnapshotsAsyncDelegate::CreateLambda([FilePath]()
+	{
+		return Async(EAsyncExecution::ThreadPool, [FilePath]()
+		{
+			TArray<FZenSnapshotDescriptor> SnapshotDescriptors;
+			ReadSnapshotDescriptorFile(*FilePath, SnapshotDescriptors);
+			return SnapshotDescriptors;
+		});
+	});
+
+	return RegisterQuerySnapshotsAsyncCallback(FilePath, MoveTemp(Callback), MoveTemp(VersionCallback));
 }
 
 void FZenSnapshotSyncModule::UnregisterQuerySnapshotsCallback(FDelegateHandle CallbackHandle)
 {
-	OnQuerySnapshots.Remove(CallbackHandle);
+	DescriptorCache->RemoveProvider(CallbackHandle);
 }
 
 bool FZenSnapshotSyncModule::CanQuerySnapshots() const
 {
-	return OnQuerySnapshots.IsBound();
+	return DescriptorCache->HasProviders();
 }
 
 void FZenSnapshotSyncModule::QuerySnapshots(TArray<FZenSnapshotDescriptor>& SnapshotDescriptors) const
 {
-	OnQuerySnapshots.Broadcast(SnapshotDescriptors);
+	SnapshotDescriptors.Append(*DescriptorCache->GetSnapshotDescriptors());
+	DescriptorCache->Refresh();
+}
+
+TSharedRef<const TArray<FZenSnapshotDescriptor>> FZenSnapshotSyncModule::GetCachedSnapshots() const
+{
+	return DescriptorCache->GetSnapshotDescriptors();
+}
+
+void FZenSnapshotSyncModule::RefreshSnapshots() const
+{
+	DescriptorCache->Refresh();
+}
+
+TArray<FZenSnapshotProviderStats> FZenSnapshotSyncModule::GetSnapshotProviderStats() const
+{
+	return DescriptorCache->GetProviderStats();
 }
@@ -0,0 +1,270 @@
+#include "ZenSnapshotSyncPrefetcher.h"
+
+#include <Framework/Application/SlateApplication.h>
+#include <HAL/PlatformTime.h>
+#include <Logging/StructuredLog.h>
+#include <Misc/Paths.h>
+
+#include "ZenSnapshotSyncLog.h"
+#include "ZenSnapshotSyncModule.h"
+#include "ZenSnapshotSyncRequest.h"
+#include "ZenSnapshotSyncSettings.h"
+#include "ZenSnapshotSyncSlots.h"
+
+bool FZenSnapshotSyncPrefetcher::FPrefetch::IsRunning() const
+{
+	return PendingHandle.IsValid() || (Handle.IsValid() && !Handle.IsComplete() && !Handle.IsError());
+}
+
+FZenSnapshotSyncPrefetcher::FZenSnapshotSyncPrefetcher(FZenSnapshotSyncModule& InModule)
+	: Module(InModule)
+{
+	TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FZenSnapshotSyncPrefetcher::Tick), TickInterval);
+}
+
+FZenSnapshotSyncPrefetcher::~FZenSnapshotSyncPrefetcher()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+
+	for (TPair<FString, FPrefetch>& Pair : Prefetches)
+	{
+		if (Pair.Value.IsRunning())
+		{
+			StopPrefetch(Pair.Value);
+		}
+	}
+}
+
+bool FZenSnapshotSyncPrefetcher::TakePrefetched(const FZenSnapshotDescriptor& SnapshotDescriptor, FZenSnapshotSyncHandle& OutHandle, FString& OutOplogId)
+{
+	check(IsInGameThread());
+
+	const FString& TargetPlatform = SnapshotDescriptor.GetTargetPlatform();
+	SyncedSnapshotNames.Add(TargetPlatform, SnapshotDescriptor.GetName());
+
+	const FPrefetch* Prefetch = Prefetches.Find(TargetPlatform);
+	if (!Prefetch || Prefetch->SnapshotName != SnapshotDescriptor.GetName() || !Prefetch->Handle.IsComplete())
+	{
+		return false;
+	}
+
+	OutHandle = Prefetch->Handle;
+	OutOplogId = Prefetch->OplogId;
+
+	Prefetches.Remove(TargetPlatform);
+
+	return true;
+}
+
+void FZenSnapshotSyncPrefetcher::CancelPrefetch(const FString& TargetPlatform)
+{
+	check(IsInGameThread());
+
+	FPrefetch* Prefetch = Prefetches.Find(TargetPlatform);
+	if (!Prefetch)
+	{
+		return;
+	}
+
+	if (Prefetch->IsRunning())
+	{
+		StopPrefetch(*Prefetch);
+	}
+
+	Prefetches.Remove(TargetPlatform);
+}
+
+bool FZenSnapshotSyncPrefetcher::Tick(float DeltaTime)
+{
+	for (TPair<FString, FPrefetch>& Pair : Prefetches)
+	{
+		FPrefetch& Prefetch = Pair.Value;
+		if (!Prefetch.PendingHandle.IsValid() || !Prefetch.PendingHandle.IsReady())
+		{
+			continue;
+		}
+
+		Prefetch.Handle = Prefetch.PendingHandle.Get();
+		Prefetch.PendingHandle.Reset();
+
+		if (Prefetch.Handle.IsValid())
+		{
+			Prefetch.StatusSubscriptionHandle = Module.SubscribeSnapshotSyncStatus(Prefetch.Handle,
+				FZenSnapshotSyncModule::FOnSnapshotSyncStatusChanged::CreateRaw(this, &FZenSnapshotSyncPrefetcher::OnPrefetchStatusChanged, Pair.Key));
+		}
+		else
+		{
+			UE_LOGFMT(LogZenSnapshotSync, Warning, "Failed to request prefetch of snapshot '{Name}'", Prefetch.SnapshotName);
+		}
+	}
+
+	const UZenSnapshotSyncSettings* Settings = GetDefault<UZenSnapshotSyncSettings>();
+	if (!Settings->bEnablePrefetch)
+	{
+		for (auto It = Prefetches.CreateIterator(); It; ++It)
+		{
+			if (It.Value().IsRunning())
+			{
+				StopPrefetch(It.Value());
+				It.RemoveCurrent();
+			}
+		}
+
+		return true;
+	}
+
+	const double CurrentTime = FPlatformTime::Seconds();
+	const double IdleTime = FSlateApplication::IsInitialized() ? CurrentTime - FSlateApplication::Get().GetLastUserInteractionTime() : 0.0;
+	if (IdleTime < Settings->PrefetchIdleTime)
+	{
+		return true;
+	}
+
+	if (CurrentTime - LastRefreshTime >= RefreshInterval)
+	{
+		Module.RefreshSnapshots();
+		LastRefreshTime = CurrentTime;
+	}
+
+	// Providers list newer snapshots first
+	const TSharedRef<const TArray<FZenSnapshotDescriptor>> SnapshotDescriptors = Module.GetCachedSnapshots();
+	TMap<FString, const FZenSnapshotDescriptor*> LatestSnapshotDescriptors;
+	TSet<FString> SeenPlatforms;
+
+	for (const FZenSnapshotDescriptor& SnapshotDescriptor : *SnapshotDescriptors)
+	{
+		const FString& TargetPlatform = SnapshotDescriptor.GetTargetPlatform();
+
+		bool bAlreadySeen = false;
+		SeenPlatforms.Add(TargetPlatform, &bAlreadySeen);
+		if (bAlreadySeen)
+		{
+			continue;
+		}
+
+		// Platforms synced before have a project store file
+		const bool bTracked = Settings->PrefetchPlatforms.IsEmpty()
+			? FPaths::FileExists(FZenSnapshotSyncRequest::GetProjectStoreFilePath(TargetPlatform))
+			: Settings->PrefetchPlatforms.Contains(TargetPlatform);
+
+		if (bTracked)
+		{
+			LatestSnapshotDescriptors.Add(TargetPlatform, &SnapshotDescriptor);
+		}
+	}
+
+	bool bPrefetchRunning = false;
+	for (auto It = Prefetches.CreateIterator(); It; ++It)
+	{
+		if (!It.Value().IsRunning())
+		{
+			continue;
+		}
+
+		const FZenSnapshotDescriptor* const* LatestSnapshotDescriptor = LatestSnapshotDescriptors.Find(It.Key());
+		if (LatestSnapshotDescriptor && (*LatestSnapshotDescriptor)->GetName() != It.Value().SnapshotName)
+		{
+			StopPrefetch(It.Value());
+			It.RemoveCurrent();
+			continue;
+		}
+
+		bPrefetchRunning = true;
+	}
+
+	// One at a time to leave bandwidth for everything else
+	if (bPrefetchRunning)
+	{
+		return true;
+	}
+
+	for (const TPair<FString, const FZenSnapshotDescriptor*>& LatestSnapshotDescriptor : LatestSnapshotDescriptors)
+	{
+		const FString& SnapshotName = LatestSnapshotDescriptor.Value->GetName();
+		const FPrefetch* Prefetch = Prefetches.Find(LatestSnapshotDescriptor.Key);
+
+		// Tried again after a while
+		const bool bPrefetched = Prefetch && Prefetch->SnapshotName == SnapshotName && (Prefetch->Handle.IsComplete() || CurrentTime - Prefetch->StartTime < RefreshInterval);
+
+		if (SyncedSnapshotNames.FindRef(LatestSnapshotDescriptor.Key) != SnapshotName && !bPrefetched && !Module.IsSnapshotResident(*LatestSnapshotDescriptor.Value))
+		{
+			StartPrefetch(*LatestSnapshotDescriptor.Value);
+			break;
+		}
+	}
+
+	return true;
+}
+
+void FZenSnapshotSyncPrefetcher::StartPrefetch(const FZenSnapshotDescriptor& SnapshotDescriptor)
+{
+	const FString& TargetPlatform = SnapshotDescriptor.GetTargetPlatform();
+
+	FZenSnapshotSyncOptions Options;
+	Options.bActivate = false;
+
+	if (!FZenSnapshotSyncSlots::IsEnabled())
+	{
+		Options.OplogId = FZenSnapshotSyncRequest::ReadActiveOplogId(TargetPlatform) == TargetPlatform ? TargetPlatform + TEXT(".prefetch") : TargetPlatform;
+	}
+
+	// Never queued so stopping a prefetch never waits for its request
+	Options.Priority = EZenSnapshotSyncPriority::Low;
+	Options.bWaitForSlot = false;
+
+	FPrefetch& Prefetch = Prefetches.Add(TargetPlatform);
+	Prefetch.SnapshotName = SnapshotDescriptor.GetName();
+	Prefetch.StartTime = FPlatformTime::Seconds();
+	Prefetch.OplogId = Options.OplogId.IsEmpty() ? FZenSnapshotSyncSlots::MakeOplogId(TargetPlatform, Prefetch.SnapshotName) : Options.OplogId;
+
+	UE_LOGFMT(LogZenSnapshotSync, Display, "Prefetching snapshot '{Name}' into oplog '{OplogId}'", Prefetch.SnapshotName, Prefetch.OplogId);
+
+	Prefetch.PendingHandle = Module.RequestSnapshotSyncAsync(SnapshotDescriptor, Options);
+}
+
+void FZenSnapshotSyncPrefetcher::StopPrefetch(FPrefetch& Prefetch)
+{
+	Module.UnsubscribeSnapshotSyncStatus(Prefetch.StatusSubscriptionHandle);
+	Prefetch.StatusSubscriptionHandle.Reset();
+
+	if (Prefetch.PendingHandle.IsValid())
+	{
+		// Counted by the module so its shutdown waits for the cancellation instead of this outliving it
+		Module.CancelSnapshotSyncWhenRequested(MoveTemp(Prefetch.PendingHandle)).Next([SnapshotName = Prefetch.SnapshotName](bool bCancelled)
+		{
+			if (bCancelled)
+			{
+				UE_LOGFMT(LogZenSnapshotSync, Display, "Stopped prefetching snapshot '{Name}'", SnapshotName);
+			}
+		});
+
+		return;
+	}
+
+	if (Module.CancelSnapshotSync(Prefetch.Handle))
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Display, "Stopped prefetching snapshot '{Name}'", Prefetch.SnapshotName);
+	}
+}
+
+void FZenSnapshotSyncPrefetcher::OnPrefetchStatusChanged(const FZenSnapshotSyncHandle& Handle, FString TargetPlatform)
+{
+	FPrefetch* Prefetch = Prefetches.Find(TargetPlatform);
+	if (!Prefetch)
+	{
+		return;
+	}
+
+	Prefetch->Handle = Handle;
+
+	if (Handle.IsComplete())
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Display, "Prefetched snapshot '{Name}' into oplog '{OplogId}'", Prefetch->SnapshotName, Prefetch->OplogId);
+		Prefetch->StatusSubscriptionHandle.Reset();
+	}
+	else if (Handle.IsError())
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Warning, "Failed to prefetch snapshot '{Name}' ({Error})", Prefetch->SnapshotName, Handle.GetErrorMessage());
+		Prefetch->StatusSubscriptionHandle.Reset();
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <Async/Future.h>
+#include <Containers/Map.h>
+#include <Containers/Ticker.h>
+
+#include "ZenSnapshotSyncTypes.h"
+
+class FZenSnapshotSyncModule;
+
+// Imports the latest snapshot of tracked platforms into a staging oplog while the editor is idle, game thread only
+class FZenSnapshotSyncPrefetcher
+{
+public:
+	explicit FZenSnapshotSyncPrefetcher(FZenSnapshotSyncModule& InModule);
+	~FZenSnapshotSyncPrefetcher();
+
+	// Returns the oplog of a completed prefetch for the caller to activate
+	bool TakePrefetched(const FZenSnapshotDescriptor& SnapshotDescriptor, FZenSnapshotSyncHandle& OutHandle, FString& OutOplogId);
+
+	// Called before a platform is synced since its staging oplog may be imported into
+	void CancelPrefetch(const FString& TargetPlatform);
+
+private:
+	struct FPrefetch
+	{
+		FString SnapshotName;
+		FString OplogId;
+		double StartTime = 0.0;
+		TFuture<FZenSnapshotSyncHandle> PendingHandle;
+		FZenSnapshotSyncHandle Handle;
+		FDelegateHandle StatusSubscriptionHandle;
+
+		bool IsRunning() const;
+	};
+
+	static constexpr float TickInterval = 5.0f;
+	static constexpr double RefreshInterval = 300.0;
+
+	bool Tick(float DeltaTime);
+	void StartPrefetch(const FZenSnapshotDescriptor& SnapshotDescriptor);
+	void StopPrefetch(FPrefetch& Prefetch);
+	void OnPrefetchStatusChanged(const FZenSnapshotSyncHandle& Handle, FString TargetPlatform);
+
+	FZenSnapshotSyncModule& Module;
+	FTSTicker::FDelegateHandle TickHandle;
+	TMap<FString, FPrefetch> Prefetches;
+	TMap<FString, FString> SyncedSnapshotNames;
+	double LastRefreshTime = 0.0;
+};
@@ -0,0 +1,173 @@
+#include "ZenSnapshotSyncPreflight.h"
+
+#include <ZenServerHttp.h>
+#include <HAL/FileManager.h>
+#include <HAL/PlatformMisc.h>
+#include <IO/IoHash.h>
+#include <Logging/StructuredLog.h>
+#include <Misc/FileHelper.h>
+#include <Misc/Paths.h>
+#include <ProfilingDebugging/CpuProfilerTrace.h>
+#include <Serialization/CompactBinaryValidation.h>
+
+#include "ZenSnapshotSyncLog.h"
+#include "ZenSnapshotSyncMetrics.h"
+#include "ZenSnapshotSyncSettings.h"
+
+namespace ZenSnapshotSyncPreflight
+{
+	static void CollectHashes(FCbFieldView Field, TSet<FIoHash>& OutHashes)
+	{
+		if (Field.IsHash())
+		{
+			OutHashes.Add(Field.AsHash());
+		}
+		else if (Field.IsObject())
+		{
+			for (FCbFieldView Child : Field.AsObjectView())
+			{
+				CollectHashes(Child, OutHashes);
+			}
+		}
+		else if (Field.IsArray())
+		{
+			for (FCbFieldView Child : Field.AsArrayView())
+			{
+				CollectHashes(Child, OutHashes);
+			}
+		}
+	}
+
+	// Sharded by hash the way Zen server exports blocks and large attachments next to the container
+	static FString GetAttachmentPath(const FString& Directory, const FIoHash& Hash)
+	{
+		const FString HashString = LexToString(Hash);
+		return FPaths::Combine(Directory, HashString.Left(3), HashString.Mid(3, 2), HashString.RightChop(5));
+	}
+}
+
+FZenSnapshotSyncEstimate FZenSnapshotSyncPreflight::Estimate(const FCbObject& Params, const FString& ZenDataPath)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(ZenSnapshotSync_Preflight);
+
+	FZenSnapshotSyncEstimate Estimate;
+
+	if (const FCbObjectView FileParams = Params["file"].AsObjectView(); FileParams)
+	{
+		Estimate.SnapshotBytes = GetFileSourceSize(FString(FileParams["path"].AsString()), FString(FileParams["name"].AsString()));
+	}
+	else if (const FCbObjectView ZenParams = Params["zen"].AsObjectView(); ZenParams)
+	{
+		Estimate.SnapshotBytes = GetZenSourceSize(FString(ZenParams["url"].AsString()), FString(ZenParams["project"].AsString()), FString(ZenParams["oplog"].AsString()));
+	}
+
+	uint64 TotalBytes = 0;
+	uint64 FreeBytes = 0;
+	if (!ZenDataPath.IsEmpty() && FPlatformMisc::GetDiskTotalAndFreeSpace(ZenDataPath, TotalBytes, FreeBytes))
+	{
+		Estimate.FreeBytes = static_cast<int64>(FreeBytes);
+	}
+
+	const double BytesPerSecond = FZenSnapshotSyncMetrics::Get().GetImportThroughput();
+	if (Estimate.SnapshotBytes >= 0 && BytesPerSecond > 0.0)
+	{
+		Estimate.EstimatedSeconds = Estimate.SnapshotBytes / BytesPerSecond;
+	}
+
+	return Estimate;
+}
+
+bool FZenSnapshotSyncPreflight::Check(const FZenSnapshotSyncEstimate& Estimate, FStringView TargetPlatform, FString& OutError)
+{
+	const UZenSnapshotSyncProjectSettings* Settings = GetDefault<UZenSnapshotSyncProjectSettings>();
+	if (!Settings->bCheckFreeSpace)
+	{
+		return true;
+	}
+
+	constexpr int64 BytesPerMegabyte = 1024 * 1024;
+	if (Estimate.HasEnoughSpace(Settings->FreeSpaceMargin * BytesPerMegabyte))
+	{
+		// Nothing worth reporting when either size is unknown
+		if (Estimate.SnapshotBytes < 0 || Estimate.FreeBytes < 0)
+		{
+			return true;
+		}
+
+		if (Estimate.EstimatedSeconds >= 0.0)
+		{
+			UE_LOGFMT(LogZenSnapshotSync, Display, "Importing {Platform} snapshot of up to {SnapshotMB} MB with {FreeMB} MB free, estimated {Seconds}s",
+				TargetPlatform, Estimate.SnapshotBytes / BytesPerMegabyte, Estimate.FreeBytes / BytesPerMegabyte, FMath::CeilToInt64(Estimate.EstimatedSeconds));
+		}
+		else
+		{
+			UE_LOGFMT(LogZenSnapshotSync, Display, "Importing {Platform} snapshot of up to {SnapshotMB} MB with {FreeMB} MB free",
+				TargetPlatform, Estimate.SnapshotBytes / BytesPerMegabyte, Estimate.FreeBytes / BytesPerMegabyte);
+		}
+
+		return true;
+	}
+
+	OutError = FString::Printf(TEXT("Snapshot needs up to %lld MB but Zen server only has %lld MB free"), Estimate.SnapshotBytes / BytesPerMegabyte, Estimate.FreeBytes / BytesPerMegabyte);
+
+	if (Settings->bRefuseImportWhenLowOnSpace)
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Error, "Refusing to import {Platform} snapshot: {Error}", TargetPlatform, OutError);
+		return false;
+	}
+
+	// Zen server skips attachments already in its store so the snapshot may well fit
+	UE_LOGFMT(LogZenSnapshotSync, Warning, "Importing {Platform} snapshot anyway: {Error}", TargetPlatform, OutError);
+	OutError.Reset();
+
+	return true;
+}
+
+int64 FZenSnapshotSyncPreflight::GetFileSourceSize(const FString& Directory, const FString& FileName)
+{
+	TArray64<uint8> Container;
+	if (!FFileHelper::LoadFileToArray(Container, *FPaths::Combine(Directory, FileName))
+		|| ValidateCompactBinary(MakeMemoryView(Container), ECbValidateMode::Default) != ECbValidateError::None)
+	{
+		return -1;
+	}
+
+	// Only what the container references, other snapshots may share the directory
+	TSet<FIoHash> Hashes;
+	for (FCbFieldView Field : FCbObjectView(Container.GetData()))
+	{
+		ZenSnapshotSyncPreflight::CollectHashes(Field, Hashes);
+	}
+
+	IFileManager& FileManager = IFileManager::Get();
+
+	int64 TotalSize = Container.Num();
+	for (const FIoHash& Hash : Hashes)
+	{
+		TotalSize += FMath::Max<int64>(FileManager.FileSize(*ZenSnapshotSyncPreflight::GetAttachmentPath(Directory, Hash)), 0);
+	}
+
+	return TotalSize;
+}
+
+int64 FZenSnapshotSyncPreflight::GetZenSourceSize(const FString& Url, FStringView ProjectId, FStringView OplogId)
+{
+	using namespace UE::Zen;
+
+	FZenHttpRequestPool SourceRequestPool(Url, 1);
+	FZenScopedRequestPtr Request(&SourceRequestPool);
+
+	TStringBuilder<128> RequestUri;
+	RequestUri << TEXTVIEW("/prj/") << ProjectId << TEXTVIEW("/oplog/") << OplogId;
+
+	FZenSnapshotSyncMetrics::FScopedOperation HttpMetricsScope(EZenSnapshotSyncOperation::HttpRequest);
+	const FZenHttpRequest::Result Result = Request->PerformBlockingDownload(RequestUri, nullptr, EContentType::CbObject);
+	if (Result != FZenHttpRequest::Result::Success || Request->GetResponseCode() != 200)
+	{
+		return -1;
+	}
+
+	// Only reported by Zen server versions that track oplog sizes
+	const FCbFieldView TotalSize = Request->GetResponseAsObject()["totalsize"];
+	return TotalSize.IsInteger() ? static_cast<int64>(TotalSize.AsUInt64()) : -1;
+}
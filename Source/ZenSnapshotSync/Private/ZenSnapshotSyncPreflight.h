@@ -0,0 +1,19 @@
+#pragma once
+
+#include <Serialization/CompactBinary.h>
+
+#include "ZenSnapshotSyncTypes.h"
+
+// Estimates what an import transfers before any data moves, cloud sources report no size
+class FZenSnapshotSyncPreflight
+{
+public:
+	// Blocking
+	static FZenSnapshotSyncEstimate Estimate(const FCbObject& Params, const FString& ZenDataPath);
+
+	static bool Check(const FZenSnapshotSyncEstimate& Estimate, FStringView TargetPlatform, FString& OutError);
+
+private:
+	static int64 GetFileSourceSize(const FString& Directory, const FString& FileName);
+	static int64 GetZenSourceSize(const FString& Url, FStringView ProjectId, FStringView OplogId);
+};
@@ -0,0 +1,73 @@
+#include "ZenSnapshotSyncProjectCache.h"
+
+#include <HAL/PlatformTime.h>
+#include <Misc/ScopeLock.h>
+#include <Misc/StringBuilder.h>
+
+bool FZenSnapshotSyncProjectCache::IsProjectVerified(FStringView ProjectId) const
+{
+	return IsVerified(FString(ProjectId));
+}
+
+bool FZenSnapshotSyncProjectCache::IsOplogVerified(FStringView ProjectId, FStringView OplogId) const
+{
+	return IsVerified(MakeOplogKey(ProjectId, OplogId));
+}
+
+void FZenSnapshotSyncProjectCache::MarkProjectVerified(FStringView ProjectId)
+{
+	MarkVerified(FString(ProjectId));
+}
+
+void FZenSnapshotSyncProjectCache::MarkOplogVerified(FStringView ProjectId, FStringView OplogId)
+{
+	MarkVerified(MakeOplogKey(ProjectId, OplogId));
+}
+
+void FZenSnapshotSyncProjectCache::InvalidateProject(FStringView ProjectId)
+{
+	const FString ProjectKey(ProjectId);
+	const FString OplogKeyPrefix = MakeOplogKey(ProjectId, FStringView());
+
+	FScopeLock ScopeLock(&Lock);
+	for (auto It = VerifiedTimes.CreateIterator(); It; ++It)
+	{
+		if (It.Key() == ProjectKey || It.Key().StartsWith(OplogKeyPrefix))
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void FZenSnapshotSyncProjectCache::InvalidateOplog(FStringView ProjectId, FStringView OplogId)
+{
+	const FString OplogKey = MakeOplogKey(ProjectId, OplogId);
+
+	FScopeLock ScopeLock(&Lock);
+	VerifiedTimes.Remove(OplogKey);
+}
+
+void FZenSnapshotSyncProjectCache::InvalidateAll()
+{
+	FScopeLock ScopeLock(&Lock);
+	VerifiedTimes.Reset();
+}
+
+FString FZenSnapshotSyncProjectCache::MakeOplogKey(FStringView ProjectId, FStringView OplogId)
+{
+	return FString(WriteToString<128>(ProjectId, TEXT("/"), OplogId).ToView());
+}
+
+bool FZenSnapshotSyncProjectCache::IsVerified(const FString& Key) const
+{
+	FScopeLock ScopeLock(&Lock);
+
+	const double* VerifiedTime = VerifiedTimes.Find(Key);
+	return VerifiedTime && FPlatformTime::Seconds() - *VerifiedTime < TimeToLive;
+}
+
+void FZenSnapshotSyncProjectCache::MarkVerified(FString&& Key)
+{
+	FScopeLock ScopeLock(&Lock);
+	VerifiedTimes.Add(MoveTemp(Key), FPlatformTime::Seconds());
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <Containers/Map.h>
+#include <Containers/UnrealString.h>
+#include <HAL/CriticalSection.h>
+
+// Projects and oplogs recently seen on Zen server, so repeated sync requests can skip the checks
+class FZenSnapshotSyncProjectCache
+{
+public:
+	bool IsProjectVerified(FStringView ProjectId) const;
+	bool IsOplogVerified(FStringView ProjectId, FStringView OplogId) const;
+
+	void MarkProjectVerified(FStringView ProjectId);
+	void MarkOplogVerified(FStringView ProjectId, FStringView OplogId);
+
+	void InvalidateProject(FStringView ProjectId);
+	void InvalidateOplog(FStringView ProjectId, FStringView OplogId);
+	void InvalidateAll();
+
+private:
+	static constexpr double TimeToLive = 300.0;
+
+	static FString MakeOplogKey(FStringView ProjectId, FStringView OplogId);
+
+	bool IsVerified(const FString& Key) const;
+	void MarkVerified(FString&& Key);
+
+	mutable FCriticalSection Lock;
+	TMap<FString, double> VerifiedTimes;
+};
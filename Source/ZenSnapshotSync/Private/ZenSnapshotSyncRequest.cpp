@@ -0,0 +1,549 @@
+#include "ZenSnapshotSyncRequest.h"
+
+#include <Async/Async.h>
+#include <Dom/JsonObject.h>
+#include <HAL/FileManager.h>
+#include <HAL/PlatformTime.h>
+#include <Logging/StructuredLog.h>
+#include <Misc/FileHelper.h>
+#include <Misc/Paths.h>
+#include <ProfilingDebugging/CpuProfilerTrace.h>
+#include <Serialization/MemoryWriter.h>
+#include <Serialization/CompactBinaryWriter.h>
+#include <Serialization/JsonReader.h>
+#include <Serialization/JsonSerializer.h>
+#include <Serialization/JsonWriter.h>
+
+#include "ZenSnapshotSyncLog.h"
+#include "ZenSnapshotSyncMetrics.h"
+#include "ZenSnapshotSyncModule.h"
+#include "ZenSnapshotSyncProjectCache.h"
+#include "ZenSnapshotSyncRetry.h"
+#include "ZenSnapshotSyncSharedCache.h"
+
+namespace ZenSnapshotSyncRequest
+{
+	static const TCHAR* StepNames[] =
+	{
+		TEXT("QueryProject"),
+		TEXT("CreateProject"),
+		TEXT("WriteProjectStore"),
+		TEXT("QueryOplog"),
+		TEXT("CreateOplog"),
+		TEXT("ValidateOplog"),
+		TEXT("RequestImport"),
+	};
+}
+
+FZenSnapshotSyncRequest::FZenSnapshotSyncRequest(UE::Zen::FZenHttpRequestPool& InRequestPool, FZenSnapshotSyncProjectCache& InProjectCache, FString InProjectId, FString InTargetPlatform, FCbObject InParams, const FZenSnapshotSyncOptions& InOptions)
+	: RequestPool(InRequestPool)
+	, ProjectCache(InProjectCache)
+	, ProjectId(MoveTemp(InProjectId))
+	, TargetPlatform(MoveTemp(InTargetPlatform))
+	, OplogId(InOptions.OplogId.IsEmpty() ? TargetPlatform : InOptions.OplogId)
+	, ProjectStoreFilePath(GetProjectStoreFilePath(TargetPlatform))
+	, Params(MoveTemp(InParams))
+	, Options(InOptions)
+{
+	Handle.Telemetry.TargetPlatform = TargetPlatform;
+	Handle.Telemetry.OplogId = OplogId;
+}
+
+FZenSnapshotSyncHandle FZenSnapshotSyncRequest::Run()
+{
+	if (ProjectId.IsEmpty() || OplogId.IsEmpty())
+	{
+		return FZenSnapshotSyncHandle();
+	}
+
+	FZenSnapshotSyncMetrics::FScopedOperation MetricsScope(EZenSnapshotSyncOperation::RequestSync);
+	TRACE_CPUPROFILER_EVENT_SCOPE(ZenSnapshotSync_RequestSync);
+
+	Handle.Telemetry.RequestTime = FDateTime::UtcNow();
+
+	const double CheckStartTime = FPlatformTime::Seconds();
+	if (CheckProjectAndOplog())
+	{
+		Handle.Telemetry.AddPhase(TEXTVIEW("CheckProjectAndOplog"), FPlatformTime::Seconds() - CheckStartTime);
+	}
+
+	return RunUntil(EStep::Complete) == EStep::Complete ? MoveTemp(Handle) : FZenSnapshotSyncHandle();
+}
+
+bool FZenSnapshotSyncRequest::RunProjectSetup()
+{
+	if (ProjectId.IsEmpty())
+	{
+		return false;
+	}
+
+	return RunUntil(EStep::WriteProjectStore) == EStep::WriteProjectStore;
+}
+
+bool FZenSnapshotSyncRequest::RunActivation()
+{
+	if (ProjectId.IsEmpty() || OplogId.IsEmpty())
+	{
+		return false;
+	}
+
+	return RunUntil(EStep::QueryOplog) == EStep::QueryOplog;
+}
+
+bool FZenSnapshotSyncRequest::RunSlotActivation()
+{
+	using namespace UE::Zen;
+
+	if (ProjectId.IsEmpty() || OplogId.IsEmpty())
+	{
+		return false;
+	}
+
+	if (!ProjectCache.IsOplogVerified(ProjectId, OplogId))
+	{
+		TStringBuilder<128> RequestUri;
+		RequestUri << TEXTVIEW("/prj/") << ProjectId << TEXTVIEW("/oplog/") << OplogId;
+
+		FZenScopedRequestPtr CheckRequest(&RequestPool);
+
+		const FZenHttpRequest::Result Result = FZenSnapshotSyncRetry::Perform(*CheckRequest.Get(), FZenSnapshotSyncRetry::EMode::Idempotent,
+			[&CheckRequest, &RequestUri]() { return CheckRequest->PerformBlockingDownload(RequestUri, nullptr, EContentType::CbObject); });
+		if (Result != FZenHttpRequest::Result::Success || CheckRequest->GetResponseCode() != 200)
+		{
+			return false;
+		}
+
+		ProjectCache.MarkOplogVerified(ProjectId, OplogId);
+	}
+
+	return RunActivation();
+}
+
+bool FZenSnapshotSyncRequest::UseSharedSource(FZenSnapshotSyncSharedCache& SharedCache, const FString& SourceKey)
+{
+	FCbObject SharedParams;
+	if (SourceKey.IsEmpty() || !SharedCache.Resolve(RequestPool, SourceKey, ProjectId, OplogId, SharedParams))
+	{
+		return false;
+	}
+
+	Params = MoveTemp(SharedParams);
+
+	return true;
+}
+
+void FZenSnapshotSyncRequest::ValidateBeforeImport()
+{
+	bValidateOplog = true;
+}
+
+const FString& FZenSnapshotSyncRequest::GetProjectId() const
+{
+	return ProjectId;
+}
+
+const FString& FZenSnapshotSyncRequest::GetOplogId() const
+{
+	return OplogId;
+}
+
+const FCbObject& FZenSnapshotSyncRequest::GetParams() const
+{
+	return Params;
+}
+
+FString FZenSnapshotSyncRequest::GetProjectStoreFilePath(const FString& TargetPlatform)
+{
+	return FPaths::Combine(FPaths::ProjectDir(), TEXT("Saved"), TEXT("Cooked"), TargetPlatform, TEXT("ue.projectstore"));
+}
+
+FString FZenSnapshotSyncRequest::ReadActiveOplogId(const FString& TargetPlatform)
+{
+	FString ProjectStoreJson;
+	if (FFileHelper::LoadFileToString(ProjectStoreJson, *GetProjectStoreFilePath(TargetPlatform), FFileHelper::EHashOptions::None, FILEREAD_Silent))
+	{
+		TSharedPtr<FJsonObject> ProjectStore;
+		const TSharedPtr<FJsonObject>* ZenServer = nullptr;
+		FString ActiveOplogId;
+
+		if (FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(ProjectStoreJson), ProjectStore) && ProjectStore.IsValid()
+			&& ProjectStore->TryGetObjectField(TEXT("zenserver"), ZenServer) && (*ZenServer)->TryGetStringField(TEXT("oplogid"), ActiveOplogId))
+		{
+			return ActiveOplogId;
+		}
+	}
+
+	return TargetPlatform;
+}
+
+bool FZenSnapshotSyncRequest::CheckProjectAndOplog()
+{
+	using namespace UE::Zen;
+
+	if (ProjectCache.IsProjectVerified(ProjectId))
+	{
+		return false;
+	}
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(ZenSnapshotSync_CheckProjectAndOplog);
+
+	auto Exists = [this](bool bOplog)
+	{
+		TStringBuilder<128> RequestUri;
+		RequestUri << TEXTVIEW("/prj/") << ProjectId;
+
+		if (bOplog)
+		{
+			RequestUri << TEXTVIEW("/oplog/") << OplogId;
+		}
+
+		FZenScopedRequestPtr CheckRequest(&RequestPool);
+
+		const FZenHttpRequest::Result Result = FZenSnapshotSyncRetry::Perform(*CheckRequest.Get(), FZenSnapshotSyncRetry::EMode::Idempotent,
+			[&CheckRequest, &RequestUri]() { return CheckRequest->PerformBlockingDownload(RequestUri, nullptr, EContentType::CbObject); });
+		return Result == FZenHttpRequest::Result::Success && CheckRequest->GetResponseCode() == 200;
+	};
+
+	// Independent checks go out on separate pooled connections, the blocking one on the thread pool rather than a task graph worker
+	TFuture<bool> OplogExists = Async(EAsyncExecution::ThreadPool, [&Exists]() { return Exists(true); });
+	const bool bExists[2] = { Exists(false), OplogExists.Get() };
+
+	if (bExists[0])
+	{
+		ProjectCache.MarkProjectVerified(ProjectId);
+	}
+	else
+	{
+		bProjectMissing = true;
+	}
+
+	if (bExists[1])
+	{
+		ProjectCache.MarkOplogVerified(ProjectId, OplogId);
+	}
+	else
+	{
+		bOplogMissing = true;
+	}
+
+	return true;
+}
+
+FZenSnapshotSyncRequest::EStep FZenSnapshotSyncRequest::RunUntil(EStep FinalStep)
+{
+	using namespace UE::Zen;
+
+	FZenScopedRequestPtr ScopedRequest(&RequestPool);
+	Request = ScopedRequest.Get();
+
+	EStep Step = EStep::QueryProject;
+	while (Step != FinalStep && Step != EStep::Complete && Step != EStep::Failed)
+	{
+		Request->Reset();
+
+		const EStep CurrentStep = Step;
+		const double StepStartTime = FPlatformTime::Seconds();
+
+		switch (Step)
+		{
+		case EStep::QueryProject: Step = QueryProject(); break;
+		case EStep::CreateProject: Step = CreateProject(); break;
+		case EStep::WriteProjectStore: Step = WriteProjectStore(); break;
+		case EStep::QueryOplog: Step = QueryOplog(); break;
+		case EStep::CreateOplog: Step = CreateOplog(); break;
+		case EStep::ValidateOplog: Step = ValidateOplog(); break;
+		case EStep::RequestImport: Step = RequestImport(); break;
+		default: checkNoEntry(); Step = EStep::Failed; break;
+		}
+
+		const double StepEndTime = FPlatformTime::Seconds();
+		Handle.Telemetry.AddPhase(ZenSnapshotSyncRequest::StepNames[static_cast<int32>(CurrentStep)], StepEndTime - StepStartTime);
+		Handle.Telemetry.OperationStartTime = StepEndTime;
+	}
+
+	Request = nullptr;
+
+	return Step;
+}
+
+FZenSnapshotSyncRequest::EStep FZenSnapshotSyncRequest::QueryProject()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(ZenSnapshotSync_QueryProject);
+
+	using namespace UE::Zen;
+
+	if (ProjectCache.IsProjectVerified(ProjectId))
+	{
+		return EStep::WriteProjectStore;
+	}
+
+	if (bProjectMissing)
+	{
+		bProjectMissing = false;
+		return EStep::CreateProject;
+	}
+
+	TStringBuilder<128> RequestUri;
+	RequestUri << TEXTVIEW("/prj/") << ProjectId;
+
+	const FZenHttpRequest::Result Result = FZenSnapshotSyncRetry::Perform(*Request, FZenSnapshotSyncRetry::EMode::Idempotent,
+		[this, &RequestUri]() { return Request->PerformBlockingDownload(RequestUri, nullptr, EContentType::CbObject); });
+	if (Result != FZenHttpRequest::Result::Success || Request->GetResponseCode() != 200)
+	{
+		return EStep::CreateProject;
+	}
+
+	ProjectCache.MarkProjectVerified(ProjectId);
+
+	return EStep::WriteProjectStore;
+}
+
+FZenSnapshotSyncRequest::EStep FZenSnapshotSyncRequest::CreateProject()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(ZenSnapshotSync_CreateProject);
+
+	using namespace UE::Zen;
+
+	IFileManager& FileManager = IFileManager::Get();
+
+	FCbWriter PayloadWriter;
+	PayloadWriter.BeginObject();
+	PayloadWriter.AddString("id", ProjectId);
+	PayloadWriter.AddString("root", FileManager.ConvertToAbsolutePathForExternalAppForRead(*FPaths::RootDir()));
+	PayloadWriter.AddString("engine", FileManager.ConvertToAbsolutePathForExternalAppForRead(*FPaths::EngineDir()));
+	PayloadWriter.AddString("project", FileManager.ConvertToAbsolutePathForExternalAppForRead(*FPaths::ProjectDir()));
+	PayloadWriter.AddString("projectfile", FileManager.ConvertToAbsolutePathForExternalAppForRead(*FPaths::GetProjectFilePath()));
+	PayloadWriter.EndObject();
+
+	FCbFieldIterator Payload = PayloadWriter.Save();
+
+	TStringBuilder<128> RequestUri;
+	RequestUri << TEXTVIEW("/prj/") << ProjectId;
+
+	const FZenHttpRequest::Result Result = FZenSnapshotSyncRetry::Perform(*Request, FZenSnapshotSyncRetry::EMode::Rejected,
+		[this, &RequestUri, &Payload]() { return Request->PerformBlockingPost(RequestUri, Payload.AsObjectView()); });
+	if (Result != FZenHttpRequest::Result::Success || Request->GetResponseCode() != 201)
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Error, "Failed to create project '{ProjectId}' ({ResponseCode})", ProjectId, Request->GetResponseCode());
+		return EStep::Failed;
+	}
+
+	ProjectCache.MarkProjectVerified(ProjectId);
+
+	return EStep::WriteProjectStore;
+}
+
+FZenSnapshotSyncRequest::EStep FZenSnapshotSyncRequest::WriteProjectStore()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(ZenSnapshotSync_WriteProjectStore);
+
+	if (!Options.bActivate)
+	{
+		return EStep::QueryOplog;
+	}
+
+	TArray<uint8> ProjectStoreData;
+	{
+		FMemoryWriter ProjectStoreWriter(ProjectStoreData);
+
+		const TSharedRef<TJsonWriter<UTF8CHAR>> Writer = TJsonWriterFactory<UTF8CHAR>::Create(&ProjectStoreWriter);
+		Writer->WriteObjectStart();
+		Writer->WriteObjectStart(TEXT("zenserver"));
+		Writer->WriteValue(TEXT("projectid"), ProjectId);
+		Writer->WriteValue(TEXT("oplogid"), OplogId);
+		Writer->WriteObjectEnd();
+		Writer->WriteObjectEnd();
+		Writer->Close();
+	}
+
+	TArray<uint8> ExistingProjectStoreData;
+	if (FFileHelper::LoadFileToArray(ExistingProjectStoreData, *ProjectStoreFilePath, FILEREAD_Silent) && ExistingProjectStoreData == ProjectStoreData)
+	{
+		return EStep::QueryOplog;
+	}
+
+	// A cancelled import points the project store back at it
+	if (FPaths::FileExists(ProjectStoreFilePath))
+	{
+		const FString ActiveOplogId = ReadActiveOplogId(TargetPlatform);
+		if (ActiveOplogId != OplogId)
+		{
+			Handle.PreviousOplogId = ActiveOplogId;
+		}
+	}
+
+	const FString TempFilePath = ProjectStoreFilePath + TEXT(".tmp");
+	if (!FFileHelper::SaveArrayToFile(ProjectStoreData, *TempFilePath) || !IFileManager::Get().Move(*ProjectStoreFilePath, *TempFilePath))
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Error, "Failed to create project store file '{File}' ({ErrorCode})", ProjectStoreFilePath, FPlatformMisc::GetLastError());
+		return EStep::Failed;
+	}
+
+	return EStep::QueryOplog;
+}
+
+FZenSnapshotSyncRequest::EStep FZenSnapshotSyncRequest::QueryOplog()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(ZenSnapshotSync_QueryOplog);
+
+	using namespace UE::Zen;
+
+	if (ProjectCache.IsOplogVerified(ProjectId, OplogId))
+	{
+		return bValidateOplog ? EStep::ValidateOplog : EStep::RequestImport;
+	}
+
+	if (bOplogMissing)
+	{
+		bOplogMissing = false;
+		return EStep::CreateOplog;
+	}
+
+	TStringBuilder<128> RequestUri;
+	RequestUri << TEXTVIEW("/prj/") << ProjectId << TEXTVIEW("/oplog/") << OplogId;
+
+	const FZenHttpRequest::Result Result = FZenSnapshotSyncRetry::Perform(*Request, FZenSnapshotSyncRetry::EMode::Idempotent,
+		[this, &RequestUri]() { return Request->PerformBlockingDownload(RequestUri, nullptr, EContentType::CbObject); });
+	if (Result != FZenHttpRequest::Result::Success || Request->GetResponseCode() != 200)
+	{
+		return EStep::CreateOplog;
+	}
+
+	ProjectCache.MarkOplogVerified(ProjectId, OplogId);
+
+	return bValidateOplog ? EStep::ValidateOplog : EStep::RequestImport;
+}
+
+FZenSnapshotSyncRequest::EStep FZenSnapshotSyncRequest::CreateOplog()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(ZenSnapshotSync_CreateOplog);
+
+	using namespace UE::Zen;
+
+	FCbWriter PayloadWriter;
+	PayloadWriter.BeginObject();
+	PayloadWriter.AddString("gcpath", IFileManager::Get().ConvertToAbsolutePathForExternalAppForRead(*ProjectStoreFilePath));
+	PayloadWriter.EndObject();
+
+	FCbFieldIterator Payload = PayloadWriter.Save();
+
+	TStringBuilder<128> RequestUri;
+	RequestUri << TEXTVIEW("/prj/") << ProjectId << TEXTVIEW("/oplog/") << OplogId;
+
+	const FZenHttpRequest::Result Result = FZenSnapshotSyncRetry::Perform(*Request, FZenSnapshotSyncRetry::EMode::Rejected,
+		[this, &RequestUri, &Payload]() { return Request->PerformBlockingPost(RequestUri, Payload.AsObjectView()); });
+	if (Result != FZenHttpRequest::Result::Success || Request->GetResponseCode() != 201)
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Error, "Failed to create oplog '{OplogId}' ({ResponseCode})", OplogId, Request->GetResponseCode());
+		return EStep::Failed;
+	}
+
+	ProjectCache.MarkOplogVerified(ProjectId, OplogId);
+	Handle.bCreatedOplog = true;
+
+	return EStep::RequestImport;
+}
+
+FZenSnapshotSyncRequest::EStep FZenSnapshotSyncRequest::ValidateOplog()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(ZenSnapshotSync_ValidateOplog);
+
+	using namespace UE::Zen;
+
+	FCbWriter PayloadWriter;
+	PayloadWriter.BeginObject();
+	PayloadWriter.EndObject();
+
+	FCbFieldIterator Payload = PayloadWriter.Save();
+
+	TStringBuilder<128> RequestUri;
+	RequestUri << TEXTVIEW("/prj/") << ProjectId << TEXTVIEW("/oplog/") << OplogId << TEXTVIEW("/validate");
+
+	const FZenHttpRequest::Result Result = FZenSnapshotSyncRetry::Perform(*Request, FZenSnapshotSyncRetry::EMode::Idempotent,
+		[this, &RequestUri, &Payload]() { return Request->PerformBlockingPost(RequestUri, Payload.AsObjectView()); });
+	if (Result != FZenHttpRequest::Result::Success || Request->GetResponseCode() != 200)
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Display, "Failed to validate oplog '{OplogId}' ({ResponseCode}), resuming import without validation", OplogId, Request->GetResponseCode());
+		return EStep::RequestImport;
+	}
+
+	// Every array in the report lists damaged ops
+	for (FCbFieldView Field : Request->GetResponseAsObject())
+	{
+		if (Field.IsArray() && Field.AsArrayView().Num() > 0)
+		{
+			bForceImport = true;
+		}
+	}
+
+	if (bForceImport)
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Warning, "Oplog '{OplogId}' left behind by a cancelled import is damaged, fetching all of its data again", OplogId);
+	}
+	else
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Display, "Resuming import into oplog '{OplogId}' left behind by a cancelled import", OplogId);
+	}
+
+	return EStep::RequestImport;
+}
+
+FZenSnapshotSyncRequest::EStep FZenSnapshotSyncRequest::RequestImport()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(ZenSnapshotSync_RequestImport);
+
+	using namespace UE::Zen;
+
+	FCbWriter PayloadWriter;
+	PayloadWriter.BeginObject();
+	PayloadWriter.AddString("method", "import");
+	PayloadWriter.BeginObject("params");
+	for (FCbFieldView Field : Params)
+	{
+		PayloadWriter.AddField(Field.GetName(), Field);
+	}
+
+	// Zen server only fetches attachments missing from its store unless forced
+	const bool bFull = Options.Mode == EZenSnapshotSyncMode::Full;
+	if (bFull || bForceImport)
+	{
+		PayloadWriter.AddBool("force", true);
+	}
+
+	if (bFull)
+	{
+		PayloadWriter.AddBool("clean", true);
+	}
+	PayloadWriter.EndObject();
+	PayloadWriter.EndObject();
+
+	FCbFieldIterator Payload = PayloadWriter.Save();
+
+	TStringBuilder<128> RequestUri;
+	RequestUri << TEXTVIEW("/prj/") << ProjectId << TEXTVIEW("/oplog/") << OplogId << TEXTVIEW("/rpc");
+
+	const FZenHttpRequest::Result Result = FZenSnapshotSyncRetry::Perform(*Request, FZenSnapshotSyncRetry::EMode::Rejected,
+		[this, &RequestUri, &Payload]() { return Request->PerformBlockingPost(RequestUri, Payload.AsObjectView()); });
+	if (Result != FZenHttpRequest::Result::Success)
+	{
+		ProjectCache.InvalidateAll();
+	}
+	else if (Request->GetResponseCode() == 404 && !bRevalidated)
+	{
+		// Project or oplog may have been removed since they were cached
+		ProjectCache.InvalidateProject(ProjectId);
+		bRevalidated = true;
+
+		return EStep::QueryProject;
+	}
+
+	if (Result != FZenHttpRequest::Result::Success || Request->GetResponseCode() != 202)
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Error, "Failed to import oplog '{OplogId}' ({ResponseCode})", OplogId, Request->GetResponseCode());
+		return EStep::Failed;
+	}
+
+	Handle.JobId = FString(FZenSnapshotSyncModule::GetResponseBufferAsString(Request->GetResponseBuffer()));
+
+	return EStep::Complete;
+}
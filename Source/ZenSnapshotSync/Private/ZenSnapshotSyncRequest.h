@@ -0,0 +1,84 @@
+#pragma once
+
+#include <ZenServerHttp.h>
+#include <Serialization/CompactBinary.h>
+
+#include "ZenSnapshotSyncTypes.h"
+
+class FZenSnapshotSyncProjectCache;
+class FZenSnapshotSyncSharedCache;
+
+// Runs the project/oplog setup and import request chain for a single snapshot sync, each step blocks on one request
+class FZenSnapshotSyncRequest
+{
+public:
+	FZenSnapshotSyncRequest(UE::Zen::FZenHttpRequestPool& InRequestPool, FZenSnapshotSyncProjectCache& InProjectCache, FString InProjectId, FString InTargetPlatform, FCbObject InParams, const FZenSnapshotSyncOptions& InOptions);
+
+	FZenSnapshotSyncHandle Run();
+	bool RunProjectSetup();
+
+	// Points the project store at an oplog imported beforehand
+	bool RunActivation();
+
+	// Like RunActivation but leaves the project store alone unless Zen server still has the oplog
+	bool RunSlotActivation();
+
+	// Returns false if no other project on Zen server holds the snapshot
+	bool UseSharedSource(FZenSnapshotSyncSharedCache& SharedCache, const FString& SourceKey);
+
+	// Damaged oplogs left by a cancelled import are imported into with force
+	void ValidateBeforeImport();
+
+	const FString& GetProjectId() const;
+	const FString& GetOplogId() const;
+	const FCbObject& GetParams() const;
+
+	static FString GetProjectStoreFilePath(const FString& TargetPlatform);
+
+	// The platform name if the project store points at none yet
+	static FString ReadActiveOplogId(const FString& TargetPlatform);
+
+private:
+	enum class EStep : uint8
+	{
+		QueryProject,
+		CreateProject,
+		WriteProjectStore,
+		QueryOplog,
+		CreateOplog,
+		ValidateOplog,
+		RequestImport,
+		Complete,
+		Failed,
+	};
+
+	// Returns false if the checks were left to the steps
+	bool CheckProjectAndOplog();
+
+	EStep RunUntil(EStep FinalStep);
+
+	EStep QueryProject();
+	EStep CreateProject();
+	EStep WriteProjectStore();
+	EStep QueryOplog();
+	EStep CreateOplog();
+	EStep ValidateOplog();
+	EStep RequestImport();
+
+	UE::Zen::FZenHttpRequestPool& RequestPool;
+	FZenSnapshotSyncProjectCache& ProjectCache;
+	const FString ProjectId;
+	const FString TargetPlatform;
+	const FString OplogId;
+	const FString ProjectStoreFilePath;
+	FCbObject Params;
+	const FZenSnapshotSyncOptions Options;
+
+	UE::Zen::FZenHttpRequest* Request = nullptr;
+	FZenSnapshotSyncHandle Handle;
+	bool bRevalidated = false;
+	bool bProjectMissing = false;
+	bool bOplogMissing = false;
+	bool bValidateOplog = false;
+	bool bForceImport = false;
+};
@@ -0,0 +1,90 @@
+#include "ZenSnapshotSyncRetry.h"
+
+#include <CoreGlobals.h>
+#include <HAL/PlatformProcess.h>
+#include <Logging/StructuredLog.h>
+#include <Misc/ScopeLock.h>
+
+#include "ZenSnapshotSyncLog.h"
+#include "ZenSnapshotSyncMetrics.h"
+#include "ZenSnapshotSyncStats.h"
+
+DEFINE_STAT(STAT_ZenSnapshotSync_HttpRetries);
+
+FCriticalSection FZenSnapshotSyncRetry::BudgetLock;
+float FZenSnapshotSyncRetry::Budget = FZenSnapshotSyncRetry::MaxBudget;
+
+UE::Zen::FZenHttpRequest::Result FZenSnapshotSyncRetry::Perform(UE::Zen::FZenHttpRequest& Request, EMode Mode, TFunctionRef<UE::Zen::FZenHttpRequest::Result()> IssueRequest)
+{
+	using namespace UE::Zen;
+
+	for (int32 Attempt = 1;; ++Attempt)
+	{
+		FZenHttpRequest::Result Result;
+		{
+			FZenSnapshotSyncMetrics::FScopedOperation HttpMetricsScope(EZenSnapshotSyncOperation::HttpRequest);
+			Result = IssueRequest();
+		}
+
+		const int32 ResponseCode = Request.GetResponseCode();
+		if (!IsTransientFailure(Result, ResponseCode, Mode))
+		{
+			DepositBudget();
+			return Result;
+		}
+
+		if (Attempt == MaxAttempts || IsEngineExitRequested() || !WithdrawBudget())
+		{
+			return Result;
+		}
+
+		// Equal jitter keeps a minimum wait while spreading out requests that failed together
+		const double Delay = FMath::Min(InitialDelay * FMath::Pow(2.0, Attempt - 1), MaxDelay);
+		const double JitteredDelay = Delay * 0.5 + FMath::FRandRange(0.0, Delay * 0.5);
+
+		UE_LOGFMT(LogZenSnapshotSync, Verbose, "Retrying request after transient failure ({ResponseCode}), attempt {Attempt} in {Delay}s",
+			ResponseCode, Attempt + 1, JitteredDelay);
+
+		INC_DWORD_STAT(STAT_ZenSnapshotSync_HttpRetries);
+
+		FPlatformProcess::Sleep(static_cast<float>(JitteredDelay));
+		Request.Reset();
+	}
+}
+
+bool FZenSnapshotSyncRetry::IsTransientFailure(UE::Zen::FZenHttpRequest::Result Result, int32 ResponseCode, EMode Mode)
+{
+	using namespace UE::Zen;
+
+	// Neither 503 nor 429 processed the request
+	if (Result == FZenHttpRequest::Result::Success && (ResponseCode == 503 || ResponseCode == 429))
+	{
+		return true;
+	}
+
+	if (Mode != EMode::Idempotent)
+	{
+		return false;
+	}
+
+	return Result != FZenHttpRequest::Result::Success || ResponseCode >= 500;
+}
+
+bool FZenSnapshotSyncRetry::WithdrawBudget()
+{
+	FScopeLock ScopeLock(&BudgetLock);
+
+	if (Budget < 1.0f)
+	{
+		return false;
+	}
+
+	Budget -= 1.0f;
+	return true;
+}
+
+void FZenSnapshotSyncRetry::DepositBudget()
+{
+	FScopeLock ScopeLock(&BudgetLock);
+	Budget = FMath::Min(Budget + BudgetPerSuccess, MaxBudget);
+}
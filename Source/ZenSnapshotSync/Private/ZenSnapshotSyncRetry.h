@@ -0,0 +1,36 @@
+#pragma once
+
+#include <ZenServerHttp.h>
+#include <HAL/CriticalSection.h>
+#include <Templates/Function.h>
+
+// Retries transient failures with jittered backoff, drawing from a budget shared by all requests that refills with successes
+class FZenSnapshotSyncRetry
+{
+public:
+	enum class EMode : uint8
+	{
+		Idempotent,
+		// Only retried when Zen server did not process the request
+		Rejected,
+	};
+
+	// IssueRequest performs a single attempt
+	static UE::Zen::FZenHttpRequest::Result Perform(UE::Zen::FZenHttpRequest& Request, EMode Mode, TFunctionRef<UE::Zen::FZenHttpRequest::Result()> IssueRequest);
+
+	static bool IsTransientFailure(UE::Zen::FZenHttpRequest::Result Result, int32 ResponseCode, EMode Mode);
+
+private:
+	static constexpr int32 MaxAttempts = 4;
+	static constexpr double InitialDelay = 0.25;
+	static constexpr double MaxDelay = 4.0;
+
+	static constexpr float MaxBudget = 20.0f;
+	static constexpr float BudgetPerSuccess = 0.2f;
+
+	static bool WithdrawBudget();
+	static void DepositBudget();
+
+	static FCriticalSection BudgetLock;
+	static float Budget;
+};
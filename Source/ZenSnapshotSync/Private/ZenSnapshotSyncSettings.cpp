@@ -0,0 +1,20 @@
+#include "ZenSnapshotSyncSettings.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(ZenSnapshotSyncSettings)
+
+UZenSnapshotSyncSettings::UZenSnapshotSyncSettings()
+{
+	CategoryName = TEXT("Plugins");
+	SectionName = TEXT("ZenSnapshotSyncUser");
+}
+
+FName UZenSnapshotSyncSettings::GetContainerName() const
+{
+	return TEXT("Editor");
+}
+
+UZenSnapshotSyncProjectSettings::UZenSnapshotSyncProjectSettings()
+{
+	CategoryName = TEXT("Plugins");
+	SectionName = TEXT("ZenSnapshotSync");
+}
@@ -0,0 +1,230 @@
+#include "ZenSnapshotSyncSharedCache.h"
+
+#include <Dom/JsonObject.h>
+#include <HAL/FileManager.h>
+#include <HAL/PlatformProcess.h>
+#include <Logging/StructuredLog.h>
+#include <Misc/FileHelper.h>
+#include <Misc/ScopeLock.h>
+#include <Serialization/CompactBinaryWriter.h>
+#include <Serialization/JsonReader.h>
+#include <Serialization/JsonSerializer.h>
+#include <Serialization/JsonWriter.h>
+
+#include "ZenSnapshotSyncLog.h"
+#include "ZenSnapshotSyncRetry.h"
+
+FZenSnapshotSyncSharedCache::FZenSnapshotSyncSharedCache(FString InFilePath, FString InZenUrl)
+	: FilePath(MoveTemp(InFilePath))
+	, ZenUrl(MoveTemp(InZenUrl))
+{
+}
+
+FString FZenSnapshotSyncSharedCache::MakeSourceKey(const FCbObject& Params) const
+{
+	if (const FCbObjectView CloudParams = Params["cloud"].AsObjectView(); CloudParams)
+	{
+		return FString::Printf(TEXT("cloud|%s|%s|%s|%s"), *FString(CloudParams["url"].AsString()), *FString(CloudParams["namespace"].AsString()),
+			*FString(CloudParams["bucket"].AsString()), *FString(CloudParams["key"].AsString()));
+	}
+
+	if (const FCbObjectView ZenParams = Params["zen"].AsObjectView(); ZenParams && FString(ZenParams["url"].AsString()) != ZenUrl)
+	{
+		return FString::Printf(TEXT("zen|%s|%s|%s"), *FString(ZenParams["url"].AsString()), *FString(ZenParams["project"].AsString()),
+			*FString(ZenParams["oplog"].AsString()));
+	}
+
+	return FString();
+}
+
+bool FZenSnapshotSyncSharedCache::Resolve(UE::Zen::FZenHttpRequestPool& RequestPool, const FString& SourceKey, FStringView ProjectId, FStringView OplogId, FCbObject& OutParams)
+{
+	using namespace UE::Zen;
+
+	FEntry SharedEntry;
+	{
+		const TArray<FEntry> Entries = Load();
+		const FEntry* Entry = Entries.FindByPredicate([this, &SourceKey, ProjectId, OplogId](const FEntry& ExistingEntry)
+		{
+			return ExistingEntry.ZenUrl == ZenUrl && ExistingEntry.SourceKey == SourceKey && (ExistingEntry.ProjectId != ProjectId || ExistingEntry.OplogId != OplogId);
+		});
+
+		if (!Entry)
+		{
+			return false;
+		}
+
+		SharedEntry = *Entry;
+	}
+
+	TStringBuilder<128> RequestUri;
+	RequestUri << TEXTVIEW("/prj/") << SharedEntry.ProjectId << TEXTVIEW("/oplog/") << SharedEntry.OplogId;
+
+	FZenScopedRequestPtr Request(&RequestPool);
+
+	const FZenHttpRequest::Result Result = FZenSnapshotSyncRetry::Perform(*Request.Get(), FZenSnapshotSyncRetry::EMode::Idempotent,
+		[&Request, &RequestUri]() { return Request->PerformBlockingDownload(RequestUri, nullptr, EContentType::CbObject); });
+	if (Result != FZenHttpRequest::Result::Success || Request->GetResponseCode() != 200)
+	{
+		// Zen server may just be busy
+		if (Result == FZenHttpRequest::Result::Success && Request->GetResponseCode() == 404)
+		{
+			UE_LOGFMT(LogZenSnapshotSync, Display, "Forgetting shared snapshot in oplog '{ProjectId}/{OplogId}' that no longer exists", SharedEntry.ProjectId, SharedEntry.OplogId);
+			Invalidate(SharedEntry.ProjectId, SharedEntry.OplogId);
+		}
+
+		return false;
+	}
+
+	FCbWriter ParamsWriter;
+	ParamsWriter.BeginObject();
+	ParamsWriter.BeginObject("zen");
+	ParamsWriter.AddString("url", ZenUrl);
+	ParamsWriter.AddString("project", SharedEntry.ProjectId);
+	ParamsWriter.AddString("oplog", SharedEntry.OplogId);
+	ParamsWriter.EndObject();
+	ParamsWriter.EndObject();
+
+	OutParams = ParamsWriter.Save().AsObject();
+
+	UE_LOGFMT(LogZenSnapshotSync, Display, "Importing snapshot from local oplog '{ProjectId}/{OplogId}' instead of '{Source}'", SharedEntry.ProjectId, SharedEntry.OplogId, SourceKey);
+
+	return true;
+}
+
+void FZenSnapshotSyncSharedCache::Invalidate(FStringView ProjectId, FStringView OplogId)
+{
+	Update([this, ProjectId, OplogId](TArray<FEntry>& Entries)
+	{
+		return Entries.RemoveAll([this, ProjectId, OplogId](const FEntry& Entry)
+		{
+			return Entry.ZenUrl == ZenUrl && Entry.ProjectId == ProjectId && Entry.OplogId == OplogId;
+		}) > 0;
+	});
+}
+
+void FZenSnapshotSyncSharedCache::Add(const FString& JobId, FString SourceKey, FStringView ProjectId, FStringView OplogId)
+{
+	FScopeLock ScopeLock(&Lock);
+	PendingEntries.Add(JobId, { ZenUrl, MoveTemp(SourceKey), FString(ProjectId), FString(OplogId), FDateTime() });
+}
+
+void FZenSnapshotSyncSharedCache::Finish(FStringView JobId, bool bSucceeded)
+{
+	FEntry FinishedEntry;
+	{
+		FScopeLock ScopeLock(&Lock);
+
+		if (!PendingEntries.RemoveAndCopyValue(FString(JobId), FinishedEntry) || !bSucceeded)
+		{
+			return;
+		}
+	}
+
+	FinishedEntry.ImportTime = FDateTime::UtcNow();
+
+	// An oplog holds one snapshot at a time
+	Update([&FinishedEntry](TArray<FEntry>& Entries)
+	{
+		Entries.RemoveAll([&FinishedEntry](const FEntry& Entry)
+		{
+			return Entry.ZenUrl == FinishedEntry.ZenUrl && Entry.ProjectId == FinishedEntry.ProjectId && Entry.OplogId == FinishedEntry.OplogId;
+		});
+		Entries.Add(MoveTemp(FinishedEntry));
+		return true;
+	});
+}
+
+void FZenSnapshotSyncSharedCache::Update(TFunctionRef<bool(TArray<FEntry>&)> Modify)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	FPlatformProcess::FSystemWideCriticalSection RegistryLock(TEXT("ZenSnapshotSyncSharedSnapshots"), FTimespan::FromSeconds(RegistryLockTimeout));
+	if (!RegistryLock.IsValid())
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Warning, "Timed out waiting for another editor to update shared snapshot registry '{File}'", FilePath);
+		return;
+	}
+
+	TArray<FEntry> Entries = Load();
+	if (Modify(Entries))
+	{
+		Save(Entries);
+	}
+}
+
+TArray<FZenSnapshotSyncSharedCache::FEntry> FZenSnapshotSyncSharedCache::Load() const
+{
+	TArray<FEntry> Entries;
+
+	FString RegistryJson;
+	if (!FFileHelper::LoadFileToString(RegistryJson, *FilePath, FFileHelper::EHashOptions::None, FILEREAD_Silent))
+	{
+		return Entries;
+	}
+
+	TSharedPtr<FJsonObject> Registry;
+	const TArray<TSharedPtr<FJsonValue>>* Snapshots = nullptr;
+
+	if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(RegistryJson), Registry) || !Registry.IsValid() || !Registry->TryGetArrayField(TEXT("snapshots"), Snapshots))
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Warning, "Ignoring unreadable shared snapshot registry '{File}'", FilePath);
+		return Entries;
+	}
+
+	for (const TSharedPtr<FJsonValue>& Snapshot : *Snapshots)
+	{
+		const TSharedPtr<FJsonObject>* SnapshotObject = nullptr;
+		if (!Snapshot->TryGetObject(SnapshotObject))
+		{
+			continue;
+		}
+
+		FEntry Entry;
+		FString ImportTime;
+
+		(*SnapshotObject)->TryGetStringField(TEXT("zenurl"), Entry.ZenUrl);
+		(*SnapshotObject)->TryGetStringField(TEXT("source"), Entry.SourceKey);
+		(*SnapshotObject)->TryGetStringField(TEXT("projectid"), Entry.ProjectId);
+		(*SnapshotObject)->TryGetStringField(TEXT("oplogid"), Entry.OplogId);
+		(*SnapshotObject)->TryGetStringField(TEXT("importtime"), ImportTime);
+		FDateTime::ParseIso8601(*ImportTime, Entry.ImportTime);
+
+		if (!Entry.ZenUrl.IsEmpty() && !Entry.SourceKey.IsEmpty() && !Entry.ProjectId.IsEmpty() && !Entry.OplogId.IsEmpty())
+		{
+			Entries.Add(MoveTemp(Entry));
+		}
+	}
+
+	return Entries;
+}
+
+void FZenSnapshotSyncSharedCache::Save(const TArray<FEntry>& Entries) const
+{
+	FString RegistryJson;
+
+	const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&RegistryJson);
+	Writer->WriteObjectStart();
+	Writer->WriteArrayStart(TEXT("snapshots"));
+
+	for (const FEntry& Entry : Entries)
+	{
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("zenurl"), Entry.ZenUrl);
+		Writer->WriteValue(TEXT("source"), Entry.SourceKey);
+		Writer->WriteValue(TEXT("projectid"), Entry.ProjectId);
+		Writer->WriteValue(TEXT("oplogid"), Entry.OplogId);
+		Writer->WriteValue(TEXT("importtime"), Entry.ImportTime.ToIso8601());
+		Writer->WriteObjectEnd();
+	}
+
+	Writer->WriteArrayEnd();
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	const FString TempFilePath = FilePath + TEXT(".tmp");
+	if (!FFileHelper::SaveStringToFile(RegistryJson, *TempFilePath) || !IFileManager::Get().Move(*FilePath, *TempFilePath))
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Warning, "Failed to write shared snapshot registry '{File}'", FilePath);
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <ZenServerHttp.h>
+#include <Containers/Array.h>
+#include <Containers/Map.h>
+#include <HAL/CriticalSection.h>
+#include <Misc/DateTime.h>
+#include <Serialization/CompactBinary.h>
+#include <Templates/Function.h>
+
+// Which project on Zen server holds a completed import of a remote snapshot, shared by all projects of the user
+class FZenSnapshotSyncSharedCache
+{
+public:
+	FZenSnapshotSyncSharedCache(FString InFilePath, FString InZenUrl);
+
+	// Empty for sources that are already local
+	FString MakeSourceKey(const FCbObject& Params) const;
+
+	// Blocking, rewrites the params to import from another project that holds the snapshot
+	bool Resolve(UE::Zen::FZenHttpRequestPool& RequestPool, const FString& SourceKey, FStringView ProjectId, FStringView OplogId, FCbObject& OutParams);
+
+	// Called before anything is imported into the oplog
+	void Invalidate(FStringView ProjectId, FStringView OplogId);
+
+	void Add(const FString& JobId, FString SourceKey, FStringView ProjectId, FStringView OplogId);
+	void Finish(FStringView JobId, bool bSucceeded);
+
+private:
+	struct FEntry
+	{
+		FString ZenUrl;
+		FString SourceKey;
+		FString ProjectId;
+		FString OplogId;
+		FDateTime ImportTime;
+	};
+
+	static constexpr double RegistryLockTimeout = 5.0;
+
+	// Modify returns whether the entries need to be written back
+	void Update(TFunctionRef<bool(TArray<FEntry>&)> Modify);
+	TArray<FEntry> Load() const;
+	void Save(const TArray<FEntry>& Entries) const;
+
+	const FString FilePath;
+	const FString ZenUrl;
+
+	FCriticalSection Lock;
+	TMap<FString, FEntry> PendingEntries;
+};
@@ -0,0 +1,335 @@
+#include "ZenSnapshotSyncSlots.h"
+
+#include <Algo/Sort.h>
+#include <Async/Async.h>
+#include <Dom/JsonObject.h>
+#include <HAL/FileManager.h>
+#include <Logging/StructuredLog.h>
+#include <Misc/Crc.h>
+#include <Misc/FileHelper.h>
+#include <Misc/ScopeLock.h>
+#include <Serialization/JsonReader.h>
+#include <Serialization/JsonSerializer.h>
+#include <Serialization/JsonWriter.h>
+
+#include "ZenSnapshotSyncLog.h"
+#include "ZenSnapshotSyncSettings.h"
+
+FZenSnapshotSyncSlots::FZenSnapshotSyncSlots(FString InFilePath)
+	: FilePath(MoveTemp(InFilePath))
+{
+	Load();
+}
+
+FZenSnapshotSyncSlots::~FZenSnapshotSyncSlots()
+{
+	if (PendingSave.IsValid())
+	{
+		PendingSave.Wait();
+	}
+}
+
+bool FZenSnapshotSyncSlots::IsEnabled()
+{
+	return GetMaxResidentSnapshots() > 1;
+}
+
+int32 FZenSnapshotSyncSlots::GetMaxResidentSnapshots()
+{
+	return GetDefault<UZenSnapshotSyncSettings>()->MaxResidentSnapshots;
+}
+
+FString FZenSnapshotSyncSlots::MakeOplogId(FStringView TargetPlatform, FStringView SnapshotName)
+{
+	TStringBuilder<128> OplogId;
+	OplogId << TargetPlatform << TEXT('.');
+
+	for (const TCHAR Char : SnapshotName)
+	{
+		OplogId.AppendChar(FChar::IsAlnum(Char) || Char == TEXT('-') || Char == TEXT('_') || Char == TEXT('.') ? Char : TEXT('_'));
+	}
+
+	// Long names are cut short, the hash of the full name keeps them apart
+	if (OplogId.Len() > MaxOplogIdLength)
+	{
+		const FString Hash = FString::Printf(TEXT(".%08x"), FCrc::StrCrc32(*FString(SnapshotName)));
+		OplogId.RemoveSuffix(OplogId.Len() - (MaxOplogIdLength - Hash.Len()));
+		OplogId << Hash;
+	}
+
+	return FString(OplogId.ToView());
+}
+
+FString FZenSnapshotSyncSlots::MakeParamsHash(const FCbObject& Params)
+{
+	return LexToString(Params.GetHash());
+}
+
+FString FZenSnapshotSyncSlots::Acquire(FStringView TargetPlatform, FStringView SnapshotName, FStringView ParamsHash)
+{
+	FString OplogId = MakeOplogId(TargetPlatform, SnapshotName);
+
+	FScopeLock ScopeLock(&Lock);
+
+	FZenSnapshotSyncSlot* Slot = Slots.FindByPredicate([&OplogId](const FZenSnapshotSyncSlot& ExistingSlot) { return ExistingSlot.OplogId == OplogId; });
+	if (!Slot)
+	{
+		Slot = &Slots.AddDefaulted_GetRef();
+		Slot->OplogId = OplogId;
+	}
+
+	// Names that only differ in characters an oplog ID cannot hold share a slot
+	if (Slot->TargetPlatform != TargetPlatform || Slot->SnapshotName != SnapshotName || Slot->ParamsHash != ParamsHash)
+	{
+		Slot->TargetPlatform = FString(TargetPlatform);
+		Slot->SnapshotName = FString(SnapshotName);
+		Slot->ParamsHash = FString(ParamsHash);
+		Slot->JobId.Reset();
+		Slot->bResident = false;
+	}
+
+	Slot->LastUsedTime = FDateTime::UtcNow();
+	Save();
+
+	return OplogId;
+}
+
+bool FZenSnapshotSyncSlots::TakeResident(FStringView TargetPlatform, FStringView SnapshotName, FStringView ParamsHash, FZenSnapshotSyncSlot& OutSlot)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	FZenSnapshotSyncSlot* Slot = Slots.FindByPredicate([TargetPlatform, SnapshotName, ParamsHash](const FZenSnapshotSyncSlot& ExistingSlot)
+	{
+		return ExistingSlot.bResident && ExistingSlot.TargetPlatform == TargetPlatform && ExistingSlot.SnapshotName == SnapshotName && ExistingSlot.ParamsHash == ParamsHash;
+	});
+
+	if (!Slot)
+	{
+		return false;
+	}
+
+	Slot->LastUsedTime = FDateTime::UtcNow();
+	Save();
+
+	OutSlot = *Slot;
+
+	return true;
+}
+
+bool FZenSnapshotSyncSlots::IsResident(FStringView TargetPlatform, FStringView SnapshotName, FStringView ParamsHash) const
+{
+	FScopeLock ScopeLock(&Lock);
+
+	return Slots.ContainsByPredicate([TargetPlatform, SnapshotName, ParamsHash](const FZenSnapshotSyncSlot& Slot)
+	{
+		return Slot.bResident && Slot.TargetPlatform == TargetPlatform && Slot.SnapshotName == SnapshotName && Slot.ParamsHash == ParamsHash;
+	});
+}
+
+bool FZenSnapshotSyncSlots::MarkResident(FStringView OplogId, FStringView JobId)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	FZenSnapshotSyncSlot* Slot = Slots.FindByPredicate([OplogId](const FZenSnapshotSyncSlot& ExistingSlot) { return ExistingSlot.OplogId == OplogId; });
+	if (!Slot)
+	{
+		return false;
+	}
+
+	Slot->JobId = FString(JobId);
+	Slot->LastUsedTime = FDateTime::UtcNow();
+	Slot->bResident = true;
+	Save();
+
+	return true;
+}
+
+void FZenSnapshotSyncSlots::Remove(FStringView OplogId)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	if (Slots.RemoveAll([OplogId](const FZenSnapshotSyncSlot& Slot) { return Slot.OplogId == OplogId; }) > 0)
+	{
+		Save();
+	}
+}
+
+TArray<FString> FZenSnapshotSyncSlots::GetTargetPlatforms() const
+{
+	FScopeLock ScopeLock(&Lock);
+
+	TArray<FString> TargetPlatforms;
+	for (const FZenSnapshotSyncSlot& Slot : Slots)
+	{
+		TargetPlatforms.AddUnique(Slot.TargetPlatform);
+	}
+
+	return TargetPlatforms;
+}
+
+TArray<FString> FZenSnapshotSyncSlots::Evict(FStringView TargetPlatform, int32 MaxResidentSnapshots, FStringView ActiveOplogId)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	const FDateTime AbandonedTime = FDateTime::UtcNow() - FTimespan::FromDays(AbandonedImportDays);
+
+	TArray<FZenSnapshotSyncSlot*> Candidates;
+	int32 NumResident = 0;
+
+	for (FZenSnapshotSyncSlot& Slot : Slots)
+	{
+		if (Slot.TargetPlatform != TargetPlatform || Slot.OplogId == ActiveOplogId)
+		{
+			continue;
+		}
+
+		if (Slot.bResident)
+		{
+			++NumResident;
+			Candidates.Add(&Slot);
+		}
+		else if (Slot.LastUsedTime < AbandonedTime)
+		{
+			Candidates.Add(&Slot);
+		}
+	}
+
+	// The active oplog takes up one of the slots whether it is tracked or not
+	const int32 MaxInactive = FMath::Max(MaxResidentSnapshots - 1, 0);
+
+	Algo::SortBy(Candidates, [](const FZenSnapshotSyncSlot* Slot) { return Slot->LastUsedTime; });
+
+	TArray<FString> EvictedOplogIds;
+	for (FZenSnapshotSyncSlot* Slot : Candidates)
+	{
+		if (Slot->bResident)
+		{
+			if (NumResident <= MaxInactive)
+			{
+				continue;
+			}
+
+			--NumResident;
+		}
+
+		EvictedOplogIds.Add(Slot->OplogId);
+	}
+
+	if (!EvictedOplogIds.IsEmpty())
+	{
+		Slots.RemoveAll([&EvictedOplogIds](const FZenSnapshotSyncSlot& Slot) { return EvictedOplogIds.Contains(Slot.OplogId); });
+		Save();
+	}
+
+	return EvictedOplogIds;
+}
+
+void FZenSnapshotSyncSlots::Load()
+{
+	FString SlotsJson;
+	if (!FFileHelper::LoadFileToString(SlotsJson, *FilePath, FFileHelper::EHashOptions::None, FILEREAD_Silent))
+	{
+		return;
+	}
+
+	TSharedPtr<FJsonObject> Registry;
+	const TArray<TSharedPtr<FJsonValue>>* SlotValues = nullptr;
+
+	if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(SlotsJson), Registry) || !Registry.IsValid() || !Registry->TryGetArrayField(TEXT("slots"), SlotValues))
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Warning, "Ignoring unreadable snapshot slot registry '{File}'", FilePath);
+		return;
+	}
+
+	for (const TSharedPtr<FJsonValue>& SlotValue : *SlotValues)
+	{
+		const TSharedPtr<FJsonObject>* SlotObject = nullptr;
+		if (!SlotValue->TryGetObject(SlotObject))
+		{
+			continue;
+		}
+
+		FZenSnapshotSyncSlot Slot;
+		FString LastUsedTime;
+
+		(*SlotObject)->TryGetStringField(TEXT("targetplatform"), Slot.TargetPlatform);
+		(*SlotObject)->TryGetStringField(TEXT("name"), Slot.SnapshotName);
+		(*SlotObject)->TryGetStringField(TEXT("oplogid"), Slot.OplogId);
+		(*SlotObject)->TryGetStringField(TEXT("paramshash"), Slot.ParamsHash);
+		(*SlotObject)->TryGetStringField(TEXT("jobid"), Slot.JobId);
+		(*SlotObject)->TryGetStringField(TEXT("lastused"), LastUsedTime);
+		(*SlotObject)->TryGetBoolField(TEXT("resident"), Slot.bResident);
+
+		if (Slot.TargetPlatform.IsEmpty() || Slot.OplogId.IsEmpty() || !FDateTime::ParseIso8601(*LastUsedTime, Slot.LastUsedTime))
+		{
+			UE_LOGFMT(LogZenSnapshotSync, Warning, "Ignoring invalid slot '{OplogId}' in snapshot slot registry", Slot.OplogId);
+			continue;
+		}
+
+		Slots.Add(MoveTemp(Slot));
+	}
+}
+
+void FZenSnapshotSyncSlots::Save()
+{
+	bSaveRequested = true;
+
+	if (bSaveRunning)
+	{
+		return;
+	}
+
+	bSaveRunning = true;
+
+	PendingSave = Async(EAsyncExecution::ThreadPool, [this]()
+	{
+		WriteRegistry();
+	});
+}
+
+void FZenSnapshotSyncSlots::WriteRegistry()
+{
+	for (;;)
+	{
+		FString SlotsJson;
+		{
+			FScopeLock ScopeLock(&Lock);
+
+			if (!bSaveRequested)
+			{
+				bSaveRunning = false;
+				return;
+			}
+
+			bSaveRequested = false;
+
+			const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&SlotsJson);
+			Writer->WriteObjectStart();
+			Writer->WriteArrayStart(TEXT("slots"));
+
+			for (const FZenSnapshotSyncSlot& Slot : Slots)
+			{
+				Writer->WriteObjectStart();
+				Writer->WriteValue(TEXT("targetplatform"), Slot.TargetPlatform);
+				Writer->WriteValue(TEXT("name"), Slot.SnapshotName);
+				Writer->WriteValue(TEXT("oplogid"), Slot.OplogId);
+				Writer->WriteValue(TEXT("paramshash"), Slot.ParamsHash);
+				Writer->WriteValue(TEXT("jobid"), Slot.JobId);
+				Writer->WriteValue(TEXT("lastused"), Slot.LastUsedTime.ToIso8601());
+				Writer->WriteValue(TEXT("resident"), Slot.bResident);
+				Writer->WriteObjectEnd();
+			}
+
+			Writer->WriteArrayEnd();
+			Writer->WriteObjectEnd();
+			Writer->Close();
+		}
+
+		// Only this loop writes the file, so writes never overtake each other
+		const FString TempFilePath = FilePath + TEXT(".tmp");
+		if (!FFileHelper::SaveStringToFile(SlotsJson, *TempFilePath) || !IFileManager::Get().Move(*FilePath, *TempFilePath))
+		{
+			UE_LOGFMT(LogZenSnapshotSync, Warning, "Failed to write snapshot slot registry '{File}'", FilePath);
+		}
+	}
+}
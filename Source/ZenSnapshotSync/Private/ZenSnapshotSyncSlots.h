@@ -0,0 +1,70 @@
+#pragma once
+
+#include <Async/Future.h>
+#include <Containers/Array.h>
+#include <HAL/CriticalSection.h>
+#include <Misc/DateTime.h>
+#include <Serialization/CompactBinary.h>
+
+struct FZenSnapshotSyncSlot
+{
+	FString TargetPlatform;
+	FString SnapshotName;
+	FString OplogId;
+
+	// A snapshot whose source changed under the same name is not resident
+	FString ParamsHash;
+
+	FString JobId;
+	FDateTime LastUsedTime;
+	bool bResident = false;
+};
+
+// Oplogs of resident snapshots when every snapshot of a platform gets one of its own, least recently used evicted first
+class FZenSnapshotSyncSlots
+{
+public:
+	explicit FZenSnapshotSyncSlots(FString InFilePath);
+	~FZenSnapshotSyncSlots();
+
+	static bool IsEnabled();
+	static int32 GetMaxResidentSnapshots();
+
+	// Stable so an interrupted import resumes into the same oplog
+	static FString MakeOplogId(FStringView TargetPlatform, FStringView SnapshotName);
+
+	static FString MakeParamsHash(const FCbObject& Params);
+
+	FString Acquire(FStringView TargetPlatform, FStringView SnapshotName, FStringView ParamsHash);
+
+	// Returns false if the snapshot is not resident
+	bool TakeResident(FStringView TargetPlatform, FStringView SnapshotName, FStringView ParamsHash, FZenSnapshotSyncSlot& OutSlot);
+	bool IsResident(FStringView TargetPlatform, FStringView SnapshotName, FStringView ParamsHash) const;
+
+	// Returns false if the oplog does not belong to a slot
+	bool MarkResident(FStringView OplogId, FStringView JobId);
+	void Remove(FStringView OplogId);
+
+	TArray<FString> GetTargetPlatforms() const;
+
+	// Never evicts the active oplog, unfinished imports only once abandoned for a while
+	TArray<FString> Evict(FStringView TargetPlatform, int32 MaxResidentSnapshots, FStringView ActiveOplogId);
+
+private:
+	static constexpr int32 MaxOplogIdLength = 64;
+	static constexpr double AbandonedImportDays = 7.0;
+
+	void Load();
+
+	// Called with the lock held, the registry is written on the thread pool and saves made meanwhile are coalesced into one follow-up write
+	void Save();
+	void WriteRegistry();
+
+	const FString FilePath;
+
+	mutable FCriticalSection Lock;
+	TArray<FZenSnapshotSyncSlot> Slots;
+	TFuture<void> PendingSave;
+	bool bSaveRunning = false;
+	bool bSaveRequested = false;
+};
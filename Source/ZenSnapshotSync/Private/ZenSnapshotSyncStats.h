@@ -0,0 +1,14 @@
+#pragma once
+
+#include <Stats/Stats.h>
+
+DECLARE_STATS_GROUP(TEXT("ZenSnapshotSync"), STATGROUP_ZenSnapshotSync, STATCAT_Advanced);
+
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Slowest Provider Refresh (ms)"), STAT_ZenSnapshotSync_SlowestProviderRefresh, STATGROUP_ZenSnapshotSync, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Cached Snapshots"), STAT_ZenSnapshotSync_CachedSnapshots, STATGROUP_ZenSnapshotSync, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("HTTP Requests"), STAT_ZenSnapshotSync_HttpRequests, STATGROUP_ZenSnapshotSync, );
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("Game Thread Blocked (ms)"), STAT_ZenSnapshotSync_GameThreadBlocked, STATGROUP_ZenSnapshotSync, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Finished Syncs"), STAT_ZenSnapshotSync_FinishedSyncs, STATGROUP_ZenSnapshotSync, );
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Last Sync Duration (s)"), STAT_ZenSnapshotSync_LastSyncDuration, STATGROUP_ZenSnapshotSync, );
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Last Sync Entries/s"), STAT_ZenSnapshotSync_LastSyncEntriesPerSecond, STATGROUP_ZenSnapshotSync, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("HTTP Retries"), STAT_ZenSnapshotSync_HttpRetries, STATGROUP_ZenSnapshotSync, );
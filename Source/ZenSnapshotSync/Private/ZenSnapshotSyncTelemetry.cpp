@@ -0,0 +1,107 @@
+#include "ZenSnapshotSyncTelemetry.h"
+
+#include <HAL/FileManager.h>
+#include <Logging/StructuredLog.h>
+#include <Misc/FileHelper.h>
+#include <Misc/ScopeLock.h>
+#include <Misc/StringBuilder.h>
+#include <Policies/CondensedJsonPrintPolicy.h>
+#include <Serialization/JsonWriter.h>
+
+#include "ZenSnapshotSyncLog.h"
+#include "ZenSnapshotSyncMetrics.h"
+#include "ZenSnapshotSyncStats.h"
+
+DEFINE_STAT(STAT_ZenSnapshotSync_FinishedSyncs);
+DEFINE_STAT(STAT_ZenSnapshotSync_LastSyncDuration);
+DEFINE_STAT(STAT_ZenSnapshotSync_LastSyncEntriesPerSecond);
+
+FZenSnapshotSyncTelemetryLog::FZenSnapshotSyncTelemetryLog(FString InFilePath)
+	: FilePath(MoveTemp(InFilePath))
+{
+}
+
+void FZenSnapshotSyncTelemetryLog::Write(const FString& JobId, const FZenSnapshotSyncTelemetry& Telemetry, const TCHAR* Result)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	bool bAlreadyWritten = false;
+	WrittenJobIds.Add(JobId, &bAlreadyWritten);
+	if (bAlreadyWritten)
+	{
+		return;
+	}
+
+	const double TotalDuration = Telemetry.GetTotalDuration();
+	const uint64 TotalEntries = Telemetry.GetTotalEntries();
+	const double EntriesPerSecond = TotalDuration > 0.0 ? TotalEntries / TotalDuration : 0.0;
+
+	FString Line;
+	TStringBuilder<256> PhaseSummary;
+
+	const TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Line);
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("jobid"), JobId);
+	Writer->WriteValue(TEXT("targetplatform"), Telemetry.TargetPlatform);
+	Writer->WriteValue(TEXT("oplogid"), Telemetry.OplogId);
+	Writer->WriteValue(TEXT("source"), Telemetry.Source);
+	Writer->WriteValue(TEXT("requesttime"), Telemetry.RequestTime.ToIso8601());
+	Writer->WriteValue(TEXT("result"), Result);
+	Writer->WriteValue(TEXT("seconds"), TotalDuration);
+	Writer->WriteValue(TEXT("entries"), static_cast<int64>(TotalEntries));
+	Writer->WriteValue(TEXT("entriespersecond"), EntriesPerSecond);
+	Writer->WriteValue(TEXT("estimatedbytes"), Telemetry.Estimate.SnapshotBytes);
+	Writer->WriteValue(TEXT("estimatedseconds"), Telemetry.Estimate.EstimatedSeconds);
+
+	if (Telemetry.Diff.bKnown)
+	{
+		Writer->WriteValue(TEXT("ops"), Telemetry.Diff.NumOps);
+		Writer->WriteValue(TEXT("skippedops"), Telemetry.Diff.NumSkippedOps);
+		Writer->WriteValue(TEXT("skippedopbytes"), Telemetry.Diff.SkippedOpBytes);
+		Writer->WriteValue(TEXT("attachments"), Telemetry.Diff.NumAttachments);
+		Writer->WriteValue(TEXT("skippedattachments"), Telemetry.Diff.NumSkippedAttachments);
+	}
+
+	Writer->WriteArrayStart(TEXT("phases"));
+
+	for (const FZenSnapshotSyncPhase& Phase : Telemetry.Phases)
+	{
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("name"), Phase.Name);
+		Writer->WriteValue(TEXT("seconds"), Phase.Duration);
+		Writer->WriteValue(TEXT("entries"), static_cast<int64>(Phase.NumEntries));
+		Writer->WriteValue(TEXT("entriespersecond"), Phase.GetEntriesPerSecond());
+		Writer->WriteObjectEnd();
+
+		PhaseSummary << (PhaseSummary.Len() > 0 ? TEXT(", ") : TEXT("")) << Phase.Name << TEXT(" ") << FString::Printf(TEXT("%.2fs"), Phase.Duration);
+	}
+
+	Writer->WriteArrayEnd();
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	Line += LINE_TERMINATOR;
+
+	if (!FFileHelper::SaveStringToFile(Line, *FilePath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM, &IFileManager::Get(), FILEWRITE_Append))
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Warning, "Failed to write sync telemetry to '{File}'", FilePath);
+	}
+
+	UE_LOGFMT(LogZenSnapshotSync, Display, "Sync of oplog '{OplogId}' {Result} after {Seconds}s ({Phases})", Telemetry.OplogId, Result, FString::Printf(TEXT("%.2f"), TotalDuration), PhaseSummary.ToString());
+
+	if (Telemetry.Diff.bKnown)
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Display, "Sync of oplog '{OplogId}' kept {NumSkippedOps} of {NumOps} ops ({SkippedOpBytes} bytes) and {NumSkippedAttachments} of {NumAttachments} attachments it already had",
+			Telemetry.OplogId, Telemetry.Diff.NumSkippedOps, Telemetry.Diff.NumOps, Telemetry.Diff.SkippedOpBytes, Telemetry.Diff.NumSkippedAttachments, Telemetry.Diff.NumAttachments);
+	}
+
+	// Sizes are upper bounds so this errs on the safe side
+	if (FCString::Strcmp(Result, TEXT("completed")) == 0)
+	{
+		FZenSnapshotSyncMetrics::Get().RecordImportThroughput(Telemetry.Estimate.SnapshotBytes, TotalDuration);
+	}
+
+	INC_DWORD_STAT(STAT_ZenSnapshotSync_FinishedSyncs);
+	SET_FLOAT_STAT(STAT_ZenSnapshotSync_LastSyncDuration, TotalDuration);
+	SET_FLOAT_STAT(STAT_ZenSnapshotSync_LastSyncEntriesPerSecond, EntriesPerSecond);
+}
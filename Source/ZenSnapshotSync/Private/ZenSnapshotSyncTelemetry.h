@@ -0,0 +1,22 @@
+#pragma once
+
+#include <Containers/Set.h>
+#include <HAL/CriticalSection.h>
+
+#include "ZenSnapshotSyncTypes.h"
+
+// Appends the telemetry of every finished sync as a JSON line and publishes the latest values as stats
+class FZenSnapshotSyncTelemetryLog
+{
+public:
+	explicit FZenSnapshotSyncTelemetryLog(FString InFilePath);
+
+	// Each job is written once
+	void Write(const FString& JobId, const FZenSnapshotSyncTelemetry& Telemetry, const TCHAR* Result);
+
+private:
+	const FString FilePath;
+
+	FCriticalSection Lock;
+	TSet<FString> WrittenJobIds;
+};
@@ -0,0 +1,204 @@
+#include "ZenSnapshotSyncThrottler.h"
+
+#include <HAL/PlatformTime.h>
+#include <Logging/StructuredLog.h>
+#include <Misc/ScopeLock.h>
+
+#include "ZenSnapshotSyncLog.h"
+#include "ZenSnapshotSyncMetrics.h"
+
+FZenSnapshotSyncThrottler::FZenSnapshotSyncThrottler()
+{
+	TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FZenSnapshotSyncThrottler::Tick), TickInterval);
+}
+
+FZenSnapshotSyncThrottler::~FZenSnapshotSyncThrottler()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+	CancelQueued();
+}
+
+void FZenSnapshotSyncThrottler::CancelQueued()
+{
+	TArray<FStartFunction> Starts;
+	{
+		FScopeLock ScopeLock(&Lock);
+		bCancelled = true;
+
+		for (TPair<FString, FHost>& Pair : Hosts)
+		{
+			for (FQueuedImport& QueuedImport : Pair.Value.Queue)
+			{
+				Starts.Add(MoveTemp(QueuedImport.Start));
+			}
+
+			Pair.Value.Queue.Reset();
+		}
+	}
+
+	for (FStartFunction& Start : Starts)
+	{
+		Start(false);
+	}
+}
+
+void FZenSnapshotSyncThrottler::Enqueue(const FString& Host, int32 MaxConcurrentImports, EZenSnapshotSyncPriority Priority, bool bWaitForSlot, FStartFunction&& Start)
+{
+	TArray<FStartFunction> Starts;
+	{
+		FScopeLock ScopeLock(&Lock);
+
+		if (bCancelled)
+		{
+			ScopeLock.Unlock();
+
+			Start(false);
+			return;
+		}
+
+		FHost& HostState = Hosts.FindOrAdd(Host);
+
+		if (!bWaitForSlot && (!HostState.Queue.IsEmpty() || (MaxConcurrentImports > 0 && HostState.NumActive >= MaxConcurrentImports)))
+		{
+			UE_LOGFMT(LogZenSnapshotSync, Warning, "Rejected import from '{Host}' that may not wait behind {NumActive} running imports", Host, HostState.NumActive);
+			ScopeLock.Unlock();
+
+			Start(false);
+			return;
+		}
+
+		// Queue stays sorted by priority, imports of the same priority keep their request order
+		const int32 Index = HostState.Queue.IndexOfByPredicate([Priority](const FQueuedImport& QueuedImport) { return QueuedImport.Priority < Priority; });
+		HostState.Queue.Insert({ Priority, MaxConcurrentImports, FPlatformTime::Seconds(), MoveTemp(Start) }, Index == INDEX_NONE ? HostState.Queue.Num() : Index);
+
+		DequeueImports(Host, HostState, Starts);
+
+		if (!HostState.Queue.IsEmpty())
+		{
+			UE_LOGFMT(LogZenSnapshotSync, Display, "Queued import from '{Host}' behind {NumActive} running and {NumQueued} queued imports",
+				Host, HostState.NumActive, HostState.Queue.Num() - 1);
+		}
+	}
+
+	StartImports(Starts);
+}
+
+void FZenSnapshotSyncThrottler::Assign(const FString& Host, const FString& JobId)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	const double CurrentTime = FPlatformTime::Seconds();
+	Jobs.Add(JobId, { Host, CurrentTime, CurrentTime });
+}
+
+void FZenSnapshotSyncThrottler::Adopt(const FString& Host, const FString& JobId)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	++Hosts.FindOrAdd(Host).NumActive;
+
+	const double CurrentTime = FPlatformTime::Seconds();
+	Jobs.Add(JobId, { Host, CurrentTime, CurrentTime });
+}
+
+void FZenSnapshotSyncThrottler::Release(const FString& Host)
+{
+	TArray<FStartFunction> Starts;
+	{
+		FScopeLock ScopeLock(&Lock);
+
+		if (FHost* HostState = Hosts.Find(Host))
+		{
+			--HostState->NumActive;
+			DequeueImports(Host, *HostState, Starts);
+		}
+	}
+
+	StartImports(Starts);
+}
+
+void FZenSnapshotSyncThrottler::Touch(FStringView JobId)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	if (FJob* Job = Jobs.Find(FString(JobId)))
+	{
+		Job->LastSeenTime = FPlatformTime::Seconds();
+	}
+}
+
+bool FZenSnapshotSyncThrottler::Finish(FStringView JobId, bool bSucceeded)
+{
+	FJob Job;
+	{
+		FScopeLock ScopeLock(&Lock);
+
+		if (!Jobs.RemoveAndCopyValue(FString(JobId), Job))
+		{
+			return false;
+		}
+	}
+
+	FZenSnapshotSyncMetrics::Get().RecordHostImport(Job.Host, FPlatformTime::Seconds() - Job.StartTime, bSucceeded);
+
+	if (!Job.bLeaseExpired)
+	{
+		Release(Job.Host);
+	}
+
+	return true;
+}
+
+bool FZenSnapshotSyncThrottler::Tick(float DeltaTime)
+{
+	TArray<FString> ExpiredHosts;
+	{
+		FScopeLock ScopeLock(&Lock);
+
+		const double CurrentTime = FPlatformTime::Seconds();
+		for (TPair<FString, FJob>& Pair : Jobs)
+		{
+			if (!Pair.Value.bLeaseExpired && CurrentTime - Pair.Value.LastSeenTime >= LeaseTimeout)
+			{
+				UE_LOGFMT(LogZenSnapshotSync, Verbose, "Releasing import slot of job '{JobId}' that is no longer polled", Pair.Key);
+				ExpiredHosts.Add(Pair.Value.Host);
+				Pair.Value.bLeaseExpired = true;
+			}
+		}
+	}
+
+	for (const FString& Host : ExpiredHosts)
+	{
+		Release(Host);
+	}
+
+	return true;
+}
+
+void FZenSnapshotSyncThrottler::DequeueImports(const FString& Host, FHost& HostState, TArray<FStartFunction>& OutStarts)
+{
+	const double CurrentTime = FPlatformTime::Seconds();
+
+	while (!HostState.Queue.IsEmpty())
+	{
+		FQueuedImport& QueuedImport = HostState.Queue[0];
+		if (QueuedImport.MaxConcurrentImports > 0 && HostState.NumActive >= QueuedImport.MaxConcurrentImports)
+		{
+			break;
+		}
+
+		FZenSnapshotSyncMetrics::Get().RecordHostQueued(Host, CurrentTime - QueuedImport.EnqueueTime);
+
+		++HostState.NumActive;
+		OutStarts.Add(MoveTemp(QueuedImport.Start));
+		HostState.Queue.RemoveAt(0);
+	}
+}
+
+void FZenSnapshotSyncThrottler::StartImports(TArray<FStartFunction>& Starts)
+{
+	for (FStartFunction& Start : Starts)
+	{
+		Start(true);
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <Containers/Map.h>
+#include <Containers/Ticker.h>
+#include <HAL/CriticalSection.h>
+#include <Templates/Function.h>
+
+#include "ZenSnapshotSyncTypes.h"
+
+// Limits imports per source host, queueing the rest by priority until a slot frees up or its lease times out
+class FZenSnapshotSyncThrottler
+{
+public:
+	// False if queued imports are cancelled
+	using FStartFunction = TUniqueFunction<void(bool bStarted)>;
+
+	FZenSnapshotSyncThrottler();
+	~FZenSnapshotSyncThrottler();
+
+	// Start may run right away on the calling thread and must be followed by Assign or Release
+	void Enqueue(const FString& Host, int32 MaxConcurrentImports, EZenSnapshotSyncPriority Priority, bool bWaitForSlot, FStartFunction&& Start);
+
+	void Assign(const FString& Host, const FString& JobId);
+
+	// Takes a slot for a recovered job
+	void Adopt(const FString& Host, const FString& JobId);
+
+	void Release(const FString& Host);
+
+	// Finish returns true for the first caller only
+	void Touch(FStringView JobId);
+	bool Finish(FStringView JobId, bool bSucceeded);
+
+	// Rejects queued imports and any enqueued later
+	void CancelQueued();
+
+private:
+	static constexpr float TickInterval = 30.0f;
+	static constexpr double LeaseTimeout = 600.0;
+
+	struct FQueuedImport
+	{
+		EZenSnapshotSyncPriority Priority;
+		int32 MaxConcurrentImports;
+		double EnqueueTime;
+		FStartFunction Start;
+	};
+
+	struct FHost
+	{
+		int32 NumActive = 0;
+		TArray<FQueuedImport> Queue;
+	};
+
+	struct FJob
+	{
+		FString Host;
+		double StartTime;
+		double LastSeenTime;
+
+		// Lease timed out, kept so the job still finishes once
+		bool bLeaseExpired = false;
+	};
+
+	bool Tick(float DeltaTime);
+
+	// Started by the caller once the lock is released
+	void DequeueImports(const FString& Host, FHost& HostState, TArray<FStartFunction>& OutStarts);
+	static void StartImports(TArray<FStartFunction>& Starts);
+
+	FCriticalSection Lock;
+	bool bCancelled = false;
+	TMap<FString, FHost> Hosts;
+	TMap<FString, FJob> Jobs;
+	FTSTicker::FDelegateHandle TickHandle;
+};
@@ -4,8 +4,10 @@
 #include <Interfaces/ITargetPlatform.h>
 #include <Interfaces/ITargetPlatformManagerModule.h>
 #include <Misc/AsyncTaskNotification.h>
+#include <Misc/Timespan.h>
 #include <Styling/AppStyle.h>
 
+#include "ZenSnapshotSyncBatch.h"
 #include "ZenSnapshotSyncModule.h"
 
 #define LOCTEXT_NAMESPACE "ZenSnapshotSync"
@@ -14,6 +16,8 @@ FZenSnapshotSyncToolbar::FZenSnapshotSyncToolbar()
 {
 	SnapshotSyncModule = FModuleManager::LoadModulePtr<FZenSnapshotSyncModule>(UE_MODULE_NAME);
 	UToolMenus::RegisterStartupCallback(FSimpleMulticastDelegate::FDelegate::CreateRaw(this, &ThisClass::RegisterMenus));
+
+	SnapshotSyncModule->OnSnapshotSyncRecovered().AddRaw(this, &ThisClass::OnSnapshotSyncRecovered);
 }
 
 FZenSnapshotSyncToolbar::~FZenSnapshotSyncToolbar()
@@ -21,7 +25,9 @@ FZenSnapshotSyncToolbar::~FZenSnapshotSyncToolbar()
 	UToolMenus::UnRegisterStartupCallback(this);
 	UToolMenus::UnregisterOwner(this);
 
-	CancelSnapshotSyncTasks();
+	SnapshotSyncModule->OnSnapshotSyncRecovered().RemoveAll(this);
+
+	DetachSnapshotSyncTasks();
 }
 
 void FZenSnapshotSyncToolbar::RegisterMenus()
@@ -50,17 +56,23 @@ void FZenSnapshotSyncToolbar::MakeSnapshotSyncMenu(UToolMenu* Menu)
 {
 	FToolMenuSection& Section = Menu->AddSection("Snapshots");
 
-	// Fetch latest descriptors only when there are no active sync tasks
-	if (SnapshotSyncTasks.IsEmpty())
+	// Take latest cached descriptors only when there are no active sync tasks
+	if (SnapshotSyncTasks.IsEmpty() && !SnapshotSyncBatch.IsValid())
+	{
+		LatestSnapshotDescriptors = SnapshotSyncModule->GetCachedSnapshots();
+	}
+
+	SnapshotSyncModule->RefreshSnapshots();
+
+	if (!LatestSnapshotDescriptors.IsValid())
 	{
-		LatestSnapshotDescriptors.Reset();
-		SnapshotSyncModule->QuerySnapshots(LatestSnapshotDescriptors);
+		return;
 	}
 
 	ITargetPlatformManagerModule& TargetPlatformManager = GetTargetPlatformManagerRef();
 
 	TMap<ITargetPlatform*, TArray<const FZenSnapshotDescriptor*>> TargetPlatformSnapshotDescriptors;
-	for (const FZenSnapshotDescriptor& SnapshotDescriptor : LatestSnapshotDescriptors)
+	for (const FZenSnapshotDescriptor& SnapshotDescriptor : *LatestSnapshotDescriptors)
 	{
 		ITargetPlatform* TargetPlatform = TargetPlatformManager.FindTargetPlatform(SnapshotDescriptor.GetTargetPlatform());
 		if (TargetPlatform)
@@ -69,6 +81,20 @@ void FZenSnapshotSyncToolbar::MakeSnapshotSyncMenu(UToolMenu* Menu)
 		}
 	}
 
+	if (TargetPlatformSnapshotDescriptors.Num() > 1)
+	{
+		Section.AddMenuEntry(
+			"SyncAllPlatforms", LOCTEXT("SyncAllPlatformsLabel", "Sync all platforms"),
+			LOCTEXT("SyncAllPlatformsTooltip", "Sync the first listed snapshot of every target platform"),
+			FSlateIcon(FAppStyle::GetAppStyleSetName(), "FontEditor.Update"),
+			FUIAction(
+				FExecuteAction::CreateRaw(this, &ThisClass::SyncAllSnapshots),
+				FCanExecuteAction::CreateRaw(this, &ThisClass::CanSyncAllSnapshots)
+			)
+		);
+		Section.AddSeparator(NAME_None);
+	}
+
 	for (auto It = TargetPlatformSnapshotDescriptors.CreateConstIterator(); It; ++It)
 	{
 		const ITargetPlatform* TargetPlatform = It.Key();
@@ -114,7 +140,7 @@ void FZenSnapshotSyncToolbar::MakeSnapshotSyncMenu(UToolMenu* Menu)
 
 bool FZenSnapshotSyncToolbar::CanSyncSnapshot(const FZenSnapshotDescriptor* SnapshotDescriptor) const
 {
-	return SnapshotDescriptor && !SnapshotSyncTasks.Contains(SnapshotDescriptor->GetTargetPlatform());
+	return SnapshotDescriptor && !SnapshotSyncBatch.IsValid() && !SnapshotSyncTasks.Contains(SnapshotDescriptor->GetTargetPlatform());
 }
 
 void FZenSnapshotSyncToolbar::SyncSnapshot(const FZenSnapshotDescriptor* SnapshotDescriptor)
@@ -124,84 +150,266 @@ void FZenSnapshotSyncToolbar::SyncSnapshot(const FZenSnapshotDescriptor* Snapsho
 		return;
 	}
 
-	FZenSnapshotSyncHandle Handle = SnapshotSyncModule->RequestSnapshotSync(*SnapshotDescriptor);
-	if (!Handle.IsValid())
+	FAsyncTaskNotificationConfig TaskNotificationConfig;
+	TaskNotificationConfig.TitleText = FText::Format(LOCTEXT("SnapshotSyncTaskTitle", "Syncing snapshot '{0}'"), FText::FromString(SnapshotDescriptor->GetName()));
+	TaskNotificationConfig.ProgressText = LOCTEXT("SnapshotSyncTaskRequesting", "Requesting import");
+	TaskNotificationConfig.bKeepOpenOnFailure = true;
+	TaskNotificationConfig.bCanCancel = true;
+
+	FZenSnapshotSyncTask& Task = SnapshotSyncTasks.Add(SnapshotDescriptor->GetTargetPlatform());
+	Task.PendingHandle = SnapshotSyncModule->RequestSnapshotSyncAsync(*SnapshotDescriptor);
+	Task.Notification = MakeUnique<FAsyncTaskNotification>(TaskNotificationConfig);
+
+	StartTicking();
+}
+
+bool FZenSnapshotSyncToolbar::CanSyncAllSnapshots() const
+{
+	return SnapshotSyncTasks.IsEmpty() && !SnapshotSyncBatch.IsValid();
+}
+
+void FZenSnapshotSyncToolbar::SyncAllSnapshots()
+{
+	ITargetPlatformManagerModule& TargetPlatformManager = GetTargetPlatformManagerRef();
+
+	if (!LatestSnapshotDescriptors.IsValid())
 	{
 		return;
 	}
 
+	TArray<FZenSnapshotDescriptor> SnapshotDescriptors;
+	for (const FZenSnapshotDescriptor& SnapshotDescriptor : *LatestSnapshotDescriptors)
+	{
+		if (TargetPlatformManager.FindTargetPlatform(SnapshotDescriptor.GetTargetPlatform()))
+		{
+			SnapshotDescriptors.Add(SnapshotDescriptor);
+		}
+	}
+
+	SnapshotSyncBatch = MakeUnique<FZenSnapshotSyncBatch>(*SnapshotSyncModule, SnapshotDescriptors);
+
 	FAsyncTaskNotificationConfig TaskNotificationConfig;
-	TaskNotificationConfig.TitleText = FText::Format(LOCTEXT("SnapshotSyncTaskTitle", "Syncing snapshot '{0}'"), FText::FromString(SnapshotDescriptor->GetName()));
+	TaskNotificationConfig.TitleText = FText::Format(LOCTEXT("SnapshotSyncBatchTitle", "Syncing snapshots for {0} platforms"), SnapshotSyncBatch->GetNumSnapshots());
+	TaskNotificationConfig.ProgressText = LOCTEXT("SnapshotSyncTaskRequesting", "Requesting import");
 	TaskNotificationConfig.bKeepOpenOnFailure = true;
 	TaskNotificationConfig.bCanCancel = true;
 
-	FZenSnapshotSyncTask& Task = SnapshotSyncTasks.Add(SnapshotDescriptor->GetTargetPlatform());
-	Task.Handle = MoveTemp(Handle);
-	Task.Notification = MakeUnique<FAsyncTaskNotification>(TaskNotificationConfig);
+	SnapshotSyncBatchNotification = MakeUnique<FAsyncTaskNotification>(TaskNotificationConfig);
+
+	StartTicking();
+}
+
+void FZenSnapshotSyncToolbar::TickSnapshotSyncBatch()
+{
+	if (!SnapshotSyncBatch.IsValid())
+	{
+		return;
+	}
+
+	if (SnapshotSyncBatchNotification->GetPromptAction() == EAsyncTaskNotificationPromptAction::Cancel)
+	{
+		SnapshotSyncBatch->Cancel();
+		SnapshotSyncBatchNotification->SetKeepOpenOnFailure(false);
+	}
 
+	if (SnapshotSyncBatch->Tick())
+	{
+		const double TimeRemaining = SnapshotSyncBatch->GetEstimatedTimeRemaining();
+		const FText TimeRemainingText = TimeRemaining >= 0.0 ? FText::AsTimespan(FTimespan::FromSeconds(FMath::CeilToDouble(TimeRemaining))) : LOCTEXT("SnapshotSyncBatchUnknownTime", "unknown");
+
+		const int32 NumFailed = SnapshotSyncBatch->GetNumFailed();
+		const FText ProgressText = FText::Format(LOCTEXT("SnapshotSyncBatchProgress", "{0} of {1} platforms done ({2}, {3} remaining)"),
+			SnapshotSyncBatch->GetNumComplete(), SnapshotSyncBatch->GetNumSnapshots() - NumFailed, FText::AsPercent(SnapshotSyncBatch->GetProgress()), TimeRemainingText);
+
+		SnapshotSyncBatchNotification->SetProgressText(NumFailed > 0
+			? FText::Format(LOCTEXT("SnapshotSyncBatchProgressWithFailures", "{0}, {1} failed"), ProgressText, NumFailed)
+			: ProgressText);
+
+		return;
+	}
+
+	const int32 NumFailed = SnapshotSyncBatch->GetNumFailed();
+	SnapshotSyncBatchNotification->SetProgressText(NumFailed > 0 ? FText::Format(LOCTEXT("SnapshotSyncBatchFailed", "{0} platforms failed to sync"), NumFailed) : FText::GetEmpty());
+	SnapshotSyncBatchNotification->SetComplete(NumFailed == 0);
+	SnapshotSyncBatchNotification.Reset();
+	SnapshotSyncBatch.Reset();
+}
+
+void FZenSnapshotSyncToolbar::StartTicking()
+{
 	if (!SnapshotSyncTickHandle.IsValid())
 	{
-		SnapshotSyncTickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &ThisClass::TickSnapshotSyncTasks), 1.0f);
+		SnapshotSyncTickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &ThisClass::TickSnapshotSyncTasks), 0.1f);
 	}
 }
 
 bool FZenSnapshotSyncToolbar::TickSnapshotSyncTasks(float DeltaTime)
 {
+	TickSnapshotSyncBatch();
+
 	for (auto It = SnapshotSyncTasks.CreateIterator(); It; ++It)
 	{
 		FZenSnapshotSyncTask& Task = It.Value();
 
-		bool bRemoveTask = !SnapshotSyncModule->QuerySnapshotSyncStatus(Task.Handle);
-
-		if (Task.Notification.IsValid())
+		if (Task.PendingHandle.IsValid())
 		{
-			if (Task.Notification->GetPromptAction() == EAsyncTaskNotificationPromptAction::Cancel)
+			if (!Task.PendingHandle.IsReady())
 			{
-				if (SnapshotSyncModule->CancelSnapshotSync(Task.Handle))
+				continue;
+			}
+
+			Task.Handle = Task.PendingHandle.Get();
+			Task.PendingHandle.Reset();
+
+			if (!Task.Handle.IsValid())
+			{
+				if (Task.Notification.IsValid())
 				{
-					Task.Notification->SetKeepOpenOnFailure(false);
-					bRemoveTask = true;
+					Task.Notification->SetProgressText(Task.Handle.IsError() ? FText::FromString(Task.Handle.GetErrorMessage()) : LOCTEXT("SnapshotSyncTaskRequestFailed", "Failed to request import"));
+					Task.Notification->SetComplete(false);
+					Task.Notification.Reset();
 				}
+
+				It.RemoveCurrent();
+				continue;
 			}
-			else
+
+			// Activating a prefetched snapshot completes without an import job to wait on
+			if (Task.Handle.IsComplete())
 			{
-				Task.Notification->SetProgressText(FText::FromString(Task.Handle.GetState()));
+				CompleteSnapshotSyncTask(Task);
+				It.RemoveCurrent();
+				continue;
 			}
+
+			Task.StatusSubscriptionHandle = SnapshotSyncModule->SubscribeSnapshotSyncStatus(Task.Handle,
+				FZenSnapshotSyncModule::FOnSnapshotSyncStatusChanged::CreateRaw(this, &ThisClass::OnSnapshotSyncStatusChanged, It.Key()));
 		}
 
-		if (bRemoveTask)
+		if (Task.Notification.IsValid() && Task.Notification->GetPromptAction() == EAsyncTaskNotificationPromptAction::Cancel && !Task.Handle.IsCancelling())
 		{
-			if (Task.Notification.IsValid())
+			if (SnapshotSyncModule->CancelSnapshotSync(Task.Handle))
 			{
-				Task.Notification->SetProgressText(Task.Handle.IsError() ? FText::FromString(Task.Handle.GetErrorMessage()) : FText::GetEmpty());
-				Task.Notification->SetComplete(Task.Handle.IsComplete());
-				Task.Notification.Reset();
+				Task.Notification->SetKeepOpenOnFailure(false);
+				Task.Notification->SetCanCancel(false);
+				Task.Notification->SetProgressText(LOCTEXT("SnapshotSyncTaskCancelling", "Cancelling..."));
 			}
-
-			It.RemoveCurrent();
 		}
 	}
 
-	return !SnapshotSyncTasks.IsEmpty();
+	return !SnapshotSyncTasks.IsEmpty() || SnapshotSyncBatch.IsValid();
+}
+
+void FZenSnapshotSyncToolbar::OnSnapshotSyncStatusChanged(const FZenSnapshotSyncHandle& Handle, FString TargetPlatform)
+{
+	FZenSnapshotSyncTask* Task = SnapshotSyncTasks.Find(TargetPlatform);
+	if (!Task)
+	{
+		return;
+	}
+
+	Task->Handle = Handle;
+
+	if (Handle.IsComplete() || Handle.IsError())
+	{
+		CompleteSnapshotSyncTask(*Task);
+		SnapshotSyncTasks.Remove(TargetPlatform);
+	}
+	else if (Task->Notification.IsValid())
+	{
+		Task->Notification->SetProgressText(MakeProgressText(Handle));
+	}
+}
+
+void FZenSnapshotSyncToolbar::OnSnapshotSyncRecovered(const FString& SnapshotName, const FString& TargetPlatform, const FZenSnapshotSyncHandle& Handle)
+{
+	if (SnapshotSyncTasks.Contains(TargetPlatform))
+	{
+		return;
+	}
+
+	FAsyncTaskNotificationConfig TaskNotificationConfig;
+	TaskNotificationConfig.TitleText = FText::Format(LOCTEXT("SnapshotSyncTaskResumedTitle", "Resuming snapshot '{0}'"), FText::FromString(SnapshotName));
+	TaskNotificationConfig.ProgressText = MakeProgressText(Handle);
+	TaskNotificationConfig.bKeepOpenOnFailure = true;
+	TaskNotificationConfig.bCanCancel = true;
+
+	FZenSnapshotSyncTask& Task = SnapshotSyncTasks.Add(TargetPlatform);
+	Task.Handle = Handle;
+	Task.Notification = MakeUnique<FAsyncTaskNotification>(TaskNotificationConfig);
+	Task.StatusSubscriptionHandle = SnapshotSyncModule->SubscribeSnapshotSyncStatus(Task.Handle,
+		FZenSnapshotSyncModule::FOnSnapshotSyncStatusChanged::CreateRaw(this, &ThisClass::OnSnapshotSyncStatusChanged, TargetPlatform));
+
+	StartTicking();
 }
 
-void FZenSnapshotSyncToolbar::CancelSnapshotSyncTasks()
+FText FZenSnapshotSyncToolbar::MakeProgressText(const FZenSnapshotSyncHandle& Handle)
 {
+	const FText StateText = FText::FromString(Handle.GetState());
+
+	// Ops that report no percentage have nothing to estimate from
+	const float Progress = Handle.GetStateProgress();
+	if (Progress <= 0.0f)
+	{
+		return StateText;
+	}
+
+	const FZenSnapshotSyncRateEstimator& RateEstimator = Handle.GetRateEstimator();
+
+	TArray<FText> Details;
+	Details.Add(FText::AsPercent(Progress));
+
+	const double EntriesPerSecond = RateEstimator.GetEntriesPerSecond();
+	if (EntriesPerSecond > 0.0)
+	{
+		Details.Add(FText::Format(LOCTEXT("SnapshotSyncTaskRate", "{0}/s"), FText::AsNumber(FMath::RoundToInt64(EntriesPerSecond))));
+	}
+
+	// Zen server reports no totals across ops, so the estimate only covers the one running now
+	const double TimeRemaining = RateEstimator.GetEstimatedTimeRemaining();
+	if (TimeRemaining >= 0.0)
+	{
+		Details.Add(FText::Format(LOCTEXT("SnapshotSyncTaskStepTimeRemaining", "{0} left in this step"), FText::AsTimespan(FTimespan::FromSeconds(FMath::CeilToDouble(TimeRemaining)))));
+	}
+
+	return FText::Format(LOCTEXT("SnapshotSyncTaskProgress", "{0} ({1})"), StateText, FText::Join(LOCTEXT("SnapshotSyncTaskDetailSeparator", ", "), Details));
+}
+
+void FZenSnapshotSyncToolbar::CompleteSnapshotSyncTask(FZenSnapshotSyncTask& Task)
+{
+	SnapshotSyncModule->UnsubscribeSnapshotSyncStatus(Task.StatusSubscriptionHandle);
+	Task.StatusSubscriptionHandle.Reset();
+
+	if (Task.Notification.IsValid())
+	{
+		Task.Notification->SetProgressText(Task.Handle.IsError() ? FText::FromString(Task.Handle.GetErrorMessage()) : FText::GetEmpty());
+		Task.Notification->SetComplete(Task.Handle.IsComplete());
+		Task.Notification.Reset();
+	}
+}
+
+void FZenSnapshotSyncToolbar::DetachSnapshotSyncTasks()
+{
+	// Imports keep running on Zen server and are recovered on the next start
+	if (SnapshotSyncBatch.IsValid())
+	{
+		SnapshotSyncBatch->Detach();
+		SnapshotSyncBatch.Reset();
+	}
+
+	SnapshotSyncBatchNotification.Reset();
+
 	for (auto It = SnapshotSyncTasks.CreateIterator(); It; ++It)
 	{
 		FZenSnapshotSyncTask& Task = It.Value();
 
-		SnapshotSyncModule->CancelSnapshotSync(Task.Handle);
-
-		if (Task.Notification.IsValid())
-		{
-			Task.Notification->SetKeepOpenOnFailure(false);
-			Task.Notification->SetComplete(false);
-			Task.Notification.Reset();
-		}
+		SnapshotSyncModule->UnsubscribeSnapshotSyncStatus(Task.StatusSubscriptionHandle);
+		Task.Notification.Reset();
 	}
 
 	SnapshotSyncTasks.Reset();
+
+	FTSTicker::GetCoreTicker().RemoveTicker(SnapshotSyncTickHandle);
 	SnapshotSyncTickHandle.Reset();
 }
 
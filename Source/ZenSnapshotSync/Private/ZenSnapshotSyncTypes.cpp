@@ -10,6 +10,161 @@ const FString& FZenSnapshotDescriptor::GetTargetPlatform() const
 	return TargetPlatform;
 }
 
+EZenSnapshotSourceType FZenSnapshotDescriptor::GetSourceType() const
+{
+	if (Source.IsType<FZenSnapshotFileSource>())
+	{
+		return EZenSnapshotSourceType::File;
+	}
+
+	if (Source.IsType<FZenSnapshotCloudSource>())
+	{
+		return EZenSnapshotSourceType::Cloud;
+	}
+
+	if (Source.IsType<FZenSnapshotZenSource>())
+	{
+		return EZenSnapshotSourceType::Zen;
+	}
+
+	return EZenSnapshotSourceType::Unknown;
+}
+
+const FZenSnapshotSource& FZenSnapshotDescriptor::GetSource() const
+{
+	return Source;
+}
+
+const FZenSnapshotSyncThrottle& FZenSnapshotDescriptor::GetThrottle() const
+{
+	return Throttle;
+}
+
+const TArray<FZenSnapshotSource>& FZenSnapshotDescriptor::GetMirrors() const
+{
+	return Mirrors;
+}
+
+bool FZenSnapshotSyncEstimate::HasEnoughSpace(int64 MarginBytes) const
+{
+	return SnapshotBytes < 0 || FreeBytes < 0 || SnapshotBytes + MarginBytes <= FreeBytes;
+}
+
+double FZenSnapshotSyncPhase::GetEntriesPerSecond() const
+{
+	return Duration > 0.0 ? NumEntries / Duration : 0.0;
+}
+
+double FZenSnapshotSyncTelemetry::GetTotalDuration() const
+{
+	double TotalDuration = 0.0;
+	for (const FZenSnapshotSyncPhase& Phase : Phases)
+	{
+		TotalDuration += Phase.Duration;
+	}
+
+	return TotalDuration;
+}
+
+uint64 FZenSnapshotSyncTelemetry::GetTotalEntries() const
+{
+	uint64 TotalEntries = 0;
+	for (const FZenSnapshotSyncPhase& Phase : Phases)
+	{
+		TotalEntries += Phase.NumEntries;
+	}
+
+	return TotalEntries;
+}
+
+void FZenSnapshotSyncTelemetry::AddPhase(FStringView Name, double Duration, uint64 NumEntries)
+{
+	FZenSnapshotSyncPhase* Phase = Phases.FindByPredicate([Name](const FZenSnapshotSyncPhase& ExistingPhase) { return ExistingPhase.Name == Name; });
+	if (!Phase)
+	{
+		Phase = &Phases.AddDefaulted_GetRef();
+		Phase->Name = FString(Name);
+	}
+
+	Phase->Duration += Duration;
+	Phase->NumEntries += NumEntries;
+}
+
+void FZenSnapshotSyncTelemetry::EndOperation(FStringView Name, double CurrentTime)
+{
+	// Handles recovered after a restart start timing with their first poll
+	if (OperationStartTime > 0.0)
+	{
+		// Zen server reports no op while the job waits in its queue
+		AddPhase(Name.IsEmpty() ? TEXTVIEW("JobQueued") : Name, CurrentTime - OperationStartTime, CurrentOpTotalCount - FMath::Min(CurrentOpRemainingCount, CurrentOpTotalCount));
+	}
+
+	OperationStartTime = CurrentTime;
+	CurrentOpTotalCount = 0;
+	CurrentOpRemainingCount = 0;
+}
+
+double FZenSnapshotSyncRateEstimator::GetProgressPerSecond() const
+{
+	return ProgressPerSecond;
+}
+
+double FZenSnapshotSyncRateEstimator::GetEntriesPerSecond() const
+{
+	return EntriesPerSecond;
+}
+
+double FZenSnapshotSyncRateEstimator::GetEstimatedTimeRemaining() const
+{
+	return EstimatedTimeRemaining;
+}
+
+void FZenSnapshotSyncRateEstimator::Reset()
+{
+	*this = FZenSnapshotSyncRateEstimator();
+}
+
+void FZenSnapshotSyncRateEstimator::AddSample(double Time, float Progress, uint64 NumEntries)
+{
+	if (Samples.Num() == MaxSamples)
+	{
+		Samples.RemoveAt(0);
+	}
+
+	Samples.Add({ Time, Progress, NumEntries });
+
+	// At least two samples are kept so a slow poll interval still yields a rate
+	while (Samples.Num() > 2 && Time - Samples[0].Time > WindowDuration)
+	{
+		Samples.RemoveAt(0);
+	}
+
+	const FSample& Oldest = Samples[0];
+	const double Elapsed = Time - Oldest.Time;
+	if (Elapsed <= 0.0)
+	{
+		return;
+	}
+
+	ProgressPerSecond = FMath::Max(Progress - Oldest.Progress, 0.0f) / Elapsed;
+	EntriesPerSecond = (NumEntries - FMath::Min(Oldest.NumEntries, NumEntries)) / Elapsed;
+
+	if (ProgressPerSecond <= 0.0)
+	{
+		EstimatedTimeRemaining = -1.0;
+		return;
+	}
+
+	// Progress arrives in whole percents so the raw estimate jumps between polls
+	const double TimeRemaining = (1.0 - Progress) / ProgressPerSecond;
+	EstimatedTimeRemaining = EstimatedTimeRemaining < 0.0 ? TimeRemaining : FMath::Lerp(EstimatedTimeRemaining, TimeRemaining, Smoothing);
+}
+
+bool FZenSnapshotSyncVerification::HasPassed() const
+{
+	return bVerified && CorruptChunks.IsEmpty();
+}
+
 bool FZenSnapshotSyncHandle::IsValid() const
 {
 	return !JobId.IsEmpty();
@@ -25,6 +180,11 @@ bool FZenSnapshotSyncHandle::IsError() const
 	return !ErrorMessage.IsEmpty();
 }
 
+bool FZenSnapshotSyncHandle::IsCancelling() const
+{
+	return CancelTime > 0.0 && !IsComplete() && !IsError();
+}
+
 const FString& FZenSnapshotSyncHandle::GetErrorMessage() const
 {
 	return ErrorMessage;
@@ -39,3 +199,18 @@ float FZenSnapshotSyncHandle::GetStateProgress() const
 {
 	return StateProgress;
 }
+
+const FZenSnapshotSyncTelemetry& FZenSnapshotSyncHandle::GetTelemetry() const
+{
+	return Telemetry;
+}
+
+const FZenSnapshotSyncRateEstimator& FZenSnapshotSyncHandle::GetRateEstimator() const
+{
+	return RateEstimator;
+}
+
+const FZenSnapshotSyncVerification& FZenSnapshotSyncHandle::GetVerification() const
+{
+	return Verification;
+}
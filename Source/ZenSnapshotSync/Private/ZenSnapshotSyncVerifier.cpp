@@ -0,0 +1,363 @@
+#include "ZenSnapshotSyncVerifier.h"
+
+#include <Async/Async.h>
+#include <HAL/PlatformTime.h>
+#include <Logging/StructuredLog.h>
+#include <Misc/ScopeLock.h>
+#include <ProfilingDebugging/CpuProfilerTrace.h>
+
+#include "ZenSnapshotSyncLog.h"
+#include "ZenSnapshotSyncRetry.h"
+
+namespace ZenSnapshotSyncVerifier
+{
+	static void CollectAttachments(FCbFieldView Field, TSet<FIoHash>& OutChunks)
+	{
+		if (Field.IsAttachment())
+		{
+			OutChunks.Add(Field.AsAttachment());
+		}
+		else if (Field.IsObject())
+		{
+			for (FCbFieldView Child : Field.AsObjectView())
+			{
+				CollectAttachments(Child, OutChunks);
+			}
+		}
+		else if (Field.IsArray())
+		{
+			for (FCbFieldView Child : Field.AsArrayView())
+			{
+				CollectAttachments(Child, OutChunks);
+			}
+		}
+	}
+}
+
+FZenSnapshotSyncVerifier::FZenSnapshotSyncVerifier(UE::Zen::FZenHttpRequestPool& InRequestPool)
+	: RequestPool(InRequestPool)
+{
+}
+
+void FZenSnapshotSyncVerifier::RecordBaseline(const FString& ProjectId, const FString& OplogId)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(ZenSnapshotSync_RecordBaseline);
+
+	FCbObject Entries;
+	if (!FetchOps(ProjectId, OplogId, Entries))
+	{
+		FScopeLock ScopeLock(&Lock);
+		Baselines.Remove(OplogId);
+		return;
+	}
+
+	FBaseline Baseline;
+	for (FCbFieldView Entry : Entries["entries"].AsArrayView())
+	{
+		const FCbObjectView Op = Entry.AsObjectView();
+		Baseline.Ops.Add(Op.GetHash());
+
+		for (FCbFieldView Field : Op)
+		{
+			ZenSnapshotSyncVerifier::CollectAttachments(Field, Baseline.Attachments);
+		}
+	}
+
+	FScopeLock ScopeLock(&Lock);
+	Baselines.Add(OplogId, MoveTemp(Baseline));
+}
+
+bool FZenSnapshotSyncVerifier::HasBaseline(const FString& OplogId) const
+{
+	FScopeLock ScopeLock(&Lock);
+	return Baselines.Contains(OplogId);
+}
+
+void FZenSnapshotSyncVerifier::DiscardBaseline(const FString& OplogId)
+{
+	FScopeLock ScopeLock(&Lock);
+	Baselines.Remove(OplogId);
+}
+
+bool FZenSnapshotSyncVerifier::Diff(const FString& ProjectId, const FString& OplogId, FZenSnapshotSyncDiff& OutDiff)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(ZenSnapshotSync_Diff);
+
+	FBaseline Baseline;
+	{
+		FScopeLock ScopeLock(&Lock);
+
+		if (!Baselines.RemoveAndCopyValue(OplogId, Baseline))
+		{
+			return false;
+		}
+	}
+
+	FCbObject Entries;
+	if (!FetchOps(ProjectId, OplogId, Entries))
+	{
+		return false;
+	}
+
+	OutDiff = MakeDiff(Baseline, Entries);
+	return true;
+}
+
+FZenSnapshotSyncDiff FZenSnapshotSyncVerifier::MakeDiff(const FBaseline& Baseline, const FCbObject& Entries)
+{
+	FZenSnapshotSyncDiff Diff;
+	Diff.bKnown = true;
+
+	TSet<FIoHash> Attachments;
+	for (FCbFieldView Entry : Entries["entries"].AsArrayView())
+	{
+		const FCbObjectView Op = Entry.AsObjectView();
+
+		++Diff.NumOps;
+		if (Baseline.Ops.Contains(Op.GetHash()))
+		{
+			++Diff.NumSkippedOps;
+			Diff.SkippedOpBytes += Op.GetSize();
+		}
+
+		for (FCbFieldView Field : Op)
+		{
+			ZenSnapshotSyncVerifier::CollectAttachments(Field, Attachments);
+		}
+	}
+
+	Diff.NumAttachments = Attachments.Num();
+	for (const FIoHash& Attachment : Attachments)
+	{
+		if (Baseline.Attachments.Contains(Attachment))
+		{
+			++Diff.NumSkippedAttachments;
+		}
+	}
+
+	return Diff;
+}
+
+bool FZenSnapshotSyncVerifier::Start(const FString& JobId)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	if (Jobs.Contains(JobId))
+	{
+		return false;
+	}
+
+	Jobs.Add(JobId, MakeShared<FJob>());
+	return true;
+}
+
+FZenSnapshotSyncVerifier::EStatus FZenSnapshotSyncVerifier::Verify(const FString& JobId, const FString& ProjectId, const FString& OplogId, FZenSnapshotSyncVerification& OutResult, FZenSnapshotSyncDiff& OutDiff)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(ZenSnapshotSync_Verify);
+
+	using namespace UE::Zen;
+
+	TSharedPtr<FJob> Job;
+	FBaseline Baseline;
+	bool bHasBaseline = false;
+	{
+		FScopeLock ScopeLock(&Lock);
+
+		if (const TSharedRef<FJob>* ExistingJob = Jobs.Find(JobId))
+		{
+			Job = *ExistingJob;
+		}
+
+		bHasBaseline = Baselines.RemoveAndCopyValue(OplogId, Baseline);
+	}
+
+	if (!Job.IsValid())
+	{
+		return EStatus::None;
+	}
+
+	FZenSnapshotSyncVerification Result;
+
+	FCbObject Entries;
+	if (FetchOps(ProjectId, OplogId, Entries))
+	{
+		if (bHasBaseline)
+		{
+			OutDiff = MakeDiff(Baseline, Entries);
+		}
+
+		// Chunks shared by several ops are read back once
+		TSet<FIoHash> ChunkSet;
+		for (FCbFieldView Entry : Entries["entries"].AsArrayView())
+		{
+			const FCbObjectView Op = Entry.AsObjectView();
+			if (Baseline.Ops.Contains(Op.GetHash()))
+			{
+				continue;
+			}
+
+			++Result.NumOps;
+
+			for (FCbFieldView Field : Op)
+			{
+				ZenSnapshotSyncVerifier::CollectAttachments(Field, ChunkSet);
+			}
+		}
+
+		const TArray<FIoHash> Chunks = ChunkSet.Array();
+		Result.NumChunks = Chunks.Num();
+		Job->NumChunks = Chunks.Num();
+
+		FCriticalSection CorruptChunksLock;
+		std::atomic<int32> NextIndex = 0;
+		std::atomic<int32> NumUnchecked = 0;
+
+		auto CheckChunks = [this, &ProjectId, &OplogId, &Job, &Chunks, &Result, &CorruptChunksLock, &NextIndex, &NumUnchecked]()
+		{
+			FZenScopedRequestPtr Request(&RequestPool);
+
+			for (int32 Index = NextIndex++; Index < Chunks.Num() && !Job->bCancelled; Index = NextIndex++)
+			{
+				const FIoHash& Chunk = Chunks[Index];
+
+				TStringBuilder<128> RequestUri;
+				RequestUri << TEXTVIEW("/prj/") << ProjectId << TEXTVIEW("/oplog/") << OplogId << TEXT('/') << Chunk;
+
+				Request->Reset();
+
+				// Chunks are served decompressed so their data hashes to the attachment hash the op refers to
+				const FZenHttpRequest::Result RequestResult = FZenSnapshotSyncRetry::Perform(*Request.Get(), FZenSnapshotSyncRetry::EMode::Idempotent,
+					[&Request, &RequestUri]() { return Request->PerformBlockingDownload(RequestUri, nullptr, EContentType::Binary); });
+
+				if (RequestResult != FZenHttpRequest::Result::Success || (Request->GetResponseCode() != 200 && Request->GetResponseCode() != 404))
+				{
+					++NumUnchecked;
+				}
+				else if (Request->GetResponseCode() == 404 || FIoHash::HashBuffer(Request->GetResponseBuffer().GetData(), Request->GetResponseBuffer().Num()) != Chunk)
+				{
+					FScopeLock ScopeLock(&CorruptChunksLock);
+					Result.CorruptChunks.Add(LexToString(Chunk));
+				}
+
+				++Job->NumChecked;
+			}
+		};
+
+		// The number of workers bounds the load on Zen server, reads block on HTTP so they stay off task graph workers
+		TArray<TFuture<void>> Helpers;
+		for (int32 Index = 1; Index < FMath::Min(NumWorkers, Chunks.Num()); ++Index)
+		{
+			Helpers.Add(Async(EAsyncExecution::ThreadPool, CheckChunks));
+		}
+
+		CheckChunks();
+
+		for (TFuture<void>& Helper : Helpers)
+		{
+			Helper.Wait();
+		}
+
+		if (NumUnchecked > 0)
+		{
+			UE_LOGFMT(LogZenSnapshotSync, Warning, "Failed to read back {NumUnchecked} of {NumChunks} chunks of oplog '{OplogId}'", NumUnchecked.load(), Chunks.Num(), OplogId);
+		}
+
+		Result.bVerified = NumUnchecked == 0 && !Job->bCancelled;
+	}
+	else
+	{
+		UE_LOGFMT(LogZenSnapshotSync, Warning, "Failed to list ops of oplog '{OplogId}'", OplogId);
+	}
+
+	const EStatus Status = Job->bCancelled ? EStatus::Cancelled : EStatus::Finished;
+
+	{
+		FScopeLock ScopeLock(&Lock);
+
+		Job->Result = Result;
+		Job->bFinished = true;
+	}
+
+	OutResult = MoveTemp(Result);
+	return Status;
+}
+
+FZenSnapshotSyncVerifier::EStatus FZenSnapshotSyncVerifier::GetStatus(FStringView JobId, FZenSnapshotSyncVerification& OutResult, float& OutProgress)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	const double CurrentTime = FPlatformTime::Seconds();
+	for (auto It = Jobs.CreateIterator(); It; ++It)
+	{
+		if (It.Value()->ResultReadTime > 0.0 && CurrentTime - It.Value()->ResultReadTime >= ResultRetention)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	const TSharedRef<FJob>* Job = Jobs.Find(FString(JobId));
+	if (!Job)
+	{
+		return EStatus::None;
+	}
+
+	const int32 NumChunks = (*Job)->NumChunks;
+	OutProgress = NumChunks > 0 ? static_cast<float>((*Job)->NumChecked) / NumChunks : 0.0f;
+
+	if (!(*Job)->bFinished)
+	{
+		return (*Job)->bCancelled ? EStatus::Cancelling : EStatus::Running;
+	}
+
+	if ((*Job)->ResultReadTime == 0.0)
+	{
+		(*Job)->ResultReadTime = CurrentTime;
+	}
+
+	OutResult = (*Job)->Result;
+	return (*Job)->bCancelled ? EStatus::Cancelled : EStatus::Finished;
+}
+
+bool FZenSnapshotSyncVerifier::Cancel(FStringView JobId)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	const TSharedRef<FJob>* Job = Jobs.Find(FString(JobId));
+	if (!Job || (*Job)->bFinished)
+	{
+		return false;
+	}
+
+	(*Job)->bCancelled = true;
+	return true;
+}
+
+void FZenSnapshotSyncVerifier::CancelAll()
+{
+	FScopeLock ScopeLock(&Lock);
+
+	for (TPair<FString, TSharedRef<FJob>>& Pair : Jobs)
+	{
+		Pair.Value->bCancelled = true;
+	}
+}
+
+bool FZenSnapshotSyncVerifier::FetchOps(const FString& ProjectId, const FString& OplogId, FCbObject& OutEntries) const
+{
+	using namespace UE::Zen;
+
+	TStringBuilder<128> RequestUri;
+	RequestUri << TEXTVIEW("/prj/") << ProjectId << TEXTVIEW("/oplog/") << OplogId << TEXTVIEW("/entries");
+
+	FZenScopedRequestPtr Request(&RequestPool);
+
+	const FZenHttpRequest::Result Result = FZenSnapshotSyncRetry::Perform(*Request.Get(), FZenSnapshotSyncRetry::EMode::Idempotent,
+		[&Request, &RequestUri]() { return Request->PerformBlockingDownload(RequestUri, nullptr, EContentType::CbObject); });
+	if (Result != FZenHttpRequest::Result::Success || Request->GetResponseCode() != 200)
+	{
+		return false;
+	}
+
+	OutEntries = FCbObject::Clone(Request->GetResponseAsObject());
+	return true;
+}
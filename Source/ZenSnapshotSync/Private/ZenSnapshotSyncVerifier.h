@@ -0,0 +1,81 @@
+#pragma once
+
+#include <ZenServerHttp.h>
+#include <Containers/Map.h>
+#include <Containers/Set.h>
+#include <HAL/CriticalSection.h>
+#include <IO/IoHash.h>
+#include <Serialization/CompactBinary.h>
+#include <Templates/SharedPointer.h>
+
+#include <atomic>
+
+#include "ZenSnapshotSyncTypes.h"
+
+// Reads back the chunks of the ops an import added or changed and checks them against their hashes
+class FZenSnapshotSyncVerifier
+{
+public:
+	enum class EStatus : uint8
+	{
+		None,
+		Running,
+		Cancelling,
+		Finished,
+		Cancelled,
+	};
+
+	explicit FZenSnapshotSyncVerifier(UE::Zen::FZenHttpRequestPool& InRequestPool);
+
+	// Blocking, called right before importing
+	void RecordBaseline(const FString& ProjectId, const FString& OplogId);
+	bool HasBaseline(const FString& OplogId) const;
+	void DiscardBaseline(const FString& OplogId);
+
+	// Blocking, compares the oplog with its baseline once the import completed without verifying it
+	bool Diff(const FString& ProjectId, const FString& OplogId, FZenSnapshotSyncDiff& OutDiff);
+
+	bool Start(const FString& JobId);
+
+	// Blocking, oplogs without a baseline have all their ops checked
+	EStatus Verify(const FString& JobId, const FString& ProjectId, const FString& OplogId, FZenSnapshotSyncVerification& OutResult, FZenSnapshotSyncDiff& OutDiff);
+
+	// Finished jobs are forgotten a while after their result was first read
+	EStatus GetStatus(FStringView JobId, FZenSnapshotSyncVerification& OutResult, float& OutProgress);
+
+	bool Cancel(FStringView JobId);
+
+	void CancelAll();
+
+private:
+	static constexpr int32 NumWorkers = 8;
+
+	// Long enough for every copy of a handle to be polled once more
+	static constexpr double ResultRetention = 30.0;
+
+	struct FJob
+	{
+		std::atomic<int32> NumChunks = 0;
+		std::atomic<int32> NumChecked = 0;
+		std::atomic<bool> bCancelled = false;
+		bool bFinished = false;
+		double ResultReadTime = 0.0;
+		FZenSnapshotSyncVerification Result;
+	};
+
+	struct FBaseline
+	{
+		TSet<FIoHash> Ops;
+		TSet<FIoHash> Attachments;
+	};
+
+	static FZenSnapshotSyncDiff MakeDiff(const FBaseline& Baseline, const FCbObject& Entries);
+
+	bool FetchOps(const FString& ProjectId, const FString& OplogId, FCbObject& OutEntries) const;
+
+	UE::Zen::FZenHttpRequestPool& RequestPool;
+
+	mutable FCriticalSection Lock;
+	TMap<FString, FBaseline> Baselines;
+	TMap<FString, TSharedRef<FJob>> Jobs;
+};
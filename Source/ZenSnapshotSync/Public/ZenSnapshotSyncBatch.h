@@ -0,0 +1,77 @@
+#pragma once
+
+#include <Async/Future.h>
+#include <Containers/Array.h>
+#include <Delegates/IDelegateInstance.h>
+
+#include "ZenSnapshotSyncTypes.h"
+
+class FZenSnapshotSyncModule;
+
+// Syncs one snapshot per target platform, Tick must be called on the game thread until it returns false
+class FZenSnapshotSyncBatch
+{
+public:
+	enum class EEntryState : uint8
+	{
+		Queued,
+		Requesting,
+		Importing,
+		Complete,
+		Failed,
+	};
+
+	ZENSNAPSHOTSYNC_API FZenSnapshotSyncBatch(FZenSnapshotSyncModule& InModule, TConstArrayView<FZenSnapshotDescriptor> InSnapshotDescriptors, int32 InMaxConcurrentImports = 2, const FZenSnapshotSyncOptions& InOptions = FZenSnapshotSyncOptions());
+	ZENSNAPSHOTSYNC_API ~FZenSnapshotSyncBatch();
+
+	FZenSnapshotSyncBatch(const FZenSnapshotSyncBatch&) = delete;
+	FZenSnapshotSyncBatch& operator=(const FZenSnapshotSyncBatch&) = delete;
+
+	ZENSNAPSHOTSYNC_API bool Tick();
+	ZENSNAPSHOTSYNC_API void Cancel();
+
+	// Imports keep running on Zen server and are recovered on the next start
+	ZENSNAPSHOTSYNC_API void Detach();
+
+	ZENSNAPSHOTSYNC_API bool IsFinished() const;
+	ZENSNAPSHOTSYNC_API int32 GetNumSnapshots() const;
+	ZENSNAPSHOTSYNC_API int32 GetNumComplete() const;
+	ZENSNAPSHOTSYNC_API int32 GetNumFailed() const;
+	ZENSNAPSHOTSYNC_API const FZenSnapshotDescriptor& GetSnapshotDescriptor(int32 Index) const;
+	ZENSNAPSHOTSYNC_API const FZenSnapshotSyncHandle& GetHandle(int32 Index) const;
+	ZENSNAPSHOTSYNC_API EEntryState GetEntryState(int32 Index) const;
+
+	// Progress over the snapshots that did not fail, never goes backwards
+	ZENSNAPSHOTSYNC_API float GetProgress() const;
+	ZENSNAPSHOTSYNC_API double GetEstimatedTimeRemaining() const;
+
+private:
+	struct FEntry
+	{
+		FZenSnapshotDescriptor SnapshotDescriptor;
+		EEntryState State = EEntryState::Queued;
+		TFuture<FZenSnapshotSyncHandle> PendingHandle;
+		FZenSnapshotSyncHandle Handle;
+		FDelegateHandle StatusSubscriptionHandle;
+		double RequestTime = 0.0;
+		float Progress = 0.0f;
+	};
+
+	static constexpr float MaxEstimatedProgress = 0.95f;
+
+	void OnSnapshotSyncStatusChanged(const FZenSnapshotSyncHandle& Handle, int32 Index);
+	void UpdateProgress();
+	int32 GetNumActive() const;
+
+	FZenSnapshotSyncModule& Module;
+	TArray<FEntry> Entries;
+	const int32 MaxConcurrentImports;
+	const FZenSnapshotSyncOptions Options;
+
+	TFuture<bool> PendingProjectSetup;
+	bool bProjectReady = false;
+	bool bCancelled = false;
+	bool bDetached = false;
+	double StartTime = 0.0;
+	float Progress = 0.0f;
+};
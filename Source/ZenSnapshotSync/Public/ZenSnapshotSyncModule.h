@@ -1,44 +1,182 @@
 ﻿#pragma once
 
 #include <ZenServerHttp.h>
+#include <Async/Future.h>
+#include <Containers/Ticker.h>
 #include <Experimental/ZenServerInterface.h>
 #include <Modules/ModuleManager.h>
+#include <Serialization/CompactBinary.h>
+
+#include <atomic>
 
 #include "ZenSnapshotSyncTypes.h"
 
+class FZenSnapshotSyncCancellations;
+class FZenSnapshotSyncDescriptorCache;
+class FZenSnapshotSyncJobMonitor;
+class FZenSnapshotSyncJournal;
+class FZenSnapshotSyncMirrors;
+class FZenSnapshotSyncPrefetcher;
+class FZenSnapshotSyncProjectCache;
+class FZenSnapshotSyncSharedCache;
+class FZenSnapshotSyncSlots;
+class FZenSnapshotSyncTelemetryLog;
+class FZenSnapshotSyncThrottler;
 class FZenSnapshotSyncToolbar;
+class FZenSnapshotSyncVerifier;
+class UObject;
+struct FPropertyChangedEvent;
+struct FZenSnapshotSyncCancellation;
+struct FZenSnapshotSyncFailover;
 
 class FZenSnapshotSyncModule : public IModuleInterface
 {
 public:
 	DECLARE_MULTICAST_DELEGATE_OneParam(FQuerySnapshotsMulticastDelegate, TArray<FZenSnapshotDescriptor>& SnapshotDescriptors);
 	using FQuerySnapshotsDelegate = FQuerySnapshotsMulticastDelegate::FDelegate;
+	DECLARE_DELEGATE_RetVal(TFuture<TArray<FZenSnapshotDescriptor>>, FQuerySnapshotsAsyncDelegate);
+	DECLARE_DELEGATE_RetVal(FString, FQuerySnapshotsVersionDelegate);
+
+	DECLARE_DELEGATE_OneParam(FOnSnapshotSyncStatusChanged, const FZenSnapshotSyncHandle& Handle);
+	DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnSnapshotSyncRecovered, const FString& SnapshotName, const FString& TargetPlatform, const FZenSnapshotSyncHandle& Handle);
+
+	FZenSnapshotSyncModule();
+
+#if WITH_DEV_AUTOMATION_TESTS
+	// Test instance without recovery, prefetching or editor UI
+	FZenSnapshotSyncModule(FStringView ZenUrl, const FString& StateDirectory);
+#endif
+
+	virtual ~FZenSnapshotSyncModule() override;
 
 	virtual void StartupModule() override;
+	virtual void ShutdownModule() override;
 
 	ZENSNAPSHOTSYNC_API static bool ReadSnapshotDescriptorJson(FStringView SnapshotDescriptorJson, TArray<FZenSnapshotDescriptor>& SnapshotDescriptors);
 	ZENSNAPSHOTSYNC_API static bool ReadSnapshotDescriptorFile(const TCHAR* SnapshotDescriptorFilePath, TArray<FZenSnapshotDescriptor>& SnapshotDescriptors);
 
-	ZENSNAPSHOTSYNC_API FZenSnapshotSyncHandle RequestSnapshotSync(const FZenSnapshotDescriptor& SnapshotDescriptor) const;
-	ZENSNAPSHOTSYNC_API FZenSnapshotSyncHandle RequestSnapshotSyncFromFile(FStringView TargetPlatform, FStringView Directory, FStringView FileName) const;
-	ZENSNAPSHOTSYNC_API FZenSnapshotSyncHandle RequestSnapshotSyncFromCloud(FStringView TargetPlatform, FStringView Host, FStringView Namespace, FStringView Bucket, FStringView Key) const;
-	ZENSNAPSHOTSYNC_API FZenSnapshotSyncHandle RequestSnapshotSyncFromZen(FStringView TargetPlatform, FStringView Host, FStringView Project, FStringView Oplog) const;
+	// Synchronous variants block the calling thread until the import is requested, retries included, and fail instead of waiting for a slot on a busy source host
+	ZENSNAPSHOTSYNC_API FZenSnapshotSyncHandle RequestSnapshotSync(const FZenSnapshotDescriptor& SnapshotDescriptor, const FZenSnapshotSyncOptions& Options = FZenSnapshotSyncOptions()) const;
+	ZENSNAPSHOTSYNC_API FZenSnapshotSyncHandle RequestSnapshotSyncFromFile(FStringView TargetPlatform, FStringView Directory, FStringView FileName, const FZenSnapshotSyncOptions& Options = FZenSnapshotSyncOptions()) const;
+	ZENSNAPSHOTSYNC_API FZenSnapshotSyncHandle RequestSnapshotSyncFromCloud(FStringView TargetPlatform, FStringView Host, FStringView Namespace, FStringView Bucket, FStringView Key, const FZenSnapshotSyncOptions& Options = FZenSnapshotSyncOptions()) const;
+	ZENSNAPSHOTSYNC_API FZenSnapshotSyncHandle RequestSnapshotSyncFromZen(FStringView TargetPlatform, FStringView Host, FStringView Project, FStringView Oplog, const FZenSnapshotSyncOptions& Options = FZenSnapshotSyncOptions()) const;
+
+	// Handle is invalid if the import could not be requested, imports over the host limit are queued
+	ZENSNAPSHOTSYNC_API TFuture<FZenSnapshotSyncHandle> RequestSnapshotSyncAsync(const FZenSnapshotDescriptor& SnapshotDescriptor, const FZenSnapshotSyncOptions& Options = FZenSnapshotSyncOptions()) const;
+	ZENSNAPSHOTSYNC_API TFuture<FZenSnapshotSyncHandle> RequestSnapshotSyncFromFileAsync(FStringView TargetPlatform, FStringView Directory, FStringView FileName, const FZenSnapshotSyncOptions& Options = FZenSnapshotSyncOptions()) const;
+	ZENSNAPSHOTSYNC_API TFuture<FZenSnapshotSyncHandle> RequestSnapshotSyncFromCloudAsync(FStringView TargetPlatform, FStringView Host, FStringView Namespace, FStringView Bucket, FStringView Key, const FZenSnapshotSyncOptions& Options = FZenSnapshotSyncOptions()) const;
+	ZENSNAPSHOTSYNC_API TFuture<FZenSnapshotSyncHandle> RequestSnapshotSyncFromZenAsync(FStringView TargetPlatform, FStringView Host, FStringView Project, FStringView Oplog, const FZenSnapshotSyncOptions& Options = FZenSnapshotSyncOptions()) const;
+
+	// Same estimate every import is checked against before it starts
+	ZENSNAPSHOTSYNC_API TFuture<FZenSnapshotSyncEstimate> EstimateSnapshotSyncAsync(const FZenSnapshotDescriptor& SnapshotDescriptor) const;
+
+	ZENSNAPSHOTSYNC_API bool IsSnapshotResident(const FZenSnapshotDescriptor& SnapshotDescriptor) const;
+
+	// Ensures the current project exists on Zen server ahead of issuing several sync requests
+	ZENSNAPSHOTSYNC_API TFuture<bool> EnsureProjectAsync() const;
+
+	// Stays in progress while a completed job is verified or an aborted one fails over to a mirror
 	ZENSNAPSHOTSYNC_API bool QuerySnapshotSyncStatus(FZenSnapshotSyncHandle& Handle) const;
+
+	// At most MaxConcurrentStatusQueries at once, off task graph workers
+	ZENSNAPSHOTSYNC_API int32 QuerySnapshotSyncStatuses(TArrayView<FZenSnapshotSyncHandle> Handles) const;
+
+	// False if Zen server refused, the handle may be dropped right away as the module rolls back the import once the job stops
 	ZENSNAPSHOTSYNC_API bool CancelSnapshotSync(FZenSnapshotSyncHandle& Handle) const;
 
+	// Cancels the job once the pending request created it, shutdown waits for this like for any other request
+	ZENSNAPSHOTSYNC_API TFuture<bool> CancelSnapshotSyncWhenRequested(TFuture<FZenSnapshotSyncHandle>&& PendingHandle) const;
+
+	// Callback runs on the game thread whenever the status changes, until the handle completes or fails
+	ZENSNAPSHOTSYNC_API FDelegateHandle SubscribeSnapshotSyncStatus(const FZenSnapshotSyncHandle& Handle, FOnSnapshotSyncStatusChanged&& Callback);
+	ZENSNAPSHOTSYNC_API void UnsubscribeSnapshotSyncStatus(FDelegateHandle SubscriptionHandle);
+
+	// Broadcast on the game thread for every import reattached or resumed on startup
+	ZENSNAPSHOTSYNC_API FOnSnapshotSyncRecovered& OnSnapshotSyncRecovered();
+
+	// Synchronous callbacks run on the game thread, asynchronous and version callbacks on a background thread
 	ZENSNAPSHOTSYNC_API FDelegateHandle RegisterQuerySnapshotsCallback(FQuerySnapshotsDelegate&& Callback);
+	ZENSNAPSHOTSYNC_API FDelegateHandle RegisterQuerySnapshotsCallback(FStringView ProviderName, FQuerySnapshotsDelegate&& Callback, FQuerySnapshotsVersionDelegate&& VersionCallback);
+	ZENSNAPSHOTSYNC_API FDelegateHandle RegisterQuerySnapshotsAsyncCallback(FStringView ProviderName, FQuerySnapshotsAsyncDelegate&& Callback, FQuerySnapshotsVersionDelegate&& VersionCallback = FQuerySnapshotsVersionDelegate());
+	ZENSNAPSHOTSYNC_API FDelegateHandle RegisterSnapshotDescriptorFile(FStringView SnapshotDescriptorFilePath);
 	ZENSNAPSHOTSYNC_API void UnregisterQuerySnapshotsCallback(FDelegateHandle CallbackHandle);
 
 	ZENSNAPSHOTSYNC_API bool CanQuerySnapshots() const;
+	// Appends the cached descriptors and starts a refresh without waiting for it
 	ZENSNAPSHOTSYNC_API void QuerySnapshots(TArray<FZenSnapshotDescriptor>& SnapshotDescriptors) const;
 
+	ZENSNAPSHOTSYNC_API TSharedRef<const TArray<FZenSnapshotDescriptor>> GetCachedSnapshots() const;
+	ZENSNAPSHOTSYNC_API void RefreshSnapshots() const;
+	ZENSNAPSHOTSYNC_API TArray<FZenSnapshotProviderStats> GetSnapshotProviderStats() const;
+
 private:
+	friend class FZenSnapshotSyncJobMonitor;
+	friend class FZenSnapshotSyncRequest;
+
+	static constexpr double PollFailureTolerance = 30.0;
+	static constexpr int32 MaxConcurrentStatusQueries = 4;
+	static constexpr double CancelConfirmTimeout = 60.0;
+	static constexpr double ShutdownTimeout = 10.0;
+
+	struct FRecoveredSnapshotSync
+	{
+		FString SnapshotName;
+		FString TargetPlatform;
+
+		// Resumed imports wait for their turn with the throttler, failed ones are not broadcast
+		TSharedFuture<FZenSnapshotSyncHandle> Handle;
+	};
+
 	static FUtf8StringView GetResponseBufferAsString(const TArray64<uint8>& ResponseBuffer);
+	static FCbObject MakeImportParams(const FZenSnapshotSource& Source);
+	static FString GetSourceHost(const FZenSnapshotSource& Source);
+	static FString GetSourceHost(const FCbObject& Params);
+
+	void CreateServices(const FString& StateDirectory, const FString& UserStateDirectory);
 
-	FZenSnapshotSyncHandle RequestSnapshotSync(FStringView TargetPlatform, FCbObjectView Params) const;
+	TFuture<FZenSnapshotSyncHandle> RequestSnapshotSyncAsync(FStringView TargetPlatform, FStringView SnapshotName, FStringView ParamsHash, FCbObject Params, FString SourceHost, const FZenSnapshotSyncThrottle& Throttle, FZenSnapshotSyncOptions Options) const;
+	TFuture<FZenSnapshotSyncHandle> RequestSnapshotSyncFromMirrorsAsync(const FZenSnapshotDescriptor& SnapshotDescriptor, const FZenSnapshotSyncOptions& Options) const;
+	bool FailOverSnapshotSync(FZenSnapshotSyncHandle& Handle, FStringView AbortReason) const;
+	void FailOverToNextSource(TSharedRef<FZenSnapshotSyncFailover> Failover, FString AbortedJobId, FZenSnapshotSyncTelemetry AbortedTelemetry, FString AbortReason) const;
+	TFuture<FZenSnapshotSyncHandle> ActivateOplogAsync(FStringView TargetPlatform, FString OplogId, FZenSnapshotSyncHandle Handle) const;
+	TFuture<FZenSnapshotSyncHandle> ActivateSlotAsync(const FZenSnapshotDescriptor& SnapshotDescriptor, const FZenSnapshotSyncOptions& Options, FString OplogId, FString JobId) const;
+	void EvictSnapshotSlots(const FString& TargetPlatform) const;
+	bool ApplySnapshotSyncStatus(FZenSnapshotSyncHandle& Handle, FCbObjectView Response) const;
+	void CompleteSnapshotSync(const FZenSnapshotSyncHandle& Handle) const;
+	void DiffSnapshotSync(FZenSnapshotSyncHandle Handle) const;
+	void VerifySnapshotSync(FZenSnapshotSyncHandle Handle) const;
+	bool SendSnapshotSyncCancellation(const FZenSnapshotSyncHandle& Handle, bool bRetry, bool& bOutRetryable) const;
+	void WatchSnapshotSyncCancellation(const FZenSnapshotSyncHandle& Handle, bool bSendCancellation) const;
+	bool ResendSnapshotSyncCancellation(const FZenSnapshotSyncHandle& Handle) const;
+	void ConfirmSnapshotSyncCancellation(FZenSnapshotSyncHandle& Handle, bool bStopped) const;
+	void RollBackSnapshotSync(FZenSnapshotSyncCancellation&& Cancellation) const;
+	TArray<FRecoveredSnapshotSync> RecoverSnapshotSyncs() const;
+	bool DispatchRecoveredSnapshotSyncs(float DeltaTime);
+	void OnSettingsChanged(UObject* Settings, FPropertyChangedEvent& PropertyChangedEvent);
 
 	UE::Zen::FScopeZenService ZenService;
 	TUniquePtr<UE::Zen::FZenHttpRequestPool> RequestPool;
+	TUniquePtr<FZenSnapshotSyncJobMonitor> JobMonitor;
+	TUniquePtr<FZenSnapshotSyncProjectCache> ProjectCache;
+	TUniquePtr<FZenSnapshotSyncDescriptorCache> DescriptorCache;
+	TUniquePtr<FZenSnapshotSyncThrottler> Throttler;
+	TUniquePtr<FZenSnapshotSyncMirrors> Mirrors;
+	TUniquePtr<FZenSnapshotSyncPrefetcher> Prefetcher;
+	TUniquePtr<FZenSnapshotSyncJournal> Journal;
+	TUniquePtr<FZenSnapshotSyncSlots> Slots;
+	TUniquePtr<FZenSnapshotSyncSharedCache> SharedCache;
+	TUniquePtr<FZenSnapshotSyncCancellations> Cancellations;
+	TUniquePtr<FZenSnapshotSyncVerifier> Verifier;
+	TUniquePtr<FZenSnapshotSyncTelemetryLog> TelemetryLog;
+	TFuture<TArray<FRecoveredSnapshotSync>> PendingRecovery;
+	TArray<FRecoveredSnapshotSync> PendingRecoveredSnapshotSyncs;
+	FTSTicker::FDelegateHandle RecoveryTickHandle;
+	FDelegateHandle SettingsChangedHandle;
+	FOnSnapshotSyncRecovered SnapshotSyncRecoveredDelegate;
 	TSharedPtr<FZenSnapshotSyncToolbar> Toolbar = nullptr;
-	FQuerySnapshotsMulticastDelegate OnQuerySnapshots;
+
+	// Empty unless Zen server was launched locally
+	FString ZenDataPath;
+
+	mutable std::atomic<int32> NumPendingRequests = 0;
 };
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <Engine/DeveloperSettings.h>
+
+#include "ZenSnapshotSyncSettings.generated.h"
+
+UCLASS(config = EditorPerProjectUserSettings, meta = (DisplayName = "Zen Snapshot Sync"))
+class ZENSNAPSHOTSYNC_API UZenSnapshotSyncSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	UZenSnapshotSyncSettings();
+
+	// Listed under Editor Preferences
+	virtual FName GetContainerName() const override;
+
+	// Imports the latest snapshot of tracked platforms into a staging oplog while the editor is idle
+	UPROPERTY(config, EditAnywhere, Category = "Prefetch")
+	bool bEnablePrefetch = false;
+
+	// When empty every platform that has been synced before is tracked
+	UPROPERTY(config, EditAnywhere, Category = "Prefetch", meta = (EditCondition = "bEnablePrefetch"))
+	TArray<FString> PrefetchPlatforms;
+
+	// Seconds without user input before a prefetch is started
+	UPROPERTY(config, EditAnywhere, Category = "Prefetch", meta = (EditCondition = "bEnablePrefetch", ClampMin = "0", Units = "s"))
+	float PrefetchIdleTime = 120.0f;
+
+	// Snapshots kept imported per platform in oplogs of their own, 1 imports every snapshot into the platform's oplog
+	UPROPERTY(config, EditAnywhere, Category = "Snapshot Slots", meta = (ClampMin = "1"))
+	int32 MaxResidentSnapshots = 1;
+
+	// Imports snapshots another project on the same Zen server already holds instead of downloading them again
+	UPROPERTY(config, EditAnywhere, Category = "Sharing")
+	bool bShareSnapshotsAcrossProjects = true;
+};
+
+UCLASS(config = Editor, defaultconfig, meta = (DisplayName = "Zen Snapshot Sync"))
+class ZENSNAPSHOTSYNC_API UZenSnapshotSyncProjectSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	UZenSnapshotSyncProjectSettings();
+
+	// Imports allowed to run against the same source host at once, 0 means unlimited
+	UPROPERTY(config, EditAnywhere, Category = "Throttling", meta = (ClampMin = "0"))
+	int32 MaxConcurrentImportsPerHost = 2;
+
+	// Only possible when Zen server runs locally
+	UPROPERTY(config, EditAnywhere, Category = "Preflight")
+	bool bCheckFreeSpace = true;
+
+	UPROPERTY(config, EditAnywhere, Category = "Preflight", meta = (EditCondition = "bCheckFreeSpace"))
+	bool bRefuseImportWhenLowOnSpace = false;
+
+	// Kept free on top of the snapshot size
+	UPROPERTY(config, EditAnywhere, Category = "Preflight", meta = (EditCondition = "bCheckFreeSpace", ClampMin = "0", Units = "MB"))
+	int32 FreeSpaceMargin = 1024;
+
+	// Reads back the chunks an import wrote and only reports it complete once every chunk matched its hash
+	UPROPERTY(config, EditAnywhere, Category = "Verification")
+	bool bVerifyImports = false;
+};
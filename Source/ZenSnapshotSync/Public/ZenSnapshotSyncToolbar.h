@@ -1,5 +1,6 @@
 #pragma once
 
+#include <Async/Future.h>
 #include <Containers/Array.h>
 #include <Containers/Map.h>
 #include <Containers/Ticker.h>
@@ -7,12 +8,15 @@
 #include "ZenSnapshotSyncTypes.h"
 
 class FAsyncTaskNotification;
+class FZenSnapshotSyncBatch;
 class FZenSnapshotSyncModule;
 class UToolMenu;
 
 struct FZenSnapshotSyncTask
 {
+	TFuture<FZenSnapshotSyncHandle> PendingHandle;
 	FZenSnapshotSyncHandle Handle;
+	FDelegateHandle StatusSubscriptionHandle;
 	TUniquePtr<FAsyncTaskNotification> Notification;
 };
 
@@ -31,11 +35,23 @@ private:
 	bool CanSyncSnapshot(const FZenSnapshotDescriptor* SnapshotDescriptor) const;
 	void SyncSnapshot(const FZenSnapshotDescriptor* SnapshotDescriptor);
 
+	bool CanSyncAllSnapshots() const;
+	void SyncAllSnapshots();
+	void TickSnapshotSyncBatch();
+
+	void StartTicking();
 	bool TickSnapshotSyncTasks(float DeltaTime);
-	void CancelSnapshotSyncTasks();
+	void OnSnapshotSyncStatusChanged(const FZenSnapshotSyncHandle& Handle, FString TargetPlatform);
+	void OnSnapshotSyncRecovered(const FString& SnapshotName, const FString& TargetPlatform, const FZenSnapshotSyncHandle& Handle);
+	void CompleteSnapshotSyncTask(FZenSnapshotSyncTask& Task);
+
+	static FText MakeProgressText(const FZenSnapshotSyncHandle& Handle);
+	void DetachSnapshotSyncTasks();
 
 	FZenSnapshotSyncModule* SnapshotSyncModule = nullptr;
-	TArray<FZenSnapshotDescriptor> LatestSnapshotDescriptors;
+	TSharedPtr<const TArray<FZenSnapshotDescriptor>> LatestSnapshotDescriptors;
 	TMap<FString, FZenSnapshotSyncTask> SnapshotSyncTasks;
+	TUniquePtr<FZenSnapshotSyncBatch> SnapshotSyncBatch;
+	TUniquePtr<FAsyncTaskNotification> SnapshotSyncBatchNotification;
 	FTSTicker::FDelegateHandle SnapshotSyncTickHandle;
 };
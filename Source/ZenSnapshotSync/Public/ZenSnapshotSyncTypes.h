@@ -1,38 +1,262 @@
 #pragma once
 
 #include <Containers/UnrealString.h>
+#include <Misc/DateTime.h>
+#include <Misc/TVariant.h>
+#include <Serialization/CompactBinary.h>
 #include <Templates/SharedPointer.h>
 
-class FJsonObject;
+enum class EZenSnapshotSyncMode : uint8
+{
+	// Keeps the local oplog, Zen server skips attachments already in its store
+	Default,
+	// Clears the local oplog and transfers all attachments again
+	Full,
+};
+
+enum class EZenSnapshotSyncPriority : uint8
+{
+	// Uses the priority of the snapshot descriptor, normal if it has none
+	Default,
+	Low,
+	Normal,
+	High,
+};
+
+struct FZenSnapshotSyncThrottle
+{
+	EZenSnapshotSyncPriority Priority = EZenSnapshotSyncPriority::Default;
+
+	// 0 uses the project setting
+	int32 MaxConcurrentImports = 0;
+};
+
+struct FZenSnapshotSyncOptions
+{
+	EZenSnapshotSyncMode Mode = EZenSnapshotSyncMode::Default;
+
+	// Oplog to import into, defaults to the target platform
+	FString OplogId;
+
+	// Staging imports leave the active oplog untouched
+	bool bActivate = true;
+
+	EZenSnapshotSyncPriority Priority = EZenSnapshotSyncPriority::Default;
+	bool bWaitForSlot = true;
+};
+
+enum class EZenSnapshotSourceType : uint8
+{
+	Unknown,
+	File,
+	Cloud,
+	Zen,
+};
+
+struct FZenSnapshotFileSource
+{
+	FString Directory;
+	FString FileName;
+};
+
+struct FZenSnapshotCloudSource
+{
+	FString Host;
+	FString Namespace;
+	FString Bucket;
+	FString Key;
+};
+
+struct FZenSnapshotZenSource
+{
+	FString Host;
+	FString ProjectId;
+	FString OplogId;
+};
+
+using FZenSnapshotSource = TVariant<FEmptyVariantState, FZenSnapshotFileSource, FZenSnapshotCloudSource, FZenSnapshotZenSource>;
 
 struct FZenSnapshotDescriptor
 {
 	ZENSNAPSHOTSYNC_API const FString& GetName() const;
 	ZENSNAPSHOTSYNC_API const FString& GetTargetPlatform() const;
+	ZENSNAPSHOTSYNC_API EZenSnapshotSourceType GetSourceType() const;
+	ZENSNAPSHOTSYNC_API const FZenSnapshotSource& GetSource() const;
+	ZENSNAPSHOTSYNC_API const FZenSnapshotSyncThrottle& GetThrottle() const;
+	ZENSNAPSHOTSYNC_API const TArray<FZenSnapshotSource>& GetMirrors() const;
 
 private:
 	friend class FZenSnapshotSyncModule;
 
 	FString Name;
 	FString TargetPlatform;
-	TSharedPtr<class FJsonObject> Object = nullptr;
+	FZenSnapshotSource Source;
+
+	// Imports start from the best scoring source and fail over to the others
+	TArray<FZenSnapshotSource> Mirrors;
+	FZenSnapshotSyncThrottle Throttle;
+
+	// Serialized once when the descriptor is read
+	FCbObject ImportParams;
+};
+
+struct FZenSnapshotProviderStats
+{
+	FString Name;
+	double LastRefreshTime = 0.0;
+	bool bLastRefreshChanged = false;
+	bool bLastRefreshTimedOut = false;
+	int32 NumSnapshots = 0;
+};
+
+struct FZenSnapshotSyncEstimate
+{
+	// Upper bound of what is transferred, negative if the source does not report it
+	int64 SnapshotBytes = -1;
+
+	// Negative unless Zen server was launched locally
+	int64 FreeBytes = -1;
+
+	double EstimatedSeconds = -1.0;
+
+	// Unknown sizes are assumed to fit
+	ZENSNAPSHOTSYNC_API bool HasEnoughSpace(int64 MarginBytes = 0) const;
+};
+
+struct FZenSnapshotSyncPhase
+{
+	FString Name;
+	double Duration = 0.0;
+
+	// 0 if Zen server reported no counts
+	uint64 NumEntries = 0;
+
+	ZENSNAPSHOTSYNC_API double GetEntriesPerSecond() const;
+};
+
+// What an import into an existing oplog left as it was, compared against the ops listed right before it started
+struct FZenSnapshotSyncDiff
+{
+	// False if the oplog was new, imported in full or could not be listed
+	bool bKnown = false;
+
+	int32 NumOps = 0;
+	int32 NumSkippedOps = 0;
+	int32 NumAttachments = 0;
+	int32 NumSkippedAttachments = 0;
+
+	// Compact binary size of the skipped ops, Zen server does not list attachment sizes
+	int64 SkippedOpBytes = 0;
+};
+
+// Wall time of each request step and job op in the order they ran, job ops only as precise as the poll interval
+struct FZenSnapshotSyncTelemetry
+{
+	FString TargetPlatform;
+	FString OplogId;
+
+	FString Source;
+	FDateTime RequestTime;
+	FZenSnapshotSyncEstimate Estimate;
+	FZenSnapshotSyncDiff Diff;
+	TArray<FZenSnapshotSyncPhase> Phases;
+
+	uint64 CurrentOpTotalCount = 0;
+	uint64 CurrentOpRemainingCount = 0;
+
+	ZENSNAPSHOTSYNC_API double GetTotalDuration() const;
+	ZENSNAPSHOTSYNC_API uint64 GetTotalEntries() const;
+
+private:
+	friend class FZenSnapshotSyncModule;
+	friend class FZenSnapshotSyncRequest;
+
+	// Merges repeated phases, e.g. a step retried after revalidation
+	void AddPhase(FStringView Name, double Duration, uint64 NumEntries = 0);
+
+	void EndOperation(FStringView Name, double CurrentTime);
+
+	double OperationStartTime = 0.0;
 };
 
+// Rates of the current job op over the status samples of the last WindowDuration seconds
+struct FZenSnapshotSyncRateEstimator
+{
+	ZENSNAPSHOTSYNC_API double GetProgressPerSecond() const;
+	ZENSNAPSHOTSYNC_API double GetEntriesPerSecond() const;
+
+	// Negative while unknown
+	ZENSNAPSHOTSYNC_API double GetEstimatedTimeRemaining() const;
+
+private:
+	friend class FZenSnapshotSyncModule;
+
+	static constexpr int32 MaxSamples = 16;
+	static constexpr double WindowDuration = 30.0;
+	static constexpr double Smoothing = 0.3;
+
+	struct FSample
+	{
+		double Time;
+		float Progress;
+		uint64 NumEntries;
+	};
+
+	void Reset();
+	void AddSample(double Time, float Progress, uint64 NumEntries);
+
+	TArray<FSample, TInlineAllocator<MaxSamples>> Samples;
+	double ProgressPerSecond = 0.0;
+	double EntriesPerSecond = 0.0;
+	double EstimatedTimeRemaining = -1.0;
+};
+
+struct FZenSnapshotSyncVerification
+{
+	// False if verification was disabled, cancelled or could not read back every chunk
+	bool bVerified = false;
+	int32 NumOps = 0;
+	int32 NumChunks = 0;
+	TArray<FString> CorruptChunks;
+
+	ZENSNAPSHOTSYNC_API bool HasPassed() const;
+};
+
+struct FZenSnapshotSyncFailover;
+
 struct FZenSnapshotSyncHandle
 {
 	ZENSNAPSHOTSYNC_API bool IsValid() const;
 	ZENSNAPSHOTSYNC_API bool IsComplete() const;
 	ZENSNAPSHOTSYNC_API bool IsError() const;
+
+	ZENSNAPSHOTSYNC_API bool IsCancelling() const;
 	ZENSNAPSHOTSYNC_API const FString& GetErrorMessage() const;
 	ZENSNAPSHOTSYNC_API const FString& GetState() const;
 	ZENSNAPSHOTSYNC_API float GetStateProgress() const;
+	ZENSNAPSHOTSYNC_API const FZenSnapshotSyncTelemetry& GetTelemetry() const;
+	ZENSNAPSHOTSYNC_API const FZenSnapshotSyncRateEstimator& GetRateEstimator() const;
+	ZENSNAPSHOTSYNC_API const FZenSnapshotSyncVerification& GetVerification() const;
 
 private:
 	friend class FZenSnapshotSyncModule;
+	friend class FZenSnapshotSyncRequest;
 
 	FString JobId;
 	bool bComplete = false;
 	FString ErrorMessage;
 	FString State;
 	float StateProgress = 0.0f;
+	FZenSnapshotSyncTelemetry Telemetry;
+	FZenSnapshotSyncRateEstimator RateEstimator;
+	FZenSnapshotSyncVerification Verification;
+
+	double FirstFailedPollTime = 0.0;
+	double CancelTime = 0.0;
+
+	// Cancelled imports are rolled back to these
+	FString PreviousOplogId;
+	bool bCreatedOplog = false;
+
+	TSharedPtr<FZenSnapshotSyncFailover> Failover;
 };
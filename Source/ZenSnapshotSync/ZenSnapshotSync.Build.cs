@@ -9,12 +9,16 @@ public class ZenSnapshotSync : ModuleRules
 		PublicDependencyModuleNames.AddRange(new[]
 		{
 			"Core",
+			"CoreUObject",
+			"DeveloperSettings",
 			"Json",
 			"Zen",
 		});
 
 		PrivateDependencyModuleNames.AddRange(new[]
 		{
+			"Engine",
+			"HTTPServer",
 			"Slate",
 			"SlateCore",
 			"TargetPlatform",